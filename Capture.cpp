@@ -0,0 +1,297 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - indexed chunked capture files
+//  18.10.2026 - compressed chunks of any size
+//  19.10.2026 - the index is checked against the file, rebuilt when damaged
+//==============================================================================
+
+#include "SoapyFobosCapture.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(SoapyFobosCaptureHeader) <= FOBOS_CAPTURE_ALIGN, "capture header layout");
+
+// compressed chunks are padded to whole cache lines only
+#define FOBOS_CAPTURE_Z_ALIGN 64
+
+SoapyFobosCaptureWriter * soapy_fobos_capture_create(const std::string &path, int format, size_t chunk_len,
+        double sample_rate, long long epoch_ns, const char *serial)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+    SoapyFobosCaptureWriter *writer = new SoapyFobosCaptureWriter();
+    writer->path = path;
+    writer->file = file;
+    SoapyFobosCaptureHeader &header = writer->header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FOBOS_CAPTURE_MAGIC;
+    header.version = FOBOS_CAPTURE_VERSION;
+    header.format = format;
+    header.chunk_len = chunk_len;
+    size_t used = 0;
+    if (format != FOBOS_CAPTURE_CS12Z)
+    {
+        used = sizeof(SoapyFobosCaptureChunk) + chunk_len * fobos_ring_sample_bytes(format);
+        header.chunk_bytes = (used + FOBOS_CAPTURE_ALIGN - 1) / FOBOS_CAPTURE_ALIGN * FOBOS_CAPTURE_ALIGN;
+    }
+    header.sample_rate = sample_rate;
+    header.epoch_ns = epoch_ns;
+    strncpy(header.serial, serial, sizeof(header.serial) - 1);
+    // chunks_count 0 until closed
+    std::vector<uint8_t> page(FOBOS_CAPTURE_ALIGN, 0);
+    memcpy(page.data(), &header, sizeof(header));
+    if (fwrite(page.data(), 1, page.size(), file) != page.size())
+    {
+        int err = errno;
+        fclose(file);
+        delete writer;
+        throw std::runtime_error(path + ": " + strerror(err));
+    }
+    writer->offset = FOBOS_CAPTURE_ALIGN;
+    if (header.chunk_bytes != 0)
+    {
+        writer->padding.resize(header.chunk_bytes - used, 0);
+    }
+    else
+    {
+        writer->padding.resize(FOBOS_CAPTURE_Z_ALIGN, 0);
+    }
+    return writer;
+}
+
+bool soapy_fobos_capture_write(SoapyFobosCaptureWriter *writer, SoapyFobosCaptureChunk &chunk, const void *samples, size_t bytes)
+{
+    if (!writer->error.empty())
+    {
+        return false;
+    }
+    const SoapyFobosCaptureHeader &header = writer->header;
+    chunk.magic = FOBOS_CAPTURE_CHUNK_MAGIC;
+    chunk.seq = writer->index.size();
+    chunk.bytes = bytes;
+    memset(chunk.reserved, 0, sizeof(chunk.reserved));
+    size_t padding = writer->padding.size();
+    if (header.chunk_bytes == 0)
+    {
+        padding = (FOBOS_CAPTURE_Z_ALIGN - bytes % FOBOS_CAPTURE_Z_ALIGN) % FOBOS_CAPTURE_Z_ALIGN;
+    }
+    if ((fwrite(&chunk, 1, sizeof(chunk), writer->file) != sizeof(chunk)) ||
+        (fwrite(samples, 1, bytes, writer->file) != bytes) ||
+        (fwrite(writer->padding.data(), 1, padding, writer->file) != padding))
+    {
+        writer->error = writer->path + ": " + strerror(errno);
+        return false;
+    }
+    SoapyFobosCaptureIndex entry;
+    entry.counter = chunk.counter;
+    entry.offset = writer->offset;
+    writer->offset += sizeof(chunk) + bytes + padding;
+    entry.power = chunk.power;
+    entry.peak = chunk.peak;
+    writer->index.push_back(entry);
+    return true;
+}
+
+bool soapy_fobos_capture_finish(SoapyFobosCaptureWriter *writer, std::string &error)
+{
+    SoapyFobosCaptureHeader &header = writer->header;
+    FILE *file = writer->file;
+    bool ok = writer->error.empty();
+    if (ok)
+    {
+        size_t count = writer->index.size();
+        ok = (fwrite(writer->index.data(), sizeof(SoapyFobosCaptureIndex), count, file) == count);
+        // the index is complete before the header points to it
+        ok = ok && (fflush(file) == 0);
+        header.chunks_count = count;
+        header.index_offset = writer->offset;
+        ok = ok && (fseek(file, 0, SEEK_SET) == 0);
+        ok = ok && (fwrite(&header, 1, sizeof(header), file) == sizeof(header));
+        if (!ok)
+        {
+            writer->error = writer->path + ": " + strerror(errno);
+        }
+    }
+    if ((fclose(file) != 0) && ok)
+    {
+        writer->error = writer->path + ": " + strerror(errno);
+        ok = false;
+    }
+    error = writer->error;
+    delete writer;
+    return ok;
+}
+//==============================================================================
+
+#ifndef _WIN32
+
+// The index written at close fits the file, every chunk it points to lies
+// before it and the counters do not go back. Nothing is multiplied, the
+// header may hold anything.
+static bool index_valid(const SoapyFobosCaptureHeader *header, const void *base, size_t size)
+{
+    bool fixed = (header->format <= FOBOS_RING_CS12);
+    uint64_t index_offset = header->index_offset;
+    if ((header->chunks_count == 0) || (index_offset < FOBOS_CAPTURE_ALIGN) || (index_offset > size) ||
+        (header->chunks_count > (size - index_offset) / sizeof(SoapyFobosCaptureIndex)))
+    {
+        return false;
+    }
+    const SoapyFobosCaptureIndex *index = (const SoapyFobosCaptureIndex *)((const uint8_t *)base + index_offset);
+    for (uint64_t i = 0; i < header->chunks_count; i++)
+    {
+        uint64_t offset = index[i].offset;
+        if ((offset < FOBOS_CAPTURE_ALIGN) || (offset > index_offset) ||
+            (index_offset - offset < sizeof(SoapyFobosCaptureChunk)))
+        {
+            return false;
+        }
+        const SoapyFobosCaptureChunk *chunk = (const SoapyFobosCaptureChunk *)((const uint8_t *)base + offset);
+        // chunk_bytes has the chunk header in it
+        uint64_t bytes = fixed ? header->chunk_bytes - sizeof(SoapyFobosCaptureChunk) : chunk->bytes;
+        if ((chunk->magic != FOBOS_CAPTURE_CHUNK_MAGIC) ||
+            (bytes > index_offset - offset - sizeof(SoapyFobosCaptureChunk)) ||
+            ((i > 0) && (index[i].counter < index[i - 1].counter)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+SoapyFobosCapture * soapy_fobos_capture_open(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < FOBOS_CAPTURE_ALIGN))
+    {
+        close(fd);
+        throw std::runtime_error(path + ": not a capture file");
+    }
+    size_t size = st.st_size;
+    void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error(path + ": mmap failed, " + strerror(errno));
+    }
+    const SoapyFobosCaptureHeader *header = (const SoapyFobosCaptureHeader *)base;
+    bool fixed = (header->format <= FOBOS_RING_CS12);
+    if ((header->magic != FOBOS_CAPTURE_MAGIC) || (header->version != FOBOS_CAPTURE_VERSION) ||
+        (!fixed && (header->format != FOBOS_CAPTURE_CS12Z)) || (header->chunk_len == 0) ||
+        (fixed && (header->chunk_bytes < sizeof(SoapyFobosCaptureChunk) + header->chunk_len * fobos_ring_sample_bytes(header->format))))
+    {
+        munmap(base, size);
+        throw std::runtime_error(path + ": not a capture file");
+    }
+    // the chunks are read at random, one of them at a time
+    madvise(base, size, MADV_RANDOM);
+    SoapyFobosCapture *capture = new SoapyFobosCapture();
+    capture->path = path;
+    capture->base = base;
+    capture->size = size;
+    capture->header = header;
+    capture->chunks_count = header->chunks_count;
+    if (index_valid(header, base, size))
+    {
+        capture->index = (const SoapyFobosCaptureIndex *)((const uint8_t *)base + header->index_offset);
+        return capture;
+    }
+    // not closed by the recorder, or a damaged index: the chunks written completely, in order
+    uint64_t offset = FOBOS_CAPTURE_ALIGN;
+    for (uint64_t i = 0; offset + sizeof(SoapyFobosCaptureChunk) <= size; i++)
+    {
+        const SoapyFobosCaptureChunk *chunk = (const SoapyFobosCaptureChunk *)((const uint8_t *)base + offset);
+        uint64_t bytes = header->chunk_bytes;
+        if (!fixed)
+        {
+            bytes = sizeof(SoapyFobosCaptureChunk) + ((uint64_t)chunk->bytes + FOBOS_CAPTURE_Z_ALIGN - 1) / FOBOS_CAPTURE_Z_ALIGN * FOBOS_CAPTURE_Z_ALIGN;
+        }
+        if ((chunk->magic != FOBOS_CAPTURE_CHUNK_MAGIC) || (chunk->seq != i) || (bytes > size - offset))
+        {
+            break;
+        }
+        SoapyFobosCaptureIndex entry;
+        entry.counter = chunk->counter;
+        entry.offset = offset;
+        entry.power = chunk->power;
+        entry.peak = chunk->peak;
+        capture->rebuilt.push_back(entry);
+        offset += bytes;
+    }
+    capture->chunks_count = capture->rebuilt.size();
+    capture->index = capture->rebuilt.data();
+    SoapySDR_logf(SOAPY_SDR_WARNING, "%s %s, index rebuilt from %llu chunks", path.c_str(),
+            (header->chunks_count == 0) ? "has not been closed" : "has a damaged index",
+            (unsigned long long)capture->chunks_count);
+    return capture;
+}
+
+void soapy_fobos_capture_close(SoapyFobosCapture *capture)
+{
+    if (capture == nullptr)
+    {
+        return;
+    }
+    munmap(capture->base, capture->size);
+    delete capture;
+}
+
+#else
+
+SoapyFobosCapture * soapy_fobos_capture_open(const std::string &path)
+{
+    throw std::runtime_error(path + ": replay is not supported on this platform");
+}
+
+void soapy_fobos_capture_close(SoapyFobosCapture *capture)
+{
+    delete capture;
+}
+
+#endif
+
+uint64_t soapy_fobos_capture_find(const SoapyFobosCapture *capture, long long counter)
+{
+    uint64_t count = capture->chunks_count;
+    if (count == 0)
+    {
+        return 0;
+    }
+    long long chunk_len = capture->header->chunk_len;
+    const SoapyFobosCaptureIndex *index = capture->index;
+    // where the chunk is without gaps
+    long long guess = (counter - index[0].counter) / chunk_len;
+    if ((guess >= 0) && ((uint64_t)guess < count) && (index[guess].counter <= counter) &&
+        (counter < index[guess].counter + chunk_len))
+    {
+        return guess;
+    }
+    // the counters only grow, the first chunk starting after counter
+    const SoapyFobosCaptureIndex *next = std::upper_bound(index, index + count, counter,
+            [](long long value, const SoapyFobosCaptureIndex &entry) { return value < entry.counter; });
+    uint64_t i = next - index;
+    if ((i > 0) && (counter < index[i - 1].counter + chunk_len))
+    {
+        return i - 1;
+    }
+    return i;
+}
+//==============================================================================
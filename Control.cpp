@@ -0,0 +1,382 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - non-blocking coalescing control queue
+//  18.10.2026 - software AGC
+//  18.10.2026 - sample rate requests, applied between transfers while streaming
+//  19.10.2026 - control thread while streaming, no control transfers in the transfer callback
+//==============================================================================
+
+#include "SoapyFobosSDR.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <algorithm>
+#include <cmath>
+
+/*******************************************************************
+ * Control plane
+ * While streaming, setFrequency(), setGain() and writeSetting() only
+ * store the request and return. The control thread applies the latest
+ * requests, so a flood of gain changes costs one control transfer per
+ * apply at most. The library control calls are synchronous USB
+ * transfers, they never run in the transfer callback. A sample rate
+ * change is applied the same way, the streaming thread marks the slots
+ * of the new rate with the next transfer, see rate_boundary().
+ ******************************************************************/
+
+int SoapyFobosSDR::control_submit(const SoapyFobosControl &request)
+{
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        if (request.mask & CTRL_FREQUENCY)
+        {
+            _ctrl.frequency = request.frequency;
+        }
+        if (request.mask & CTRL_LNA_GAIN)
+        {
+            _ctrl.lna_idx = request.lna_idx;
+        }
+        if (request.mask & CTRL_VGA_GAIN)
+        {
+            _ctrl.vga_idx = request.vga_idx;
+        }
+        if (request.mask & CTRL_DIRECT_SAMPLING)
+        {
+            _ctrl.direct_sampling = request.direct_sampling;
+        }
+        if (request.mask & CTRL_CLOCK_SOURCE)
+        {
+            _ctrl.clock_source = request.clock_source;
+        }
+        if (request.mask & CTRL_SAMPLE_RATE)
+        {
+            _ctrl.sample_rate = request.sample_rate;
+            _ctrl.native_rate = request.native_rate;
+        }
+        _ctrl.mask |= request.mask;
+        _ctrl_pending = true;
+    }
+    if (_ctrl_async)
+    {
+        // the control thread picks it up
+        _ctrl_cond.notify_one();
+        return 0;
+    }
+    return control_service();
+}
+
+// Applies the requests while streaming, from rx_async_thread_loop() start to end
+void SoapyFobosSDR::control_thread_loop(void)
+{
+    std::unique_lock<std::mutex> lock(_ctrl_mutex);
+    while (!_ctrl_stop)
+    {
+        if (!_ctrl_pending)
+        {
+            _ctrl_cond.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        control_service();
+        lock.lock();
+    }
+}
+
+int SoapyFobosSDR::control_service(void)
+{
+    std::lock_guard<std::mutex> apply_lock(_ctrl_apply_mutex);
+    SoapyFobosControl request;
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        request = _ctrl;
+        _ctrl.mask = 0;
+        _ctrl_pending = false;
+    }
+    if (request.mask == 0)
+    {
+        return 0;
+    }
+    return control_apply(request);
+}
+
+// Must be called with _ctrl_apply_mutex locked.
+// Requests equal to what the hardware already has are skipped.
+int SoapyFobosSDR::control_apply(SoapyFobosControl &request)
+{
+    int result = 0;
+    int r;
+    bool gain_changed = false;
+    if ((request.mask & CTRL_FREQUENCY) &&
+        !((_ctrl_applied.mask & CTRL_FREQUENCY) && (_ctrl_applied.frequency == request.frequency)))
+    {
+        double actual = request.frequency;
+        r = -1;
+        if (_dev_stock)
+        {
+            r = fobos_rx_set_frequency(_dev_stock, request.frequency, &actual);
+        }
+        else if (_dev_agile)
+        {
+            r = fobos_sdr_set_frequency(_dev_agile, request.frequency);
+        }
+        if (r == 0)
+        {
+            _ctrl_applied.frequency = request.frequency;
+            _ctrl_applied.mask |= CTRL_FREQUENCY;
+            {
+                std::lock_guard<std::mutex> lock(_ctrl_mutex);
+                _center_frequency = actual;
+            }
+            // the correction depends on the LO frequency
+            _nco_changed = true;
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set frequency %f failed with code %d", request.frequency, r);
+            _ctrl_applied.mask &= ~CTRL_FREQUENCY;
+            result = r;
+        }
+    }
+    if ((request.mask & CTRL_LNA_GAIN) &&
+        !((_ctrl_applied.mask & CTRL_LNA_GAIN) && (_ctrl_applied.lna_idx == request.lna_idx)))
+    {
+        r = -1;
+        if (_dev_stock)
+        {
+            r = fobos_rx_set_lna_gain(_dev_stock, request.lna_idx);
+        }
+        else if (_dev_agile)
+        {
+            r = fobos_sdr_set_lna_gain(_dev_agile, request.lna_idx);
+        }
+        if (r == 0)
+        {
+            _ctrl_applied.lna_idx = request.lna_idx;
+            _ctrl_applied.mask |= CTRL_LNA_GAIN;
+            gain_changed = true;
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set LNA gain #%d failed with code %d", request.lna_idx, r);
+            _ctrl_applied.mask &= ~CTRL_LNA_GAIN;
+            result = r;
+        }
+    }
+    if ((request.mask & CTRL_VGA_GAIN) &&
+        !((_ctrl_applied.mask & CTRL_VGA_GAIN) && (_ctrl_applied.vga_idx == request.vga_idx)))
+    {
+        r = -1;
+        if (_dev_stock)
+        {
+            r = fobos_rx_set_vga_gain(_dev_stock, request.vga_idx);
+        }
+        else if (_dev_agile)
+        {
+            r = fobos_sdr_set_vga_gain(_dev_agile, request.vga_idx);
+        }
+        if (r == 0)
+        {
+            _ctrl_applied.vga_idx = request.vga_idx;
+            _ctrl_applied.mask |= CTRL_VGA_GAIN;
+            gain_changed = true;
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set VGA gain #%d failed with code %d", request.vga_idx, r);
+            _ctrl_applied.mask &= ~CTRL_VGA_GAIN;
+            result = r;
+        }
+    }
+    if ((request.mask & CTRL_DIRECT_SAMPLING) &&
+        !((_ctrl_applied.mask & CTRL_DIRECT_SAMPLING) && (_ctrl_applied.direct_sampling == request.direct_sampling)))
+    {
+        r = -1;
+        if (_dev_stock)
+        {
+            r = fobos_rx_set_direct_sampling(_dev_stock, request.direct_sampling);
+        }
+        else if (_dev_agile)
+        {
+            r = fobos_sdr_set_direct_sampling(_dev_agile, request.direct_sampling);
+        }
+        if (r == 0)
+        {
+            _ctrl_applied.direct_sampling = request.direct_sampling;
+            _ctrl_applied.mask |= CTRL_DIRECT_SAMPLING;
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set direct_samp failed with code %d", r);
+            _ctrl_applied.mask &= ~CTRL_DIRECT_SAMPLING;
+            result = r;
+        }
+    }
+    if ((request.mask & CTRL_CLOCK_SOURCE) &&
+        !((_ctrl_applied.mask & CTRL_CLOCK_SOURCE) && (_ctrl_applied.clock_source == request.clock_source)))
+    {
+        r = -1;
+        if (_dev_stock)
+        {
+            r = fobos_rx_set_clk_source(_dev_stock, request.clock_source);
+        }
+        else if (_dev_agile)
+        {
+            r = fobos_sdr_set_clk_source(_dev_agile, request.clock_source);
+        }
+        if (r == 0)
+        {
+            _ctrl_applied.clock_source = request.clock_source;
+            _ctrl_applied.mask |= CTRL_CLOCK_SOURCE;
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set clock_source failed with code %d", r);
+            _ctrl_applied.mask &= ~CTRL_CLOCK_SOURCE;
+            result = r;
+        }
+    }
+    if ((request.mask & CTRL_SAMPLE_RATE) &&
+        !((_ctrl_applied.mask & CTRL_SAMPLE_RATE) && (_ctrl_applied.sample_rate == request.sample_rate)))
+    {
+        double actual;
+        {
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
+            actual = _sample_rate * _resample_decim / _resample_interp;
+        }
+        r = 0;
+        if (!((_ctrl_applied.mask & CTRL_SAMPLE_RATE) && (_ctrl_applied.native_rate == request.native_rate)))
+        {
+            // a new rate of the resampler alone leaves the hardware as it is
+            actual = request.native_rate;
+            r = -1;
+            if (_dev_stock)
+            {
+                r = fobos_rx_set_samplerate(_dev_stock, request.native_rate, &actual);
+            }
+            else if (_dev_agile)
+            {
+                r = fobos_sdr_set_samplerate(_dev_agile, request.native_rate);
+            }
+        }
+        if (r == 0)
+        {
+            size_t interp = 1;
+            size_t decim = 1;
+            if (request.sample_rate < actual * (1.0 - 1E-9))
+            {
+                SoapyFobosResampler::rational(request.sample_rate / actual, RESAMPLE_MAX_INTERP, interp, decim);
+            }
+            {
+                std::lock_guard<std::mutex> lock(_ctrl_mutex);
+                _resample_interp = interp;
+                _resample_decim = decim;
+                _sample_rate = actual * interp / decim;
+                // rate_boundary() takes the epoch and the rate together
+                _ctrl_rate_epoch++;
+            }
+            _ctrl_applied.sample_rate = request.sample_rate;
+            _ctrl_applied.native_rate = request.native_rate;
+            _ctrl_applied.mask |= CTRL_SAMPLE_RATE;
+            if (!_ctrl_async)
+            {
+                // while streaming the next transfer picks them up, see rate_boundary()
+                _resample_changed = true;
+                _nco_changed = true;
+            }
+            SoapySDR_logf(SOAPY_SDR_DEBUG, "actual: %f = %f * %d / %d", _sample_rate, actual, (int)interp, (int)decim);
+        }
+        else
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "set sample rate %f failed with code %d", request.native_rate, r);
+            _ctrl_applied.mask &= ~CTRL_SAMPLE_RATE;
+            result = r;
+        }
+    }
+    if (gain_changed)
+    {
+        // the gain first, the streaming thread reads the epoch first
+        _ctrl_gain_db = applied_gain();
+        _ctrl_gain_epoch++;
+    }
+    return result;
+}
+
+// LNA + VGA gain the hardware has, dB
+double SoapyFobosSDR::applied_gain(void) const
+{
+    double gain = 0.0;
+    if (_ctrl_applied.mask & CTRL_LNA_GAIN)
+    {
+        gain += (_ctrl_applied.lna_idx - 1) / _lna_gain_scale;
+    }
+    if (_ctrl_applied.mask & CTRL_VGA_GAIN)
+    {
+        gain += _ctrl_applied.vga_idx / _vga_gain_scale;
+    }
+    return gain;
+}
+
+/*******************************************************************
+ * Software AGC
+ * Runs on the streaming thread with the power and peak of every
+ * slot. The LNA and VGA indexes are treated as one gain ladder of
+ * VGA steps (the LNA step equals 8 VGA steps), LNA is kept as high
+ * as possible. After a change the next slots are skipped until the
+ * transfers queued with the old gain are through.
+ ******************************************************************/
+
+void SoapyFobosSDR::agc_start(void)
+{
+    std::lock_guard<std::mutex> lock(_ctrl_mutex);
+    _agc_lna_idx = std::min(std::max((int)round(_lna_gain * _lna_gain_scale) + 1, LNA_IDX_MIN), LNA_IDX_MAX);
+    _agc_vga_idx = std::min(std::max((int)round(_vga_gain * _vga_gain_scale), VGA_IDX_MIN), VGA_IDX_MAX);
+    _agc_holdoff = 0;
+}
+
+void SoapyFobosSDR::agc_update(float power, float peak)
+{
+    if (_agc_holdoff > 0)
+    {
+        _agc_holdoff--;
+        return;
+    }
+    const int lna_steps = (int)round(_vga_gain_scale / _lna_gain_scale);
+    const int ladder_max = (LNA_IDX_MAX - LNA_IDX_MIN) * lna_steps + VGA_IDX_MAX - VGA_IDX_MIN;
+    double power_db = 10.0 * log10(power + 1E-20);
+    double peak_db = 10.0 * log10(peak + 1E-20);
+    double delta_db = 0.0;
+    if (peak_db > AGC_CLIP_DBFS)
+    {
+        delta_db = std::min(_agc_target - power_db, -3.0 / _vga_gain_scale);
+    }
+    else if (fabs(_agc_target - power_db) > _agc_hysteresis * 0.5)
+    {
+        delta_db = _agc_target - power_db;
+    }
+    int steps = (int)round(delta_db * _vga_gain_scale);
+    if (steps == 0)
+    {
+        return;
+    }
+    int ladder = (_agc_lna_idx - LNA_IDX_MIN) * lna_steps + (_agc_vga_idx - VGA_IDX_MIN);
+    int next = std::min(std::max(ladder + steps, 0), ladder_max);
+    if (next == ladder)
+    {
+        return;
+    }
+    int lna = std::min(next / lna_steps, LNA_IDX_MAX - LNA_IDX_MIN);
+    _agc_lna_idx = LNA_IDX_MIN + lna;
+    _agc_vga_idx = VGA_IDX_MIN + next - lna * lna_steps;
+    SoapyFobosControl request;
+    request.mask = CTRL_LNA_GAIN | CTRL_VGA_GAIN;
+    request.lna_idx = _agc_lna_idx;
+    request.vga_idx = _agc_vga_idx;
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        _lna_gain = (_agc_lna_idx - 1) / _lna_gain_scale;
+        _vga_gain = _agc_vga_idx / _vga_gain_scale;
+    }
+    control_submit(request);
+    _agc_holdoff = _rx_buffs_count + 1;
+}
+//==============================================================================
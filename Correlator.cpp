@@ -0,0 +1,238 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  19.10.2026 - overlap-save FFT correlator, reference waveforms
+//==============================================================================
+
+#include "SoapyFobosCorrelator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+// y = x * h, complex
+static inline void multiply(const float* x, const float* h, float* y, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+    {
+        y[k * 2] = x[k * 2] * h[k * 2] - x[k * 2 + 1] * h[k * 2 + 1];
+        y[k * 2 + 1] = x[k * 2] * h[k * 2 + 1] + x[k * 2 + 1] * h[k * 2];
+    }
+}
+
+static size_t correlator_fft_len(const std::vector<std::vector<float>> &references)
+{
+    size_t longest = 1;
+    for (const auto &ref : references)
+    {
+        longest = std::max(longest, ref.size() / 2);
+    }
+    size_t len = FOBOS_CORRELATOR_MIN_FFT;
+    while (len < longest * FOBOS_CORRELATOR_FFT_RATIO)
+    {
+        len *= 2;
+    }
+    return len;
+}
+
+SoapyFobosCorrelator::SoapyFobosCorrelator(const std::vector<std::vector<float>> &references, float threshold, double max_offset):
+    _fft(correlator_fft_len(references)),
+    _refs(references.size()),
+    _threshold(threshold),
+    _max_offset(max_offset),
+    _sample_rate(0.0),
+    _bins(0),
+    _overlap(0),
+    _fill(0),
+    _counter(0)
+{
+    size_t len = _fft.len();
+    for (size_t r = 0; r < references.size(); r++)
+    {
+        Reference &ref = _refs[r];
+        ref.len = references[r].size() / 2;
+        ref.pending = false;
+        _overlap = std::max(_overlap, ref.len - 1);
+        double energy = 0.0;
+        for (size_t i = 0; i < ref.len * 2; i++)
+        {
+            energy += (double)references[r][i] * references[r][i];
+        }
+        ref.spectrum.assign(len * 2, 0.0f);
+        std::copy(references[r].begin(), references[r].begin() + ref.len * 2, ref.spectrum.begin());
+        _fft.forward(ref.spectrum.data());
+        // the inverse FFT of the product comes out as the correlation
+        // divided by |ref|, the 1 / len of the inverse included
+        float scale = (float)(1.0 / (len * sqrt(energy)));
+        for (size_t k = 0; k < len; k++)
+        {
+            ref.spectrum[k * 2] *= scale;
+            ref.spectrum[k * 2 + 1] *= -scale;
+        }
+    }
+    _block.assign(len * 2, 0.0f);
+    _spectrum.resize(len * 2);
+    _work.resize(len * 2);
+    _energy.resize(len + 1);
+    _best.resize(len);
+    _best_bin.resize(len);
+}
+
+void SoapyFobosCorrelator::reset(long long counter, double sample_rate, std::vector<SoapyFobosCorrelatorHit> &hits)
+{
+    if (_fill > _overlap)
+    {
+        // the rest of the block is silence, the references ending in it do not match
+        std::fill(_block.begin() + _fill * 2, _block.end(), 0.0f);
+        correlate(_fill - _overlap, hits);
+    }
+    for (auto &ref : _refs)
+    {
+        if (ref.pending)
+        {
+            hits.push_back(ref.hit);
+            ref.pending = false;
+        }
+    }
+    _fill = 0;
+    _counter = counter;
+    _sample_rate = sample_rate;
+    _bins = 0;
+    if (sample_rate > 0.0)
+    {
+        _bins = (int)std::min(floor(_max_offset / bin_hz()), (double)(_fft.len() / 4));
+        _bins = std::max(_bins, 0);
+    }
+}
+
+void SoapyFobosCorrelator::process(const float* samples, size_t count, std::vector<SoapyFobosCorrelatorHit> &hits)
+{
+    size_t len = _fft.len();
+    while (count > 0)
+    {
+        size_t take = std::min(count, len - _fill);
+        memcpy(_block.data() + _fill * 2, samples, take * 2 * sizeof(float));
+        _fill += take;
+        samples += take * 2;
+        count -= take;
+        if (_fill < len)
+        {
+            break;
+        }
+        size_t valid = len - _overlap;
+        correlate(valid, hits);
+        // overlap-save: the last samples start the next block
+        memmove(_block.data(), _block.data() + valid * 2, _overlap * 2 * sizeof(float));
+        _fill = _overlap;
+        _counter += valid;
+    }
+}
+
+void SoapyFobosCorrelator::correlate(size_t valid, std::vector<SoapyFobosCorrelatorHit> &hits)
+{
+    size_t len = _fft.len();
+    memcpy(_spectrum.data(), _block.data(), len * 2 * sizeof(float));
+    _fft.forward(_spectrum.data());
+    _energy[0] = 0.0;
+    for (size_t i = 0; i < len; i++)
+    {
+        _energy[i + 1] = _energy[i] + (double)_block[i * 2] * _block[i * 2] + (double)_block[i * 2 + 1] * _block[i * 2 + 1];
+    }
+    const float* x = _spectrum.data();
+    float* y = _work.data();
+    for (size_t r = 0; r < _refs.size(); r++)
+    {
+        Reference &ref = _refs[r];
+        const float* h = ref.spectrum.data();
+        std::fill(_best.begin(), _best.begin() + valid, 0.0f);
+        for (int b = -_bins; b <= _bins; b++)
+        {
+            // X[k + b] * conj(H[k]) / |ref|, the block shifted down b bins
+            size_t shift = (size_t)((long long)b + (long long)len) % len;
+            multiply(x + shift * 2, h, y, len - shift);
+            multiply(x, h + (len - shift) * 2, y + (len - shift) * 2, shift);
+            _fft.inverse(y);
+            for (size_t n = 0; n < valid; n++)
+            {
+                double energy = _energy[n + ref.len] - _energy[n];
+                if (energy <= 0.0)
+                {
+                    continue;
+                }
+                float peak = (float)((y[n * 2] * y[n * 2] + y[n * 2 + 1] * y[n * 2 + 1]) / energy);
+                if (peak > _best[n])
+                {
+                    _best[n] = peak;
+                    _best_bin[n] = b;
+                }
+            }
+        }
+        // the highest peak within the length of the reference
+        for (size_t n = 0; n < valid; n++)
+        {
+            long long counter = _counter + (long long)n;
+            if (ref.pending && (counter >= ref.hit.counter + (long long)ref.len))
+            {
+                hits.push_back(ref.hit);
+                ref.pending = false;
+            }
+            if ((_best[n] >= _threshold) && (!ref.pending || (_best[n] > ref.hit.peak)))
+            {
+                ref.pending = true;
+                ref.hit.reference = r;
+                ref.hit.counter = counter;
+                ref.hit.len = ref.len;
+                ref.hit.bin = _best_bin[n];
+                ref.hit.peak = std::min(_best[n], 1.0f);
+                ref.hit.power = (float)((_energy[n + ref.len] - _energy[n]) / ref.len);
+            }
+        }
+    }
+}
+//==============================================================================
+
+std::vector<float> soapy_fobos_reference_load(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        size = ftell(file);
+        rewind(file);
+    }
+    size_t count = (size > 0) ? (size_t)size / (2 * sizeof(float)) : 0;
+    if ((count == 0) || (count > FOBOS_CORRELATOR_MAX_LEN))
+    {
+        fclose(file);
+        throw std::runtime_error(path + ": 1.." + std::to_string(FOBOS_CORRELATOR_MAX_LEN) + " CF32 samples expected");
+    }
+    std::vector<float> samples(count * 2);
+    size_t read = fread(samples.data(), 2 * sizeof(float), count, file);
+    fclose(file);
+    if (read != count)
+    {
+        throw std::runtime_error(path + ": read failed");
+    }
+    double energy = 0.0;
+    for (float v : samples)
+    {
+        if (!std::isfinite(v))
+        {
+            throw std::runtime_error(path + ": not a CF32 file");
+        }
+        energy += (double)v * v;
+    }
+    if (energy <= 0.0)
+    {
+        throw std::runtime_error(path + ": all samples are zero");
+    }
+    return samples;
+}
+//==============================================================================
@@ -0,0 +1,207 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - warm device handle pool
+//  19.10.2026 - pooled handles of unplugged devices are dropped
+//==============================================================================
+
+#include "SoapyFobosSDR.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+typedef std::chrono::steady_clock pool_clock;
+
+struct SoapyFobosPoolEntry
+{
+    SoapyFobosHandle handle;
+    pool_clock::time_point expires;
+};
+
+static void close_handle(const SoapyFobosHandle &handle)
+{
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "closing pooled device %s", handle.serial);
+    if (handle.dev_stock)
+    {
+        fobos_rx_close(handle.dev_stock);
+    }
+    if (handle.dev_agile)
+    {
+        fobos_sdr_close(handle.dev_agile);
+    }
+}
+
+// The board answers, it has not been unplugged while in the pool
+static bool handle_alive(const SoapyFobosHandle &handle)
+{
+    char hw_revision[INFO_LEN];
+    char fw_version[INFO_LEN];
+    char manufacturer[INFO_LEN];
+    char product[INFO_LEN];
+    char serial[INFO_LEN];
+    int result = -1;
+    if (handle.dev_stock)
+    {
+        result = fobos_rx_get_board_info(handle.dev_stock, hw_revision, fw_version, manufacturer, product, serial);
+    }
+    else if (handle.dev_agile)
+    {
+        result = fobos_sdr_get_board_info(handle.dev_agile, hw_revision, fw_version, manufacturer, product, serial);
+    }
+    return result == 0;
+}
+
+//==============================================================================
+class SoapyFobosPool
+{
+public:
+    SoapyFobosPool(void):
+        _running(false)
+    {
+    }
+
+    ~SoapyFobosPool(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _cond.notify_one();
+        if (_reaper.joinable())
+        {
+            _reaper.join();
+        }
+        for (auto & it : _entries)
+        {
+            close_handle(it.second.handle);
+        }
+    }
+
+    bool take(const std::string &serial, SoapyFobosHandle &handle)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(serial);
+            if (it == _entries.end())
+            {
+                return false;
+            }
+            handle = it->second.handle;
+            _entries.erase(it);
+        }
+        if (!handle_alive(handle))
+        {
+            SoapySDR_logf(SOAPY_SDR_WARNING, "pooled device %s does not answer, dropped", handle.serial);
+            close_handle(handle);
+            return false;
+        }
+        return true;
+    }
+
+    void put(const SoapyFobosHandle &handle, double idle_s)
+    {
+        SoapyFobosHandle replaced;
+        bool has_replaced = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(handle.serial);
+            if (it != _entries.end())
+            {
+                // should never happen, the device can be opened only once
+                replaced = it->second.handle;
+                has_replaced = true;
+            }
+            SoapyFobosPoolEntry & entry = _entries[handle.serial];
+            entry.handle = handle;
+            entry.expires = pool_clock::now() + std::chrono::microseconds((long long)(idle_s * 1E6));
+            if (!_running)
+            {
+                _running = true;
+                _reaper = std::thread(&SoapyFobosPool::reaper_loop, this);
+            }
+        }
+        _cond.notify_one();
+        if (has_replaced)
+        {
+            close_handle(replaced);
+        }
+    }
+
+    std::vector<SoapyFobosHandle> list(void)
+    {
+        std::vector<SoapyFobosHandle> result;
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto & it : _entries)
+        {
+            result.push_back(it.second.handle);
+        }
+        return result;
+    }
+
+private:
+    void reaper_loop(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_running)
+        {
+            std::vector<SoapyFobosHandle> expired;
+            pool_clock::time_point now = pool_clock::now();
+            pool_clock::time_point next = now + std::chrono::seconds(60);
+            for (auto it = _entries.begin(); it != _entries.end();)
+            {
+                if (it->second.expires <= now)
+                {
+                    expired.push_back(it->second.handle);
+                    it = _entries.erase(it);
+                }
+                else
+                {
+                    next = std::min(next, it->second.expires);
+                    ++it;
+                }
+            }
+            if (expired.size() > 0)
+            {
+                // closing takes time, do not hold the pool meanwhile
+                lock.unlock();
+                for (auto & handle : expired)
+                {
+                    close_handle(handle);
+                }
+                lock.lock();
+                continue;
+            }
+            _cond.wait_until(lock, next);
+        }
+    }
+
+    bool _running;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::thread _reaper;
+    std::map<std::string, SoapyFobosPoolEntry> _entries;
+};
+//==============================================================================
+static SoapyFobosPool & pool(void)
+{
+    static SoapyFobosPool instance;
+    return instance;
+}
+
+bool soapy_fobos_pool_take(const std::string &serial, SoapyFobosHandle &handle)
+{
+    return pool().take(serial, handle);
+}
+
+void soapy_fobos_pool_put(const SoapyFobosHandle &handle, double idle_s)
+{
+    pool().put(handle, idle_s);
+}
+
+std::vector<SoapyFobosHandle> soapy_fobos_pool_list(void)
+{
+    return pool().list();
+}
+//==============================================================================
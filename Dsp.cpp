@@ -0,0 +1,679 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Signal processing kernels used on the streaming path
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - per buffer signal statistics
+//  18.10.2026 - decimator, sample format conversion
+//  18.10.2026 - rational polyphase resampler
+//  18.10.2026 - real input to complex half rate (fs/4 mix + halfband), real formats
+//  18.10.2026 - compact ring storage formats
+//  18.10.2026 - NCO fused into the statistics copy
+//  18.10.2026 - NCO and resampler chunk by chunk for the pipeline
+//  19.10.2026 - radix 2 FFT
+//==============================================================================
+
+#include "SoapyFobosDsp.hpp"
+#include <cmath>
+#include <cstring>
+
+// Independent accumulators, so the compiler is free to keep them in SIMD
+// lanes without reordering the float additions.
+#define STATS_LANES             8
+// the float lane rotators of the mixer restart from the exact phase every
+// so many samples, before their rounding errors add up
+#define NCO_RENORM_LEN          1024
+
+// MIX: dst = src * exp(j * (phase + step * n)), one rotator per lane
+template <bool COPY, bool MIX>
+static inline void stats_kernel(float* dst, const float* src, size_t count, SoapyFobosStats &stats,
+        double phase = 0.0, double step = 0.0)
+{
+    float acc_p[STATS_LANES] = {0};
+    float acc_i[STATS_LANES] = {0};
+    float acc_q[STATS_LANES] = {0};
+    float max_p[STATS_LANES] = {0};
+    uint32_t clips[STATS_LANES] = {0};
+    float rot_re[STATS_LANES] = {0};
+    float rot_im[STATS_LANES] = {0};
+    float step_re = (float)cos(step * STATS_LANES);
+    float step_im = (float)sin(step * STATS_LANES);
+    size_t i = 0;
+    for (; i + STATS_LANES <= count; i += STATS_LANES)
+    {
+        if (MIX && ((i % NCO_RENORM_LEN) == 0))
+        {
+            for (size_t k = 0; k < STATS_LANES; k++)
+            {
+                double angle = phase + step * (double)(i + k);
+                rot_re[k] = (float)cos(angle);
+                rot_im[k] = (float)sin(angle);
+            }
+        }
+        for (size_t k = 0; k < STATS_LANES; k++)
+        {
+            float re = src[2 * (i + k)];
+            float im = src[2 * (i + k) + 1];
+            if (MIX)
+            {
+                dst[2 * (i + k)] = re * rot_re[k] - im * rot_im[k];
+                dst[2 * (i + k) + 1] = re * rot_im[k] + im * rot_re[k];
+                float next_re = rot_re[k] * step_re - rot_im[k] * step_im;
+                rot_im[k] = rot_re[k] * step_im + rot_im[k] * step_re;
+                rot_re[k] = next_re;
+            }
+            else if (COPY)
+            {
+                dst[2 * (i + k)] = re;
+                dst[2 * (i + k) + 1] = im;
+            }
+            float p = re * re + im * im;
+            acc_p[k] += p;
+            acc_i[k] += re;
+            acc_q[k] += im;
+            max_p[k] = (p > max_p[k]) ? p : max_p[k];
+            clips[k] += (fabsf(re) >= FOBOS_CLIP_LEVEL) | (fabsf(im) >= FOBOS_CLIP_LEVEL);
+        }
+    }
+    for (; i < count; i++)
+    {
+        float re = src[2 * i];
+        float im = src[2 * i + 1];
+        if (MIX)
+        {
+            double angle = phase + step * (double)i;
+            float c = (float)cos(angle);
+            float s = (float)sin(angle);
+            dst[2 * i] = re * c - im * s;
+            dst[2 * i + 1] = re * s + im * c;
+        }
+        else if (COPY)
+        {
+            dst[2 * i] = re;
+            dst[2 * i + 1] = im;
+        }
+        float p = re * re + im * im;
+        acc_p[0] += p;
+        acc_i[0] += re;
+        acc_q[0] += im;
+        max_p[0] = (p > max_p[0]) ? p : max_p[0];
+        clips[0] += (fabsf(re) >= FOBOS_CLIP_LEVEL) | (fabsf(im) >= FOBOS_CLIP_LEVEL);
+    }
+    double sum_p = 0.0;
+    double sum_i = 0.0;
+    double sum_q = 0.0;
+    stats.peak = 0.0f;
+    stats.clips = 0;
+    for (size_t k = 0; k < STATS_LANES; k++)
+    {
+        sum_p += acc_p[k];
+        sum_i += acc_i[k];
+        sum_q += acc_q[k];
+        stats.peak = (max_p[k] > stats.peak) ? max_p[k] : stats.peak;
+        stats.clips += clips[k];
+    }
+    double n = (count > 0) ? (double)count : 1.0;
+    stats.power = (float)(sum_p / n);
+    stats.dc_i = (float)(sum_i / n);
+    stats.dc_q = (float)(sum_q / n);
+}
+
+void fobos_copy_stats(float* dst, const float* src, size_t count, SoapyFobosStats &stats)
+{
+    stats_kernel<true, false>(dst, src, count, stats);
+}
+
+void fobos_stats(const float* src, size_t count, SoapyFobosStats &stats)
+{
+    stats_kernel<false, false>(nullptr, src, count, stats);
+}
+
+void fobos_stats_add(SoapyFobosStats &stats, size_t count, const SoapyFobosStats &part, size_t part_count)
+{
+    double total = (double)(count + part_count);
+    if (total == 0.0)
+    {
+        return;
+    }
+    double w = (double)part_count / total;
+    stats.power += (float)((part.power - stats.power) * w);
+    stats.dc_i += (float)((part.dc_i - stats.dc_i) * w);
+    stats.dc_q += (float)((part.dc_q - stats.dc_q) * w);
+    stats.peak = (part.peak > stats.peak) ? part.peak : stats.peak;
+    stats.clips += part.clips;
+}
+//==============================================================================
+
+SoapyFobosNco::SoapyFobosNco(void):
+    _step(0.0),
+    _phase(0.0)
+{
+}
+
+void SoapyFobosNco::set(double frequency)
+{
+    _step = 2.0 * M_PI * frequency;
+}
+
+void SoapyFobosNco::mix(const float* in, float* out, size_t count, SoapyFobosStats &stats)
+{
+    stats_kernel<true, true>(out, in, count, stats, _phase, _step);
+    advance(count);
+}
+
+void SoapyFobosNco::mix_at(const float* in, float* out, size_t count, size_t offset, SoapyFobosStats &stats) const
+{
+    double phase = fmod(_phase + _step * (double)offset, 2.0 * M_PI);
+    stats_kernel<true, true>(out, in, count, stats, phase, _step);
+}
+
+void SoapyFobosNco::advance(size_t count)
+{
+    _phase = fmod(_phase + _step * (double)count, 2.0 * M_PI);
+}
+//==============================================================================
+
+void fobos_block_power(const float* src, size_t count, size_t block_len, float* power)
+{
+    for (size_t b = 0; b < count / block_len; b++)
+    {
+        const float* x = src + b * block_len * 2;
+        float acc[STATS_LANES] = {0};
+        for (size_t i = 0; i < block_len * 2; i += STATS_LANES)
+        {
+            for (size_t k = 0; k < STATS_LANES; k++)
+            {
+                acc[k] += x[i + k] * x[i + k];
+            }
+        }
+        float sum = 0.0f;
+        for (size_t k = 0; k < STATS_LANES; k++)
+        {
+            sum += acc[k];
+        }
+        power[b] = sum / block_len;
+    }
+}
+//==============================================================================
+
+static inline float saturate(float value, float limit)
+{
+    return (value > limit) ? limit : ((value < -limit) ? -limit : value);
+}
+
+void fobos_cf32_to_cs16(const float* src, int16_t* dst, size_t count)
+{
+    fobos_f32_to_s16(src, 1, dst, count * 2);
+}
+
+void fobos_cf32_to_cs8(const float* src, int8_t* dst, size_t count)
+{
+    fobos_f32_to_s8(src, 1, dst, count * 2);
+}
+
+void fobos_f32_copy(const float* src, size_t stride, float* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = src[i * stride];
+    }
+}
+
+void fobos_f32_to_s16(const float* src, size_t stride, int16_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = (int16_t)lrintf(saturate(src[i * stride] * 32767.0f, 32767.0f));
+    }
+}
+
+void fobos_f32_to_s8(const float* src, size_t stride, int8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = (int8_t)lrintf(saturate(src[i * stride] * 127.0f, 127.0f));
+    }
+}
+//==============================================================================
+
+size_t fobos_ring_sample_bytes(int format)
+{
+    switch (format)
+    {
+    case FOBOS_RING_CS16:
+        return 2 * sizeof(int16_t);
+    case FOBOS_RING_CS12:
+        return 3;
+    default:
+        return 2 * sizeof(float);
+    }
+}
+
+void fobos_ring_pack(int format, const float* src, void* dst, size_t count)
+{
+    if (format == FOBOS_RING_CS16)
+    {
+        fobos_f32_to_s16(src, 1, (int16_t*)dst, count * 2);
+    }
+    else if (format == FOBOS_RING_CS12)
+    {
+        uint8_t* out = (uint8_t*)dst;
+        for (size_t i = 0; i < count; i++)
+        {
+            int32_t re = (int32_t)lrintf(saturate(src[2 * i] * 2047.0f, 2047.0f));
+            int32_t im = (int32_t)lrintf(saturate(src[2 * i + 1] * 2047.0f, 2047.0f));
+            out[3 * i] = (uint8_t)re;
+            out[3 * i + 1] = (uint8_t)(((re >> 8) & 0x0F) | (im << 4));
+            out[3 * i + 2] = (uint8_t)(im >> 4);
+        }
+    }
+    else
+    {
+        memcpy(dst, src, count * 2 * sizeof(float));
+    }
+}
+
+void fobos_ring_unpack(int format, const void* src, size_t pos, float* dst, size_t count)
+{
+    if (format == FOBOS_RING_CS16)
+    {
+        const int16_t* in = (const int16_t*)src + pos * 2;
+        for (size_t i = 0; i < count * 2; i++)
+        {
+            dst[i] = in[i] * (1.0f / 32767.0f);
+        }
+    }
+    else if (format == FOBOS_RING_CS12)
+    {
+        const uint8_t* in = (const uint8_t*)src + pos * 3;
+        for (size_t i = 0; i < count; i++)
+        {
+            // sign extended from bit 11
+            int32_t re = (int32_t)((uint32_t)(in[3 * i] | (in[3 * i + 1] << 8)) << 20) >> 20;
+            int32_t im = (int32_t)((uint32_t)((in[3 * i + 1] >> 4) | (in[3 * i + 2] << 4)) << 20) >> 20;
+            dst[2 * i] = re * (1.0f / 2047.0f);
+            dst[2 * i + 1] = im * (1.0f / 2047.0f);
+        }
+    }
+    else
+    {
+        memcpy(dst, (const float*)src + pos * 2, count * 2 * sizeof(float));
+    }
+}
+//==============================================================================
+// taps per decimation factor, the pass band ends at 0.8 of the output Nyquist
+#define DECIMATOR_TAPS_PER_FACTOR   16
+
+SoapyFobosDecimator::SoapyFobosDecimator(size_t factor):
+    _factor(factor < 1 ? 1 : factor),
+    _phase(0)
+{
+    size_t count = DECIMATOR_TAPS_PER_FACTOR * _factor + 1;
+    double cutoff = 0.8 * 0.5 / _factor;
+    double sum = 0.0;
+    _taps.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        double n = (double)i - (count - 1) / 2.0;
+        double sinc = (n == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * n) / (M_PI * n);
+        double window = 0.42 - 0.5 * cos(2.0 * M_PI * i / (count - 1)) + 0.08 * cos(4.0 * M_PI * i / (count - 1));
+        _taps[i] = (float)(sinc * window);
+        sum += _taps[i];
+    }
+    for (auto & tap : _taps)
+    {
+        tap = (float)(tap / sum);
+    }
+    reset();
+}
+
+void SoapyFobosDecimator::reset(void)
+{
+    _phase = 0;
+    _work.assign((_taps.size() - 1) * 2, 0.0f);
+}
+
+size_t SoapyFobosDecimator::input_for(size_t count) const
+{
+    return count * _factor - _phase;
+}
+
+size_t SoapyFobosDecimator::process(const float* in, size_t count, float* out)
+{
+    if (_factor == 1)
+    {
+        memcpy(out, in, count * 2 * sizeof(float));
+        return count;
+    }
+    size_t history = _taps.size() - 1;
+    _work.resize((history + count) * 2);
+    memcpy(_work.data() + history * 2, in, count * 2 * sizeof(float));
+    size_t produced = 0;
+    // input #k of this call is _work[history + k]
+    size_t k = _factor - 1 - _phase;
+    for (; k < count; k += _factor)
+    {
+        const float* x = _work.data() + (k + 1) * 2;
+        float re = 0.0f;
+        float im = 0.0f;
+        for (size_t t = 0; t < _taps.size(); t++)
+        {
+            re += _taps[t] * x[2 * t];
+            im += _taps[t] * x[2 * t + 1];
+        }
+        out[2 * produced] = re;
+        out[2 * produced + 1] = im;
+        produced++;
+    }
+    _phase = (_phase + count) % _factor;
+    memmove(_work.data(), _work.data() + count * 2, history * 2 * sizeof(float));
+    _work.resize(history * 2);
+    return produced;
+}
+//==============================================================================
+// halfband length 4 * K + 3, the pass band ends at 0.8 of the output Nyquist
+#define HALFBAND_K                  15
+
+// With the outputs at the odd inputs n and the mixer w[i] = (-j)^i, the even
+// inputs n - k (k odd) are real after mixing and only the center tap is not
+// zero among them, the odd inputs (k even) are imaginary: one tap for I and
+// a dense dot product over the odd inputs for Q. The mixer sign pattern is
+// the same for every output up to the overall sign, alternating with n % 4.
+SoapyFobosHalfband::SoapyFobosHalfband(void):
+    _phase(0),
+    _negate(false),
+    _center(0.0f)
+{
+    size_t count = 4 * HALFBAND_K + 3;
+    size_t center = (count - 1) / 2;
+    std::vector<double> h(count);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        double n = (double)i - center;
+        double sinc = (n == 0.0) ? 0.5 : sin(0.5 * M_PI * n) / (M_PI * n);
+        double window = 0.42 - 0.5 * cos(2.0 * M_PI * i / (count - 1)) + 0.08 * cos(4.0 * M_PI * i / (count - 1));
+        h[i] = sinc * window;
+        sum += h[i];
+    }
+    // x2: the mixer keeps half of the real signal power
+    double scale = 2.0 / sum;
+    // n = 1: w[(1 - center) % 4] = +1 for K even, -1 for K odd
+    _center = (float)(h[center] * scale * ((HALFBAND_K % 2 == 0) ? 1.0 : -1.0));
+    // n = 1, k = 2 * j: Im w[(1 - 2 * j) % 4] = -1 for j even, +1 for j odd
+    size_t odd_count = count / 2 + 1;
+    _taps.resize(odd_count);
+    for (size_t j = 0; j < odd_count; j++)
+    {
+        _taps[odd_count - 1 - j] = (float)(h[2 * j] * scale * ((j % 2 == 0) ? -1.0 : 1.0));
+    }
+    reset();
+}
+
+void SoapyFobosHalfband::reset(void)
+{
+    _phase = 0;
+    _negate = false;
+    _even.assign(HALFBAND_K, 0.0f);
+    _odd.assign(_taps.size() - 1, 0.0f);
+}
+
+size_t SoapyFobosHalfband::input_for(size_t count) const
+{
+    return count * 2 - _phase;
+}
+
+size_t SoapyFobosHalfband::process(const float* in, size_t stride, size_t count, float* out)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (_phase == 0)
+        {
+            _even.push_back(in[i * stride]);
+        }
+        else
+        {
+            _odd.push_back(in[i * stride]);
+        }
+        _phase ^= 1;
+    }
+    size_t history = _taps.size() - 1;
+    size_t produced = _odd.size() - history;
+    for (size_t m = 0; m < produced; m++)
+    {
+        const float* x = _odd.data() + m;
+        float im = 0.0f;
+        for (size_t j = 0; j < _taps.size(); j++)
+        {
+            im += _taps[j] * x[j];
+        }
+        float re = _center * _even[m];
+        float sign = _negate ? -1.0f : 1.0f;
+        out[2 * m] = sign * re;
+        out[2 * m + 1] = sign * im;
+        _negate = !_negate;
+    }
+    _odd.erase(_odd.begin(), _odd.begin() + produced);
+    _even.erase(_even.begin(), _even.begin() + produced);
+    return produced;
+}
+//==============================================================================
+// taps per phase for every decim / interp of the ratio
+#define RESAMPLER_TAPS_PER_RATIO    16
+
+SoapyFobosResampler::SoapyFobosResampler(size_t interp, size_t decim):
+    _interp(interp < 1 ? 1 : interp),
+    _decim(decim < interp ? interp : decim),
+    _next(0),
+    _loaded(0)
+{
+    size_t ratio = (_decim + _interp - 1) / _interp;
+    _phase_len = RESAMPLER_TAPS_PER_RATIO * ratio;
+    size_t count = _phase_len * _interp;
+    // low pass at the interpolated rate, the pass band ends at 0.8 of the output Nyquist
+    double cutoff = 0.8 * 0.5 / _decim;
+    std::vector<double> proto(count);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        double n = (double)i - (count - 1) / 2.0;
+        double sinc = (n == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * n) / (M_PI * n);
+        double window = 0.42 - 0.5 * cos(2.0 * M_PI * i / (count - 1)) + 0.08 * cos(4.0 * M_PI * i / (count - 1));
+        proto[i] = sinc * window;
+        sum += proto[i];
+    }
+    // every phase sums to 1
+    _taps.resize(count);
+    for (size_t p = 0; p < _interp; p++)
+    {
+        for (size_t j = 0; j < _phase_len; j++)
+        {
+            _taps[p * _phase_len + j] = (float)(proto[p + j * _interp] * _interp / sum);
+        }
+    }
+    reset();
+}
+
+void SoapyFobosResampler::reset(void)
+{
+    _next = 0;
+    _loaded = 0;
+    _work.assign((_phase_len - 1) * 2, 0.0f);
+}
+
+size_t SoapyFobosResampler::input_for(size_t count) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    return (_next + (count - 1) * _decim) / _interp + 1;
+}
+
+size_t SoapyFobosResampler::process(const float* in, size_t count, float* out)
+{
+    size_t produced = load(in, count);
+    process_range(0, produced, out);
+    consume();
+    return produced;
+}
+
+size_t SoapyFobosResampler::load(const float* in, size_t count)
+{
+    size_t history = _phase_len - 1;
+    _work.resize((history + count) * 2);
+    memcpy(_work.data() + history * 2, in, count * 2 * sizeof(float));
+    _loaded = count;
+    // outputs at _next + k * decim < count * interp
+    size_t end = count * _interp;
+    return (_next < end) ? (end - _next + _decim - 1) / _decim : 0;
+}
+
+void SoapyFobosResampler::process_range(size_t first, size_t count, float* out) const
+{
+    size_t history = _phase_len - 1;
+    size_t next = _next + first * _decim;
+    for (size_t k = 0; k < count; k++, next += _decim)
+    {
+        // output = sum h[phase + j * interp] * x[n - j]
+        const float* h = _taps.data() + (next % _interp) * _phase_len;
+        const float* x = _work.data() + (history + next / _interp) * 2;
+        float re = 0.0f;
+        float im = 0.0f;
+        for (size_t j = 0; j < _phase_len; j++)
+        {
+            re += h[j] * x[-2 * (ptrdiff_t)j];
+            im += h[j] * x[-2 * (ptrdiff_t)j + 1];
+        }
+        out[2 * k] = re;
+        out[2 * k + 1] = im;
+    }
+}
+
+void SoapyFobosResampler::consume(void)
+{
+    size_t history = _phase_len - 1;
+    size_t end = _loaded * _interp;
+    if (_next < end)
+    {
+        _next += (end - _next + _decim - 1) / _decim * _decim;
+    }
+    _next -= end;
+    memmove(_work.data(), _work.data() + _loaded * 2, history * 2 * sizeof(float));
+    _work.resize(history * 2);
+    _loaded = 0;
+}
+
+void SoapyFobosResampler::rational(double ratio, size_t max_interp, size_t &interp, size_t &decim)
+{
+    // continued fraction convergents of ratio
+    size_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double x = ratio;
+    interp = 1;
+    decim = 1;
+    for (int i = 0; i < 32; i++)
+    {
+        double a = floor(x);
+        size_t p2 = (size_t)a * p1 + p0;
+        size_t q2 = (size_t)a * q1 + q0;
+        if ((p2 > max_interp) || (q2 == 0))
+        {
+            break;
+        }
+        interp = p2;
+        decim = q2;
+        if ((fabs(ratio - (double)p2 / q2) < 1E-12) || (x - a < 1E-12))
+        {
+            break;
+        }
+        x = 1.0 / (x - a);
+        p0 = p1;
+        q0 = q1;
+        p1 = p2;
+        q1 = q2;
+    }
+    if (interp == 0)
+    {
+        interp = 1;
+        decim = (size_t)llround(1.0 / ratio);
+    }
+}
+//==============================================================================
+
+SoapyFobosFft::SoapyFobosFft(size_t len):
+    _len(len),
+    _twiddles(len),
+    _swaps()
+{
+    for (size_t k = 0; k < len / 2; k++)
+    {
+        double phase = -2.0 * M_PI * k / len;
+        _twiddles[k * 2] = (float)cos(phase);
+        _twiddles[k * 2 + 1] = (float)sin(phase);
+    }
+    size_t bits = 0;
+    while (((size_t)1 << bits) < len)
+    {
+        bits++;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++)
+        {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        if (i < r)
+        {
+            _swaps.push_back((uint32_t)i);
+            _swaps.push_back((uint32_t)r);
+        }
+    }
+}
+
+void SoapyFobosFft::forward(float* data) const
+{
+    transform(data, 1.0f);
+}
+
+void SoapyFobosFft::inverse(float* data) const
+{
+    transform(data, -1.0f);
+}
+
+// sign -1 conjugates the twiddles
+void SoapyFobosFft::transform(float* data, float sign) const
+{
+    for (size_t i = 0; i < _swaps.size(); i += 2)
+    {
+        float* a = data + _swaps[i] * 2;
+        float* b = data + _swaps[i + 1] * 2;
+        float re = a[0];
+        float im = a[1];
+        a[0] = b[0];
+        a[1] = b[1];
+        b[0] = re;
+        b[1] = im;
+    }
+    for (size_t half = 1; half < _len; half *= 2)
+    {
+        size_t step = _len / (half * 2);
+        for (size_t start = 0; start < _len; start += half * 2)
+        {
+            float* a = data + start * 2;
+            float* b = a + half * 2;
+            for (size_t j = 0; j < half; j++)
+            {
+                float w_re = _twiddles[j * step * 2];
+                float w_im = _twiddles[j * step * 2 + 1] * sign;
+                float t_re = b[j * 2] * w_re - b[j * 2 + 1] * w_im;
+                float t_im = b[j * 2] * w_im + b[j * 2 + 1] * w_re;
+                b[j * 2] = a[j * 2] - t_re;
+                b[j * 2 + 1] = a[j * 2 + 1] - t_im;
+                a[j * 2] += t_re;
+                a[j * 2 + 1] += t_im;
+            }
+        }
+    }
+}
+//==============================================================================
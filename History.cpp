@@ -0,0 +1,213 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - deep history ring, SigMF snapshots
+//==============================================================================
+
+#include "SoapyFobosHistory.hpp"
+#include "SoapyFobosDsp.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+
+SoapyFobosHistory * soapy_fobos_history_create(double seconds, double sample_rate, size_t slot_len, int format)
+{
+    size_t kept = std::max((size_t)ceil(seconds * sample_rate / slot_len), (size_t)1);
+    size_t count = kept + std::max(kept / FOBOS_HISTORY_MARGIN, (size_t)2);
+    size_t slot_bytes = slot_len * fobos_ring_sample_bytes(format);
+    uint8_t *data = new (std::nothrow) uint8_t [count * slot_bytes];
+    if (data == nullptr)
+    {
+        throw std::runtime_error("history_seconds: " + std::to_string((unsigned long long)(count * slot_bytes >> 20)) + " MB not available");
+    }
+    SoapyFobosHistory *history = new SoapyFobosHistory();
+    history->format = format;
+    history->sample_rate = sample_rate;
+    history->slot_len = slot_len;
+    history->slot_bytes = slot_bytes;
+    history->slots_count = count;
+    history->slots_kept = kept;
+    history->data = data;
+    history->slots.resize(count);
+    history->seq_w = 0;
+    history->seq_done = 0;
+    SoapySDR_logf(SOAPY_SDR_INFO, "History of %.1f s, %d MB", kept * slot_len / sample_rate, (int)(count * slot_bytes >> 20));
+    return history;
+}
+
+void soapy_fobos_history_close(SoapyFobosHistory *history)
+{
+    if (history == nullptr)
+    {
+        return;
+    }
+    delete [] history->data;
+    delete history;
+}
+
+void soapy_fobos_history_put(SoapyFobosHistory *history, const float *samples, const void *packed, int packed_format,
+        const SoapyFobosHistorySlot &slot)
+{
+    uint64_t seq = history->seq_w.load(std::memory_order_relaxed);
+    // the snapshot copying the slot being overwritten sees the new seq_w after its copy
+    history->seq_w.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t idx = seq % history->slots_count;
+    uint8_t *dst = history->data + idx * history->slot_bytes;
+    if (packed_format == history->format)
+    {
+        memcpy(dst, packed, history->slot_bytes);
+    }
+    else
+    {
+        fobos_ring_pack(history->format, samples, dst, history->slot_len);
+    }
+    history->slots[idx] = slot;
+    history->seq_done.store(seq + 1, std::memory_order_release);
+}
+
+// ISO 8601 UTC with nanoseconds
+static std::string utc_time(long long ns)
+{
+    time_t seconds = (time_t)(ns / 1000000000LL);
+    struct tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &seconds);
+#else
+    gmtime_r(&seconds, &tm);
+#endif
+    char text[64];
+    size_t len = strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(text + len, sizeof(text) - len, ".%09lldZ", ns % 1000000000LL);
+    return text;
+}
+
+static std::string json_string(const std::string &value)
+{
+    std::string result = "\"";
+    for (char c : value)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+bool soapy_fobos_history_dump(const SoapyFobosHistory *history, const std::string &path, uint64_t first, uint64_t last,
+        long long epoch_ns, const std::string &hw, std::string &status)
+{
+    std::string base = path;
+    static const char *suffixes[] = {".sigmf-data", ".sigmf-meta", ".sigmf"};
+    for (const char *suffix : suffixes)
+    {
+        size_t len = strlen(suffix);
+        if ((base.size() > len) && (base.compare(base.size() - len, len, suffix) == 0))
+        {
+            base.erase(base.size() - len);
+            break;
+        }
+    }
+    std::string data_path = base + ".sigmf-data";
+    FILE *file = fopen(data_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        status = "error " + data_path + ": " + strerror(errno);
+        return false;
+    }
+    bool cf32 = (history->format == FOBOS_RING_CF32);
+    size_t out_bytes = history->slot_len * (cf32 ? 8 : 4);
+    std::vector<uint8_t> slot_data(history->slot_bytes);
+    std::vector<uint8_t> out(out_bytes);
+    std::vector<float> expanded;
+    std::string captures;
+    uint64_t written = 0;
+    uint64_t lost = 0;
+    long long next_counter = -1;
+    double frequency = 0.0;
+    for (uint64_t seq = first; seq < last; seq++)
+    {
+        size_t idx = seq % history->slots_count;
+        memcpy(slot_data.data(), history->data + idx * history->slot_bytes, history->slot_bytes);
+        SoapyFobosHistorySlot slot = history->slots[idx];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (history->seq_w.load(std::memory_order_relaxed) > seq + history->slots_count)
+        {
+            // the writer has come round while copying
+            lost += history->slot_len;
+            continue;
+        }
+        if (history->format == FOBOS_RING_CS12)
+        {
+            expanded.resize(history->slot_len * 2);
+            fobos_ring_unpack(history->format, slot_data.data(), 0, expanded.data(), history->slot_len);
+            fobos_cf32_to_cs16(expanded.data(), (int16_t *)out.data(), history->slot_len);
+        }
+        else
+        {
+            memcpy(out.data(), slot_data.data(), out_bytes);
+        }
+        if ((slot.counter != next_counter) || (slot.frequency != frequency))
+        {
+            char text[256];
+            snprintf(text, sizeof(text), "%s\n        {\n            \"core:sample_start\": %llu,\n"
+                    "            \"core:global_index\": %lld,\n            \"core:frequency\": %.3f",
+                    captures.empty() ? "" : ",", (unsigned long long)written, slot.counter, slot.frequency);
+            captures += text;
+            if (epoch_ns != 0)
+            {
+                long long ns = epoch_ns + (long long)llround(slot.counter * 1E9 / history->sample_rate);
+                captures += ",\n            \"core:datetime\": \"" + utc_time(ns) + "\"";
+            }
+            captures += "\n        }";
+            frequency = slot.frequency;
+        }
+        next_counter = slot.counter + (long long)history->slot_len;
+        if (fwrite(out.data(), 1, out_bytes, file) != out_bytes)
+        {
+            status = "error " + data_path + ": " + strerror(errno);
+            fclose(file);
+            return false;
+        }
+        written += history->slot_len;
+    }
+    fclose(file);
+
+    // the metadata last, its presence means the data is complete
+    std::string meta_path = base + ".sigmf-meta";
+    file = fopen(meta_path.c_str(), "w");
+    if (file == nullptr)
+    {
+        status = "error " + meta_path + ": " + strerror(errno);
+        return false;
+    }
+    fprintf(file, "{\n    \"global\": {\n");
+    fprintf(file, "        \"core:datatype\": \"%s\",\n", cf32 ? "cf32_le" : "ci16_le");
+    fprintf(file, "        \"core:sample_rate\": %.3f,\n", history->sample_rate);
+    fprintf(file, "        \"core:version\": \"1.0.0\",\n");
+    fprintf(file, "        \"core:hw\": %s,\n", json_string(hw).c_str());
+    fprintf(file, "        \"core:recorder\": \"SoapyFobosSDR\",\n");
+    fprintf(file, "        \"core:description\": \"history snapshot, %llu samples, %llu lost\"\n",
+            (unsigned long long)written, (unsigned long long)lost);
+    fprintf(file, "    },\n    \"captures\": [%s\n    ],\n    \"annotations\": []\n}\n", captures.c_str());
+    bool ok = (fclose(file) == 0);
+    if (!ok)
+    {
+        status = "error " + meta_path + ": " + strerror(errno);
+        return false;
+    }
+    char text[64];
+    snprintf(text, sizeof(text), ": %llu samples, %llu lost", (unsigned long long)written, (unsigned long long)lost);
+    status = "done " + base + text;
+    return true;
+}
+//==============================================================================
@@ -0,0 +1,694 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Several coherent Fobos SDR receivers as one multi-channel device
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - frequency correction, overall frequency forwarded to the receivers
+//  19.10.2026 - readStream() of the children sets the flags, not reset here any more
+//  19.10.2026 - devices() for the callback registration
+//==============================================================================
+
+#include "SoapyFobosMulti.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Time.hpp>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <exception>
+
+SoapyFobosMulti::SoapyFobosMulti(const SoapySDR::Kwargs &args)
+{
+    _serials = split_serials(args.at("serials"));
+    if (_serials.size() == 0)
+    {
+        throw std::runtime_error("serials: no devices listed");
+    }
+    SoapySDR_logf(SOAPY_SDR_INFO, "Opening %d devices...", (int)_serials.size());
+    // opening takes a while, do it for all the devices at once
+    _devs.resize(_serials.size(), nullptr);
+    std::vector<std::exception_ptr> errors(_serials.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < _serials.size(); i++)
+    {
+        SoapySDR::Kwargs child_args = args;
+        child_args.erase("serials");
+        child_args["serial"] = _serials[i];
+        threads.push_back(std::thread([this, i, child_args, &errors]()
+        {
+            try
+            {
+                _devs[i] = new SoapyFobosSDR(child_args);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }));
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    for (size_t i = 0; i < _serials.size(); i++)
+    {
+        if (errors[i])
+        {
+            for (auto dev : _devs)
+            {
+                delete dev;
+            }
+            std::rethrow_exception(errors[i]);
+        }
+    }
+    _sample_offsets.resize(_serials.size(), 0);
+}
+
+SoapyFobosMulti::~SoapyFobosMulti(void)
+{
+    for (auto dev : _devs)
+    {
+        delete dev;
+    }
+}
+
+// Serials may be separated by ';' or spaces, or by ',' when the arguments are
+// passed as a dictionary rather than a markup string.
+std::vector<std::string> SoapyFobosMulti::split_serials(const std::string &serials)
+{
+    std::vector<std::string> result;
+    std::string item;
+    for (char c : serials + ";")
+    {
+        if ((c == ';') || (c == ',') || (c == ' '))
+        {
+            if (item.size() > 0)
+            {
+                result.push_back(item);
+            }
+            item.clear();
+        }
+        else
+        {
+            item += c;
+        }
+    }
+    return result;
+}
+
+SoapyFobosSDR * SoapyFobosMulti::child(const int direction, const size_t channel) const
+{
+    if ((direction != SOAPY_SDR_RX) || (channel >= _devs.size()))
+    {
+        throw std::runtime_error("invalid channel");
+    }
+    return _devs[channel];
+}
+
+/*******************************************************************
+ * Identification API
+ ******************************************************************/
+
+std::string SoapyFobosMulti::getDriverKey(void) const
+{
+    return "FobosSDR";
+}
+
+std::string SoapyFobosMulti::getHardwareKey(void) const
+{
+    return _devs[0]->getHardwareKey();
+}
+
+SoapySDR::Kwargs SoapyFobosMulti::getHardwareInfo(void) const
+{
+    SoapySDR::Kwargs args = _devs[0]->getHardwareInfo();
+    args.erase("serial");
+    args.erase("index");
+    std::string serials;
+    for (auto & serial : _serials)
+    {
+        serials += (serials.size() ? ";" : "") + serial;
+    }
+    args["serials"] = serials;
+    return args;
+}
+
+/*******************************************************************
+ * Channels API
+ ******************************************************************/
+
+size_t SoapyFobosMulti::getNumChannels(const int direction) const
+{
+    return (direction == SOAPY_SDR_RX) ? _devs.size() : 0;
+}
+
+bool SoapyFobosMulti::getFullDuplex(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    return false;
+}
+
+/*******************************************************************
+ * Stream API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosMulti::getStreamFormats(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getStreamFormats(direction, 0);
+}
+
+std::string SoapyFobosMulti::getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const
+{
+    return child(direction, channel)->getNativeStreamFormat(direction, 0, fullScale);
+}
+
+SoapySDR::ArgInfoList SoapyFobosMulti::getStreamArgsInfo(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getStreamArgsInfo(direction, 0);
+}
+
+SoapySDR::Stream *SoapyFobosMulti::setupStream(
+        const int direction,
+        const std::string &format,
+        const std::vector<size_t> &channels,
+        const SoapySDR::Kwargs &args)
+{
+    if (direction != SOAPY_SDR_RX)
+    {
+        throw std::runtime_error("!direction: only SOAPY_SDR_RX");
+    }
+    if (format != SOAPY_SDR_CF32)
+    {
+        throw std::runtime_error("!format: only SOAPY_SDR_CF32");
+    }
+    MultiStream *ms = new MultiStream();
+    ms->channels = channels;
+    if (ms->channels.size() == 0)
+    {
+        for (size_t i = 0; i < _devs.size(); i++)
+        {
+            ms->channels.push_back(i);
+        }
+    }
+    for (size_t channel : ms->channels)
+    {
+        if (channel >= _devs.size())
+        {
+            for (size_t i = 0; i < ms->streams.size(); i++)
+            {
+                _devs[ms->channels[i]]->closeStream(ms->streams[i]);
+            }
+            delete ms;
+            throw std::runtime_error("!channels: no such channel");
+        }
+        ms->streams.push_back(_devs[channel]->setupStream(direction, format, std::vector<size_t>(), args));
+    }
+    ms->carry.resize(ms->channels.size());
+    ms->child_next.resize(ms->channels.size(), 0);
+    ms->base.resize(ms->channels.size(), 0);
+    ms->aligned = false;
+    ms->counter = 0;
+    ms->sample_rate = 0.0;
+    ms->mtu = _devs[ms->channels[0]]->getStreamMTU(ms->streams[0]);
+    return (SoapySDR::Stream *) ms;
+}
+
+void SoapyFobosMulti::closeStream(SoapySDR::Stream *stream)
+{
+    MultiStream *ms = (MultiStream *) stream;
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        _devs[ms->channels[i]]->closeStream(ms->streams[i]);
+    }
+    delete ms;
+}
+
+size_t SoapyFobosMulti::getStreamMTU(SoapySDR::Stream *stream) const
+{
+    return ((MultiStream *) stream)->mtu;
+}
+
+int SoapyFobosMulti::activateStream(
+        SoapySDR::Stream *stream,
+        const int flags,
+        const long long timeNs,
+        const size_t numElems)
+{
+    MultiStream *ms = (MultiStream *) stream;
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        ms->carry[i].clear();
+        ms->child_next[i] = 0;
+        ms->base[i] = 0;
+    }
+    ms->aligned = false;
+    ms->counter = 0;
+    ms->sample_rate = _devs[ms->channels[0]]->getSampleRate(SOAPY_SDR_RX, 0);
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        int r = _devs[ms->channels[i]]->activateStream(ms->streams[i], flags, timeNs, numElems);
+        if (r != 0)
+        {
+            return r;
+        }
+    }
+    return 0;
+}
+
+int SoapyFobosMulti::deactivateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs)
+{
+    MultiStream *ms = (MultiStream *) stream;
+    int result = 0;
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        int r = _devs[ms->channels[i]]->deactivateStream(ms->streams[i], flags, timeNs);
+        result = (result == 0) ? r : result;
+    }
+    return result;
+}
+
+// The devices are started one after another, so their sample #0 are apart by
+// the USB start latency. The start of each stream is estimated from the
+// buffer arrival times, the earlier streams drop their leading samples.
+// Fine correction is up to the user ("sample_offset" channel setting), the
+// shared reference keeps the streams aligned afterwards.
+bool SoapyFobosMulti::align(MultiStream *ms)
+{
+    std::vector<long long> epochs;
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        long long epoch = _devs[ms->channels[i]]->stream_epoch_ns();
+        if (epoch == 0)
+        {
+            return false;
+        }
+        epochs.push_back(epoch);
+    }
+    long long latest = *std::max_element(epochs.begin(), epochs.end());
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        ms->base[i] = llround((latest - epochs[i]) * ms->sample_rate / 1E9) + _sample_offsets[ms->channels[i]];
+    }
+    long long min_base = *std::min_element(ms->base.begin(), ms->base.end());
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        ms->base[i] -= min_base;
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "channel %d aligned by %lld samples", (int)ms->channels[i], ms->base[i]);
+    }
+    ms->counter = 0;
+    ms->aligned = true;
+    return true;
+}
+
+// Reads up to count samples of the channel i, keeps the child sample counter
+// and tells about the gaps (the child has dropped samples).
+int SoapyFobosMulti::read_child(MultiStream *ms, size_t i, float *dst, size_t count, int &flags, bool &gap, const long timeoutUs)
+{
+    int child_flags = 0;
+    long long child_time = 0;
+    void *buffs[1] = {dst};
+    int r = _devs[ms->channels[i]]->readStream(ms->streams[i], buffs, count, child_flags, child_time, timeoutUs);
+    if (r == SOAPY_SDR_OVERFLOW)
+    {
+        // the child has been lapped, the time stamp of the next read shows the gap
+        r = _devs[ms->channels[i]]->readStream(ms->streams[i], buffs, count, child_flags, child_time, timeoutUs);
+    }
+    if (r <= 0)
+    {
+        return r;
+    }
+    if (child_flags & SOAPY_SDR_HAS_TIME)
+    {
+        long long ticks = SoapySDR::timeNsToTicks(child_time, ms->sample_rate);
+        if (ticks != ms->child_next[i])
+        {
+            gap = true;
+            ms->child_next[i] = ticks;
+        }
+    }
+    ms->child_next[i] += r;
+    flags |= child_flags & FOBOS_FLAG_GAIN_CHANGED;
+    return r;
+}
+
+// Drops the samples of the channel i preceding the composite sample counter.
+int SoapyFobosMulti::drop_leading(MultiStream *ms, size_t i, const long timeoutUs)
+{
+    std::vector<float> &carry = ms->carry[i];
+    long long position = ms->child_next[i] - (long long)carry.size() / 2;
+    long long excess = ms->counter + ms->base[i] - position;
+    if (excess <= 0)
+    {
+        return 0;
+    }
+    size_t from_carry = std::min((size_t)excess, carry.size() / 2);
+    carry.erase(carry.begin(), carry.begin() + from_carry * 2);
+    excess -= from_carry;
+    std::vector<float> scratch(std::min((size_t)excess, ms->mtu) * 2);
+    while (excess > 0)
+    {
+        int flags = 0;
+        bool gap = false;
+        int r = read_child(ms, i, scratch.data(), std::min((size_t)excess, ms->mtu), flags, gap, timeoutUs);
+        if (r <= 0)
+        {
+            return SOAPY_SDR_TIMEOUT;
+        }
+        if (gap)
+        {
+            return SOAPY_SDR_OVERFLOW;
+        }
+        excess -= r;
+    }
+    return 0;
+}
+
+// Some device has dropped samples: everything read ahead is dropped and all
+// the channels continue from the first sample every one of them still has.
+void SoapyFobosMulti::resync(MultiStream *ms)
+{
+    long long target = ms->counter;
+    for (size_t i = 0; i < ms->channels.size(); i++)
+    {
+        ms->carry[i].clear();
+        target = std::max(target, ms->child_next[i] - ms->base[i]);
+    }
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "re-aligned, %lld samples skipped", target - ms->counter);
+    ms->counter = target;
+}
+
+int SoapyFobosMulti::readStream(
+        SoapySDR::Stream *stream,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    MultiStream *ms = (MultiStream *) stream;
+    size_t nch = ms->channels.size();
+    flags = 0;
+    if (!ms->aligned && !align(ms))
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeoutUs, 1000L)));
+        return SOAPY_SDR_TIMEOUT;
+    }
+    for (size_t i = 0; i < nch; i++)
+    {
+        int r = drop_leading(ms, i, timeoutUs);
+        if (r == SOAPY_SDR_OVERFLOW)
+        {
+            resync(ms);
+        }
+        if (r != 0)
+        {
+            return r;
+        }
+    }
+    // channel 0 reads what is there, the others catch up with it
+    std::vector<size_t> got(nch, 0);
+    bool gap = false;
+    for (size_t i = 0; i < nch; i++)
+    {
+        float *dst = (float *) buffs[i];
+        std::vector<float> &carry = ms->carry[i];
+        size_t from_carry = std::min(carry.size() / 2, numElems);
+        memcpy(dst, carry.data(), from_carry * 2 * sizeof(float));
+        carry.erase(carry.begin(), carry.begin() + from_carry * 2);
+        got[i] = from_carry;
+        size_t need = (i == 0) ? ((got[0] > 0) ? got[0] : 1) : got[0];
+        while (got[i] < need)
+        {
+            int r = read_child(ms, i, dst + got[i] * 2, numElems - got[i], flags, gap, timeoutUs);
+            if (r <= 0)
+            {
+                break;
+            }
+            got[i] += r;
+        }
+    }
+    if (gap)
+    {
+        resync(ms);
+        return SOAPY_SDR_OVERFLOW;
+    }
+    size_t count = *std::min_element(got.begin(), got.end());
+    for (size_t i = 0; i < nch; i++)
+    {
+        // keep the excess for the next call
+        const float *src = (const float *) buffs[i];
+        ms->carry[i].insert(ms->carry[i].begin(), src + count * 2, src + got[i] * 2);
+    }
+    if (count == 0)
+    {
+        return SOAPY_SDR_TIMEOUT;
+    }
+    timeNs = SoapySDR::ticksToTimeNs(ms->counter + ms->base[0], ms->sample_rate);
+    flags |= SOAPY_SDR_HAS_TIME;
+    ms->counter += count;
+    return count;
+}
+
+/*******************************************************************
+ * Antenna API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosMulti::listAntennas(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->listAntennas(direction, 0);
+}
+
+void SoapyFobosMulti::setAntenna(const int direction, const size_t channel, const std::string &name)
+{
+    child(direction, channel)->setAntenna(direction, 0, name);
+}
+
+std::string SoapyFobosMulti::getAntenna(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getAntenna(direction, 0);
+}
+
+/*******************************************************************
+ * Gain API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosMulti::listGains(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->listGains(direction, 0);
+}
+
+bool SoapyFobosMulti::hasGainMode(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->hasGainMode(direction, 0);
+}
+
+void SoapyFobosMulti::setGainMode(const int direction, const size_t channel, const bool automatic)
+{
+    child(direction, channel)->setGainMode(direction, 0, automatic);
+}
+
+bool SoapyFobosMulti::getGainMode(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getGainMode(direction, 0);
+}
+
+void SoapyFobosMulti::setGain(const int direction, const size_t channel, const std::string &name, const double value)
+{
+    child(direction, channel)->setGain(direction, 0, name, value);
+}
+
+double SoapyFobosMulti::getGain(const int direction, const size_t channel, const std::string &name) const
+{
+    return child(direction, channel)->getGain(direction, 0, name);
+}
+
+SoapySDR::Range SoapyFobosMulti::getGainRange(const int direction, const size_t channel, const std::string &name) const
+{
+    return child(direction, channel)->getGainRange(direction, 0, name);
+}
+
+/*******************************************************************
+ * Frontend corrections API
+ ******************************************************************/
+
+bool SoapyFobosMulti::hasFrequencyCorrection(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->hasFrequencyCorrection(direction, 0);
+}
+
+void SoapyFobosMulti::setFrequencyCorrection(const int direction, const size_t channel, const double value)
+{
+    child(direction, channel)->setFrequencyCorrection(direction, 0, value);
+}
+
+double SoapyFobosMulti::getFrequencyCorrection(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getFrequencyCorrection(direction, 0);
+}
+
+/*******************************************************************
+ * Frequency API
+ ******************************************************************/
+
+// the receivers split the frequency among their components themselves
+void SoapyFobosMulti::setFrequency(
+        const int direction,
+        const size_t channel,
+        const double frequency,
+        const SoapySDR::Kwargs &args)
+{
+    child(direction, channel)->setFrequency(direction, 0, frequency, args);
+}
+
+void SoapyFobosMulti::setFrequency(
+        const int direction,
+        const size_t channel,
+        const std::string &name,
+        const double frequency,
+        const SoapySDR::Kwargs &args)
+{
+    child(direction, channel)->setFrequency(direction, 0, name, frequency, args);
+}
+
+double SoapyFobosMulti::getFrequency(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getFrequency(direction, 0);
+}
+
+double SoapyFobosMulti::getFrequency(const int direction, const size_t channel, const std::string &name) const
+{
+    return child(direction, channel)->getFrequency(direction, 0, name);
+}
+
+std::vector<std::string> SoapyFobosMulti::listFrequencies(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->listFrequencies(direction, 0);
+}
+
+SoapySDR::RangeList SoapyFobosMulti::getFrequencyRange(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getFrequencyRange(direction, 0);
+}
+
+SoapySDR::RangeList SoapyFobosMulti::getFrequencyRange(const int direction, const size_t channel, const std::string &name) const
+{
+    return child(direction, channel)->getFrequencyRange(direction, 0, name);
+}
+
+/*******************************************************************
+ * Sample Rate API
+ ******************************************************************/
+
+void SoapyFobosMulti::setSampleRate(const int direction, const size_t channel, const double rate)
+{
+    // the channels are only coherent at one rate
+    (void)channel;
+    for (auto dev : _devs)
+    {
+        dev->setSampleRate(direction, 0, rate);
+    }
+}
+
+double SoapyFobosMulti::getSampleRate(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getSampleRate(direction, 0);
+}
+
+std::vector<double> SoapyFobosMulti::listSampleRates(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->listSampleRates(direction, 0);
+}
+
+SoapySDR::RangeList SoapyFobosMulti::getSampleRateRange(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->getSampleRateRange(direction, 0);
+}
+
+/*******************************************************************
+ * Sensor API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosMulti::listSensors(const int direction, const size_t channel) const
+{
+    return child(direction, channel)->listSensors(direction, 0);
+}
+
+SoapySDR::ArgInfo SoapyFobosMulti::getSensorInfo(const int direction, const size_t channel, const std::string &key) const
+{
+    return child(direction, channel)->getSensorInfo(direction, 0, key);
+}
+
+std::string SoapyFobosMulti::readSensor(const int direction, const size_t channel, const std::string &key) const
+{
+    return child(direction, channel)->readSensor(direction, 0, key);
+}
+
+/*******************************************************************
+ * Settings API
+ ******************************************************************/
+
+SoapySDR::ArgInfoList SoapyFobosMulti::getSettingInfo(void) const
+{
+    return _devs[0]->getSettingInfo();
+}
+
+// device settings go to all the devices
+void SoapyFobosMulti::writeSetting(const std::string &key, const std::string &value)
+{
+    for (auto dev : _devs)
+    {
+        dev->writeSetting(key, value);
+    }
+}
+
+std::string SoapyFobosMulti::readSetting(const std::string &key) const
+{
+    return _devs[0]->readSetting(key);
+}
+
+const std::vector<SoapyFobosSDR*> &SoapyFobosMulti::devices(void) const
+{
+    return _devs;
+}
+
+SoapySDR::ArgInfoList SoapyFobosMulti::getSettingInfo(const int direction, const size_t channel) const
+{
+    SoapySDR::ArgInfoList args = child(direction, channel)->getSettingInfo();
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "sample_offset";
+        info.value = "0";
+        info.name = "Sample Offset";
+        info.description = "Alignment correction of this channel against the others, applied on activateStream()";
+        info.units = "samples";
+        info.type = SoapySDR::ArgInfo::INT;
+        args.push_back(info);
+    }
+    return args;
+}
+
+// channel settings go to the device of the channel
+void SoapyFobosMulti::writeSetting(const int direction, const size_t channel, const std::string &key, const std::string &value)
+{
+    SoapyFobosSDR *dev = child(direction, channel);
+    if (key == "sample_offset")
+    {
+        _sample_offsets[channel] = std::stoll(value);
+        return;
+    }
+    dev->writeSetting(key, value);
+}
+
+std::string SoapyFobosMulti::readSetting(const int direction, const size_t channel, const std::string &key) const
+{
+    SoapyFobosSDR *dev = child(direction, channel);
+    if (key == "sample_offset")
+    {
+        return std::to_string(_sample_offsets[channel]);
+    }
+    return dev->readSetting(key);
+}
+//==============================================================================
@@ -0,0 +1,312 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - VITA-49 UDP output
+//  18.10.2026 - lossless compressed CS12Z payloads
+//==============================================================================
+
+#include "SoapyFobosNet.hpp"
+#include "SoapyFobosDsp.hpp"
+#include "SoapyFobosCodec.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+SoapyFobosNet * soapy_fobos_net_create(const SoapySDR::Kwargs &args)
+{
+    const std::string address = args.at("udp_stream");
+    size_t colon = address.rfind(':');
+    if ((colon == std::string::npos) || (colon == 0))
+    {
+        throw std::runtime_error("udp_stream=" + address + ": host:port expected");
+    }
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+    int format = FOBOS_NET_CS16;
+    if (args.count("udp_format") != 0)
+    {
+        const std::string &name = args.at("udp_format");
+        if (name == SOAPY_SDR_CS8)
+        {
+            format = FOBOS_NET_CS8;
+        }
+        else if (name == SOAPY_SDR_CF32)
+        {
+            format = FOBOS_NET_CF32;
+        }
+        else if (name == "CS12Z")
+        {
+            format = FOBOS_NET_CS12Z;
+        }
+        else if (name != SOAPY_SDR_CS16)
+        {
+            throw std::runtime_error("udp_format=" + name + ": only CS16, CS8, CF32, CS12Z");
+        }
+    }
+    size_t mtu = FOBOS_NET_MTU;
+    if (args.count("udp_mtu") != 0)
+    {
+        mtu = std::stoul(args.at("udp_mtu"));
+        // a compressed payload takes at least one whole block
+        size_t least = FOBOS_NET_IP_UDP_LEN + FOBOS_VRT_HEADER_WORDS * 4 + FOBOS_Z12_HEADER + FOBOS_Z12_BLOCK_MAX;
+        if ((format == FOBOS_NET_CS12Z) && (mtu < least))
+        {
+            throw std::runtime_error("udp_mtu=" + args.at("udp_mtu") + ": at least " + std::to_string(least) + " for CS12Z");
+        }
+    }
+    int ttl = 1;
+    if (args.count("udp_ttl") != 0)
+    {
+        ttl = std::stoi(args.at("udp_ttl"));
+    }
+    uint32_t stream_id = 1;
+    if (args.count("udp_stream_id") != 0)
+    {
+        stream_id = (uint32_t)std::stoul(args.at("udp_stream_id"), nullptr, 0);
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *info = nullptr;
+    int r = getaddrinfo(host.c_str(), port.c_str(), &hints, &info);
+    if ((r != 0) || (info == nullptr))
+    {
+        throw std::runtime_error("udp_stream=" + address + ": " + gai_strerror(r));
+    }
+    SoapyFobosNet *net = new SoapyFobosNet();
+    net->address = address;
+    net->addr.assign((uint8_t *)info->ai_addr, (uint8_t *)info->ai_addr + info->ai_addrlen);
+    freeaddrinfo(info);
+    net->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (net->fd < 0)
+    {
+        delete net;
+        throw std::runtime_error(std::string("socket() failed: ") + strerror(errno));
+    }
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)net->addr.data();
+    if (IN_MULTICAST(ntohl(sin->sin_addr.s_addr)))
+    {
+        unsigned char value = (unsigned char)ttl;
+        setsockopt(net->fd, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value));
+        // the receivers on this host get the group too
+        value = 1;
+        setsockopt(net->fd, IPPROTO_IP, IP_MULTICAST_LOOP, &value, sizeof(value));
+        if (args.count("udp_iface") != 0)
+        {
+            struct in_addr iface;
+            if (inet_pton(AF_INET, args.at("udp_iface").c_str(), &iface) != 1)
+            {
+                close(net->fd);
+                delete net;
+                throw std::runtime_error("udp_iface=" + args.at("udp_iface") + ": IPv4 address expected");
+            }
+            setsockopt(net->fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+        }
+    }
+    // a full socket buffer drops datagrams instead of stalling the transfers
+    int sndbuf = 4 << 20;
+    setsockopt(net->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    net->format = format;
+    size_t payload = (mtu > FOBOS_NET_IP_UDP_LEN + FOBOS_VRT_HEADER_WORDS * 4 + 8) ?
+            mtu - FOBOS_NET_IP_UDP_LEN - FOBOS_VRT_HEADER_WORDS * 4 : 8;
+    if (format == FOBOS_NET_CS12Z)
+    {
+        net->sample_bytes = 0;
+        net->samples_per_packet = 0;
+        net->payload_bytes = std::min(payload & ~(size_t)3, (size_t)(0xffff - FOBOS_VRT_HEADER_WORDS) * 4);
+        // the encoder writes up to a block past the payload before taking it back
+        net->packet_bytes = FOBOS_VRT_HEADER_WORDS * 4 + (net->payload_bytes + FOBOS_Z12_BLOCK_MAX + 3) / 4 * 4;
+    }
+    else
+    {
+        net->sample_bytes = (format == FOBOS_NET_CS8) ? 2 : ((format == FOBOS_NET_CS16) ? 4 : 8);
+        // whole 32 bit words, CS8 samples come in pairs
+        net->samples_per_packet = std::min((payload / net->sample_bytes) & ~(size_t)1, (size_t)(0xffff - FOBOS_VRT_HEADER_WORDS) * 4 / net->sample_bytes);
+        net->payload_bytes = net->samples_per_packet * net->sample_bytes;
+        net->packet_bytes = FOBOS_VRT_HEADER_WORDS * 4 + net->payload_bytes;
+    }
+    net->stream_id = stream_id;
+    net->packet_count = 0;
+    net->packets = 0;
+    net->dropped = 0;
+    net->packets_data.resize(FOBOS_NET_BATCH * net->packet_bytes);
+    net->packets_len.resize(FOBOS_NET_BATCH);
+    if (format == FOBOS_NET_CS12Z)
+    {
+        SoapySDR_logf(SOAPY_SDR_INFO, "Sending VITA-49 to %s, compressed in %d bytes per datagram", address.c_str(), (int)net->payload_bytes);
+    }
+    else
+    {
+        SoapySDR_logf(SOAPY_SDR_INFO, "Sending VITA-49 to %s, %d samples per datagram", address.c_str(), (int)net->samples_per_packet);
+    }
+    return net;
+}
+
+void soapy_fobos_net_close(SoapyFobosNet *net)
+{
+    if (net == nullptr)
+    {
+        return;
+    }
+    close(net->fd);
+    delete net;
+}
+
+// the big endian payload of one datagram
+static void net_payload(const SoapyFobosNet *net, const float *samples, size_t count, uint8_t *dst)
+{
+    if (net->format == FOBOS_NET_CS8)
+    {
+        fobos_cf32_to_cs8(samples, (int8_t *)dst, count);
+    }
+    else if (net->format == FOBOS_NET_CS16)
+    {
+        uint16_t *words = (uint16_t *)dst;
+        fobos_cf32_to_cs16(samples, (int16_t *)words, count);
+        for (size_t i = 0; i < count * 2; i++)
+        {
+            words[i] = htons(words[i]);
+        }
+    }
+    else
+    {
+        uint32_t *words = (uint32_t *)dst;
+        memcpy(words, samples, count * 2 * sizeof(float));
+        for (size_t i = 0; i < count * 2; i++)
+        {
+            words[i] = htonl(words[i]);
+        }
+    }
+}
+
+static void net_flush(SoapyFobosNet *net, size_t batch)
+{
+    size_t sent = 0;
+#ifdef __linux__
+    struct mmsghdr msgs[FOBOS_NET_BATCH];
+    struct iovec iovs[FOBOS_NET_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < batch; i++)
+    {
+        iovs[i].iov_base = net->packets_data.data() + i * net->packet_bytes;
+        iovs[i].iov_len = net->packets_len[i];
+        msgs[i].msg_hdr.msg_name = net->addr.data();
+        msgs[i].msg_hdr.msg_namelen = (socklen_t)net->addr.size();
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (sent < batch)
+    {
+        int r = sendmmsg(net->fd, msgs + sent, (unsigned int)(batch - sent), MSG_DONTWAIT);
+        if (r <= 0)
+        {
+            // the socket buffer is full or the network is down
+            net->dropped += batch - sent;
+            break;
+        }
+        sent += r;
+        net->packets += r;
+    }
+#else
+    for (; sent < batch; sent++)
+    {
+        ssize_t r = sendto(net->fd, net->packets_data.data() + sent * net->packet_bytes, net->packets_len[sent],
+                MSG_DONTWAIT, (const struct sockaddr *)net->addr.data(), (socklen_t)net->addr.size());
+        if (r < 0)
+        {
+            net->dropped++;
+            continue;
+        }
+        net->packets++;
+    }
+#endif
+}
+
+void soapy_fobos_net_send(SoapyFobosNet *net, const float *samples, size_t count, uint64_t counter)
+{
+    size_t batch = 0;
+    for (size_t done = 0; done < count; )
+    {
+        uint8_t *packet = net->packets_data.data() + batch * net->packet_bytes;
+        size_t len;
+        size_t bytes;
+        if (net->format == FOBOS_NET_CS12Z)
+        {
+            bytes = fobos_z12_encode(samples + done * 2, count - done, packet + FOBOS_VRT_HEADER_WORDS * 4,
+                    net->payload_bytes, len);
+        }
+        else
+        {
+            len = std::min(count - done, net->samples_per_packet);
+            bytes = len * net->sample_bytes;
+        }
+        // an odd CS8 count or a compressed stream is padded to a whole word
+        size_t words = FOBOS_VRT_HEADER_WORDS + (bytes + 3) / 4;
+        memset(packet + FOBOS_VRT_HEADER_WORDS * 4 + bytes, 0, words * 4 - FOBOS_VRT_HEADER_WORDS * 4 - bytes);
+        uint32_t *header = (uint32_t *)packet;
+        header[0] = htonl((FOBOS_VRT_IF_DATA_SID << 28) | (FOBOS_VRT_TSF_SAMPLES << 20) |
+                ((net->packet_count & 0xf) << 16) | (uint32_t)words);
+        header[1] = htonl(net->stream_id);
+        uint64_t timestamp = counter + done;
+        header[2] = htonl((uint32_t)(timestamp >> 32));
+        header[3] = htonl((uint32_t)timestamp);
+        if (net->format != FOBOS_NET_CS12Z)
+        {
+            net_payload(net, samples + done * 2, len, packet + FOBOS_VRT_HEADER_WORDS * 4);
+        }
+        net->packets_len[batch] = words * 4;
+        net->packet_count++;
+        done += len;
+        batch++;
+        if (batch == FOBOS_NET_BATCH)
+        {
+            net_flush(net, batch);
+            batch = 0;
+        }
+    }
+    if (batch > 0)
+    {
+        net_flush(net, batch);
+    }
+}
+
+#else
+
+SoapyFobosNet * soapy_fobos_net_create(const SoapySDR::Kwargs &args)
+{
+    (void)args;
+    throw std::runtime_error("udp_stream is not supported on this platform");
+}
+
+void soapy_fobos_net_close(SoapyFobosNet *net)
+{
+    (void)net;
+}
+
+void soapy_fobos_net_send(SoapyFobosNet *net, const float *samples, size_t count, uint64_t counter)
+{
+    (void)net;
+    (void)samples;
+    (void)count;
+    (void)counter;
+}
+
+#endif
+//==============================================================================
@@ -0,0 +1,235 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - work stealing pool of the streaming thread stages
+//==============================================================================
+
+#include "SoapyFobosPipeline.hpp"
+#include <algorithm>
+#include <cstdio>
+
+static const char* stage_names[FOBOS_STAGE_COUNT] = {"mix", "push", "resample", "pack", "publish"};
+
+static inline uint64_t range_pack(size_t front, size_t back)
+{
+    return ((uint64_t)front << 32) | (uint64_t)back;
+}
+
+static inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+// the owner takes its chunks from the front
+static bool take_front(std::atomic<uint64_t> &range, size_t &chunk)
+{
+    uint64_t r = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        size_t front = (size_t)(r >> 32);
+        size_t back = (size_t)(uint32_t)r;
+        if (front >= back)
+        {
+            return false;
+        }
+        if (range.compare_exchange_weak(r, range_pack(front + 1, back), std::memory_order_acq_rel))
+        {
+            chunk = front;
+            return true;
+        }
+    }
+}
+
+// the thieves from the back, away from the owner
+static bool take_back(std::atomic<uint64_t> &range, size_t &chunk)
+{
+    uint64_t r = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        size_t front = (size_t)(r >> 32);
+        size_t back = (size_t)(uint32_t)r;
+        if (front >= back)
+        {
+            return false;
+        }
+        if (range.compare_exchange_weak(r, range_pack(front, back - 1), std::memory_order_acq_rel))
+        {
+            chunk = back - 1;
+            return true;
+        }
+    }
+}
+//==============================================================================
+
+SoapyFobosPipeline::SoapyFobosPipeline(size_t threads):
+    _threads(std::min(std::max(threads, (size_t)1), (size_t)FOBOS_DSP_THREADS_MAX)),
+    _queues(nullptr),
+    _job(nullptr),
+    _left(0),
+    _generation(0),
+    _stop(false)
+{
+    reset_timing();
+    _queues = new Queue [_threads];
+    for (size_t i = 0; i < _threads; i++)
+    {
+        _queues[i].range = 0;
+    }
+    for (size_t i = 1; i < _threads; i++)
+    {
+        _workers.push_back(std::thread(&SoapyFobosPipeline::worker_loop, this, i));
+    }
+}
+
+SoapyFobosPipeline::~SoapyFobosPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start_cond.notify_all();
+    for (auto & worker : _workers)
+    {
+        worker.join();
+    }
+    delete [] _queues;
+}
+
+size_t SoapyFobosPipeline::chunk_len(size_t count, size_t min_len) const
+{
+    if ((_threads == 1) || (count <= min_len))
+    {
+        return std::max(count, (size_t)1);
+    }
+    size_t len = std::max((count + max_chunks() - 1) / max_chunks(), min_len);
+    return (len + FOBOS_CHUNK_ALIGN - 1) / FOBOS_CHUNK_ALIGN * FOBOS_CHUNK_ALIGN;
+}
+
+size_t SoapyFobosPipeline::chunks(size_t count, size_t min_len) const
+{
+    size_t len = chunk_len(count, min_len);
+    return (count + len - 1) / len;
+}
+
+void SoapyFobosPipeline::run_job(int stage, size_t count, size_t min_len, Call call, void* task)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t len = chunk_len(count, min_len);
+    size_t n = (count + len - 1) / len;
+    if ((_threads == 1) || (n <= 1))
+    {
+        for (size_t chunk = 0; chunk < n; chunk++)
+        {
+            call(task, chunk, chunk * len, std::min(len, count - chunk * len));
+        }
+        account(stage, start);
+        return;
+    }
+    Job job;
+    job.call = call;
+    job.task = task;
+    job.stage = stage;
+    job.count = count;
+    job.len = len;
+    _left.store(n, std::memory_order_relaxed);
+    _job.store(&job, std::memory_order_release);
+    // the chunks are visible to the thieves as soon as a range is stored
+    for (size_t i = 0; i < _threads; i++)
+    {
+        _queues[i].range.store(range_pack(i * n / _threads, (i + 1) * n / _threads), std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _generation++;
+    }
+    _start_cond.notify_all();
+    work(0);
+    if (_left.load(std::memory_order_acquire) != 0)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done_cond.wait(lock, [this]{ return _left.load(std::memory_order_acquire) == 0; });
+    }
+    StageTime &t = _times[stage];
+    t.runs++;
+    t.wall_ns += elapsed_ns(start);
+}
+
+// Takes the own chunks first, then steals from the others, returns when
+// there are none left to take. A thread woken up late may take the chunks
+// of the next job, the job is read after the chunk has been taken.
+void SoapyFobosPipeline::work(size_t self)
+{
+    for (size_t k = 0; k < _threads; k++)
+    {
+        size_t victim = (self + k) % _threads;
+        size_t chunk;
+        while ((k == 0) ? take_front(_queues[victim].range, chunk) : take_back(_queues[victim].range, chunk))
+        {
+            const Job* job = _job.load(std::memory_order_acquire);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            size_t first = chunk * job->len;
+            job->call(job->task, chunk, first, std::min(job->len, job->count - first));
+            _times[job->stage].busy_ns += elapsed_ns(start);
+            if (_left.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _done_cond.notify_one();
+            }
+        }
+    }
+}
+
+void SoapyFobosPipeline::worker_loop(size_t self)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start_cond.wait(lock, [&]{ return _stop || (_generation != seen); });
+            if (_stop)
+            {
+                return;
+            }
+            seen = _generation;
+        }
+        work(self);
+    }
+}
+
+void SoapyFobosPipeline::account(int stage, std::chrono::steady_clock::time_point start)
+{
+    uint64_t ns = elapsed_ns(start);
+    StageTime &t = _times[stage];
+    t.runs++;
+    t.wall_ns += ns;
+    t.busy_ns += ns;
+}
+
+void SoapyFobosPipeline::reset_timing(void)
+{
+    for (size_t i = 0; i < FOBOS_STAGE_COUNT; i++)
+    {
+        _times[i].runs = 0;
+        _times[i].wall_ns = 0;
+        _times[i].busy_ns = 0;
+    }
+}
+
+std::string SoapyFobosPipeline::timing(double elapsed) const
+{
+    std::string result;
+    for (size_t i = 0; i < FOBOS_STAGE_COUNT; i++)
+    {
+        double busy = _times[i].busy_ns.load() * 1E-9;
+        char text[128];
+        snprintf(text, sizeof(text), "%s%s,%llu,%.3f,%.3f,%.3f", result.empty() ? "" : ";", stage_names[i],
+                (unsigned long long)_times[i].runs.load(), _times[i].wall_ns.load() * 1E-6, busy * 1E3,
+                (elapsed > 0.0) ? busy / elapsed : 0.0);
+        result += text;
+    }
+    return result;
+}
+//==============================================================================
@@ -4,10 +4,20 @@
 //  LGPL-2.1 or above LICENSE
 //  05.06.2024
 //  01.04.2026 - added support for fobos-sdr-agile
+//  18.10.2026 - list devices kept open by the handle pool
+//  18.10.2026 - "serials" opens several devices as one multi-channel device
+//  18.10.2026 - "shm" attaches to the ring exported by another process
+//  18.10.2026 - "replay" streams a capture file
+//  19.10.2026 - exported registration of the receive callback
+//  19.10.2026 - and of the detection callback
 //==============================================================================
 
 #include "SoapyFobosSDR.hpp"
+#include "SoapyFobosMulti.hpp"
+#include "SoapyFobosShm.hpp"
+#include "SoapyFobosCapture.hpp"
 #include <SoapySDR/Registry.hpp>
+#include <SoapySDR/Errors.h>
 #include <string.h>
 #include <mutex>
 #include <map>
@@ -53,12 +63,177 @@ static std::vector<SoapySDR::Kwargs> findSDR(const SoapySDR::Kwargs &args)
         
         results.push_back(devInfo);
     }
+    // devices released to the warm handle pool are still open by this process
+    for (auto & handle : soapy_fobos_pool_list())
+    {
+        if ((args.count("serial") != 0) && (args.at("serial") != handle.serial))
+        {
+            continue;
+        }
+        bool listed = false;
+        for (auto & result : results)
+        {
+            listed = listed || (result.at("serial") == handle.serial);
+        }
+        if (!listed)
+        {
+            SoapySDR::Kwargs devInfo;
+            devInfo["label"] = handle.dev_agile ? "Fobos SDR (agile)" : "Fobos SDR";
+            devInfo["serial"] = handle.serial;
+            devInfo["manufacturer"] = "RigExpert";
+            results.push_back(devInfo);
+        }
+    }
+    return results;
+}
+
+static std::vector<SoapySDR::Kwargs> findMultiSDR(const SoapySDR::Kwargs &args)
+{
+    std::vector<SoapySDR::Kwargs> results;
+    SoapySDR::Kwargs any_args = args;
+    any_args.erase("serials");
+    std::vector<SoapySDR::Kwargs> found = findSDR(any_args);
+    std::vector<std::string> serials = SoapyFobosMulti::split_serials(args.at("serials"));
+    for (auto & serial : serials)
+    {
+        bool present = false;
+        for (auto & devInfo : found)
+        {
+            present = present || (devInfo.at("serial") == serial);
+        }
+        if (!present)
+        {
+            SoapySDR_logf(SOAPY_SDR_DEBUG, "device %s not found", serial.c_str());
+            return results;
+        }
+    }
+    SoapySDR::Kwargs devInfo;
+    devInfo["label"] = "Fobos SDR x" + std::to_string(serials.size());
+    devInfo["serials"] = args.at("serials");
+    devInfo["manufacturer"] = "RigExpert";
+    results.push_back(devInfo);
+    return results;
+}
+
+static std::vector<SoapySDR::Kwargs> findShmSDR(const SoapySDR::Kwargs &args)
+{
+    std::vector<SoapySDR::Kwargs> results;
+    SoapyFobosShm *shm = soapy_fobos_shm_open(args.at("shm"));
+    if (shm == nullptr)
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "shm %s not found", args.at("shm").c_str());
+        return results;
+    }
+    SoapySDR::Kwargs devInfo;
+    devInfo["label"] = "Fobos SDR (shared " + args.at("shm") + ")";
+    devInfo["shm"] = args.at("shm");
+    devInfo["serial"] = shm->header->serial;
+    devInfo["manufacturer"] = "RigExpert";
+    results.push_back(devInfo);
+    soapy_fobos_shm_close(shm);
+    return results;
+}
+
+static std::vector<SoapySDR::Kwargs> findReplaySDR(const SoapySDR::Kwargs &args)
+{
+    std::vector<SoapySDR::Kwargs> results;
+    SoapyFobosCapture *capture = nullptr;
+    try
+    {
+        capture = soapy_fobos_capture_open(args.at("replay"));
+    }
+    catch (const std::exception &e)
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "replay %s", e.what());
+        return results;
+    }
+    SoapySDR::Kwargs devInfo;
+    devInfo["label"] = "Fobos SDR (replay " + args.at("replay") + ")";
+    devInfo["replay"] = args.at("replay");
+    devInfo["serial"] = std::string(capture->header->serial, strnlen(capture->header->serial, sizeof(capture->header->serial)));
+    devInfo["manufacturer"] = "RigExpert";
+    results.push_back(devInfo);
+    soapy_fobos_capture_close(capture);
     return results;
 }
 
+static std::vector<SoapySDR::Kwargs> findDevices(const SoapySDR::Kwargs &args)
+{
+    if (args.count("replay") != 0)
+    {
+        return findReplaySDR(args);
+    }
+    if (args.count("shm") != 0)
+    {
+        return findShmSDR(args);
+    }
+    if (args.count("serials") != 0)
+    {
+        return findMultiSDR(args);
+    }
+    return findSDR(args);
+}
+
 static SoapySDR::Device *makeSDR(const SoapySDR::Kwargs &args)
 {
+    if (args.count("replay") != 0)
+    {
+        return new SoapyFobosReplay(args);
+    }
+    if (args.count("shm") != 0)
+    {
+        return new SoapyFobosShmClient(args);
+    }
+    if (args.count("serials") != 0)
+    {
+        return new SoapyFobosMulti(args);
+    }
     return new SoapyFobosSDR(args);
 }
 
-static SoapySDR::Registry registerFobosSDR("fobos", &findSDR, &makeSDR, SOAPY_SDR_ABI_VERSION);
+static SoapySDR::Registry registerFobosSDR("fobos", &findDevices, &makeSDR, SOAPY_SDR_ABI_VERSION);
+
+/***********************************************************************
+ * Callbacks of the in-process consumers, SoapyFobosPush.hpp and
+ * SoapyFobosDetect.hpp. Only a device made above is ever cast, whatever
+ * the application passes: a multi-channel one registers with every receiver.
+ **********************************************************************/
+
+static std::vector<SoapyFobosSDR*> receivers(SoapySDR::Device *device)
+{
+    SoapyFobosMulti *multi = dynamic_cast<SoapyFobosMulti *>(device);
+    if (multi != nullptr)
+    {
+        return multi->devices();
+    }
+    SoapyFobosSDR *sdr = dynamic_cast<SoapyFobosSDR *>(device);
+    return (sdr != nullptr) ? std::vector<SoapyFobosSDR*>(1, sdr) : std::vector<SoapyFobosSDR*>();
+}
+
+int soapy_fobos_set_rx_callback(SoapySDR::Device *device, SoapyFobosRxCallback callback, void *user)
+{
+    std::vector<SoapyFobosSDR*> devs = receivers(device);
+    if (devs.empty())
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    for (auto dev : devs)
+    {
+        dev->set_rx_hook(callback, user);
+    }
+    return 0;
+}
+
+int soapy_fobos_set_detection_callback(SoapySDR::Device *device, SoapyFobosDetectionCallback callback, void *user)
+{
+    std::vector<SoapyFobosSDR*> devs = receivers(device);
+    if (devs.empty())
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    for (auto dev : devs)
+    {
+        dev->set_detection_hook(callback, user);
+    }
+    return 0;
+}
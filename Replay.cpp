@@ -0,0 +1,450 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Device streaming a capture file made by the recorder
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - compressed capture files, decoded a chunk at a time
+//  19.10.2026 - readStream() flags are output only
+//==============================================================================
+
+#include "SoapyFobosCapture.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Time.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const char* format_names[] = {SOAPY_SDR_CF32, SOAPY_SDR_CS16, SOAPY_SDR_CS12, "CS12Z"};
+
+SoapyFobosReplay::SoapyFobosReplay(const SoapySDR::Kwargs &args):
+    _capture(nullptr),
+    _frequency(0.0),
+    _gain(0.0)
+{
+    _capture = soapy_fobos_capture_open(args.at("replay"));
+    if (_capture->chunks_count > 0)
+    {
+        _frequency = _capture->chunk(0)->frequency;
+        _gain = _capture->chunk(0)->gain;
+    }
+    const SoapyFobosCaptureHeader *header = _capture->header;
+    SoapySDR_logf(SOAPY_SDR_INFO, "Replaying %s: %.1f s of %s at %.0f S/s", _capture->path.c_str(),
+            _capture->chunks_count * header->chunk_len / header->sample_rate, format_names[header->format], header->sample_rate);
+}
+
+SoapyFobosReplay::~SoapyFobosReplay(void)
+{
+    for (auto rs : _streams)
+    {
+        delete rs;
+    }
+    soapy_fobos_capture_close(_capture);
+}
+
+/*******************************************************************
+ * Identification API
+ ******************************************************************/
+
+std::string SoapyFobosReplay::getDriverKey(void) const
+{
+    return "Fobos SDR";
+}
+
+std::string SoapyFobosReplay::getHardwareKey(void) const
+{
+    return "RigExpert Fobos SDR (replay)";
+}
+
+SoapySDR::Kwargs SoapyFobosReplay::getHardwareInfo(void) const
+{
+    const SoapyFobosCaptureHeader *header = _capture->header;
+    SoapySDR::Kwargs info;
+    info["replay"] = _capture->path;
+    info["serial"] = std::string(header->serial, strnlen(header->serial, sizeof(header->serial)));
+    info["format"] = format_names[header->format];
+    info["chunks"] = std::to_string((unsigned long long)_capture->chunks_count);
+    info["seconds"] = std::to_string(_capture->chunks_count * header->chunk_len / header->sample_rate);
+    return info;
+}
+
+/*******************************************************************
+ * Channels API
+ ******************************************************************/
+
+size_t SoapyFobosReplay::getNumChannels(const int direction) const
+{
+    return (direction == SOAPY_SDR_RX) ? 1 : 0;
+}
+
+/*******************************************************************
+ * Stream API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosReplay::getStreamFormats(const int direction, const size_t channel) const
+{
+    (void)channel;
+    std::vector<std::string> formats;
+    if (direction == SOAPY_SDR_RX)
+    {
+        formats.push_back(SOAPY_SDR_CF32);
+        formats.push_back(SOAPY_SDR_CS16);
+    }
+    return formats;
+}
+
+std::string SoapyFobosReplay::getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const
+{
+    (void)direction;
+    (void)channel;
+    if (_capture->header->format == FOBOS_RING_CF32)
+    {
+        fullScale = 1.0;
+        return SOAPY_SDR_CF32;
+    }
+    fullScale = 32767.0;
+    return SOAPY_SDR_CS16;
+}
+
+SoapySDR::ArgInfoList SoapyFobosReplay::getStreamArgsInfo(const int direction, const size_t channel) const
+{
+    (void)channel;
+    SoapySDR::ArgInfoList result;
+    if (direction == SOAPY_SDR_RX)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "skip_below";
+        info.value = "";
+        info.name = "Skip quiet chunks";
+        info.description = "Chunks with the mean power below it are left out, the last samples before a gap come with SOAPY_SDR_END_BURST";
+        info.units = "dBFS";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        result.push_back(info);
+    }
+    return result;
+}
+
+SoapySDR::Stream *SoapyFobosReplay::setupStream(
+        const int direction,
+        const std::string &format,
+        const std::vector<size_t> &channels,
+        const SoapySDR::Kwargs &args)
+{
+    if (direction != SOAPY_SDR_RX)
+    {
+        throw std::runtime_error("!direction: only SOAPY_SDR_RX");
+    }
+    if (channels.size() > 1 or (channels.size() > 0 and channels.at(0) != 0))
+    {
+        throw std::runtime_error("!channels: only one");
+    }
+    if ((format != SOAPY_SDR_CF32) && (format != SOAPY_SDR_CS16))
+    {
+        throw std::runtime_error("!format: only SOAPY_SDR_CF32, SOAPY_SDR_CS16");
+    }
+    ReplayStream *rs = new ReplayStream();
+    rs->active = false;
+    rs->cs16 = (format == SOAPY_SDR_CS16);
+    rs->skip_below = 0.0f;
+    rs->decoded_chunk = UINT64_MAX;
+    if (args.count("skip_below") != 0)
+    {
+        rs->skip_below = powf(10.0f, std::stof(args.at("skip_below")) / 10.0f);
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    seek(rs, (_capture->chunks_count > 0) ? _capture->index[0].counter : 0);
+    _streams.push_back(rs);
+    return (SoapySDR::Stream *) rs;
+}
+
+void SoapyFobosReplay::closeStream(SoapySDR::Stream *stream)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _streams.erase(std::find(_streams.begin(), _streams.end(), (ReplayStream *) stream));
+    delete (ReplayStream *) stream;
+}
+
+size_t SoapyFobosReplay::getStreamMTU(SoapySDR::Stream *stream) const
+{
+    (void)stream;
+    return _capture->header->chunk_len;
+}
+
+// SOAPY_SDR_HAS_TIME: starts at the sample counter time timeNs, otherwise
+// where the stream has stopped
+int SoapyFobosReplay::activateStream(
+        SoapySDR::Stream *stream,
+        const int flags,
+        const long long timeNs,
+        const size_t numElems)
+{
+    (void)numElems;
+    if ((flags & ~SOAPY_SDR_HAS_TIME) != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    ReplayStream *rs = (ReplayStream *) stream;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (flags & SOAPY_SDR_HAS_TIME)
+    {
+        seek(rs, SoapySDR::timeNsToTicks(timeNs, _capture->header->sample_rate));
+    }
+    rs->active = true;
+    return 0;
+}
+
+int SoapyFobosReplay::deactivateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs)
+{
+    (void)timeNs;
+    if (flags != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    ((ReplayStream *) stream)->active = false;
+    return 0;
+}
+
+// The first chunk from chunk on the stream reads, by the index alone
+uint64_t SoapyFobosReplay::next_chunk(const ReplayStream *rs, uint64_t chunk) const
+{
+    if (rs->skip_below > 0.0f)
+    {
+        while ((chunk < _capture->chunks_count) && (_capture->index[chunk].power < rs->skip_below))
+        {
+            chunk++;
+        }
+    }
+    return chunk;
+}
+
+void SoapyFobosReplay::seek(ReplayStream *rs, long long counter)
+{
+    rs->chunk = soapy_fobos_capture_find(_capture, counter);
+    rs->pos = 0;
+    if ((rs->chunk < _capture->chunks_count) && (_capture->index[rs->chunk].counter < counter))
+    {
+        rs->pos = counter - _capture->index[rs->chunk].counter;
+    }
+    else
+    {
+        rs->chunk = next_chunk(rs, rs->chunk);
+    }
+    rs->gain = (rs->chunk < _capture->chunks_count) ? _capture->chunk(rs->chunk)->gain : 0.0;
+}
+
+int SoapyFobosReplay::readStream(
+        SoapySDR::Stream *stream,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    (void)timeoutUs;
+    ReplayStream *rs = (ReplayStream *) stream;
+    flags = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!rs->active || (rs->chunk >= _capture->chunks_count))
+    {
+        // the end of the file
+        return 0;
+    }
+    const SoapyFobosCaptureHeader *header = _capture->header;
+    const SoapyFobosCaptureChunk *chunk = _capture->chunk(rs->chunk);
+    const void *data = _capture->chunk_data(rs->chunk);
+    int format = header->format;
+    if (format == FOBOS_CAPTURE_CS12Z)
+    {
+        if (rs->decoded_chunk != rs->chunk)
+        {
+            rs->decoded.resize(header->chunk_len * 2);
+            if (fobos_z12_decode((const uint8_t *)data, chunk->bytes, rs->decoded.data(), header->chunk_len) != header->chunk_len)
+            {
+                SoapySDR_logf(SOAPY_SDR_ERROR, "%s: chunk %llu damaged, left out", _capture->path.c_str(),
+                        (unsigned long long)rs->chunk);
+                rs->chunk = next_chunk(rs, rs->chunk + 1);
+                rs->pos = 0;
+                return SOAPY_SDR_CORRUPTION;
+            }
+            rs->decoded_chunk = rs->chunk;
+        }
+        data = rs->decoded.data();
+        format = FOBOS_RING_CF32;
+    }
+    size_t samples_count = std::min((size_t)header->chunk_len - rs->pos, numElems);
+    if (!rs->cs16)
+    {
+        fobos_ring_unpack(format, data, rs->pos, (float *)buffs[0], samples_count);
+    }
+    else if (format == FOBOS_RING_CS16)
+    {
+        memcpy(buffs[0], (const int16_t *)data + rs->pos * 2, samples_count * 2 * sizeof(int16_t));
+    }
+    else
+    {
+        rs->expanded.resize(samples_count * 2);
+        fobos_ring_unpack(format, data, rs->pos, rs->expanded.data(), samples_count);
+        fobos_cf32_to_cs16(rs->expanded.data(), (int16_t *)buffs[0], samples_count);
+    }
+    if ((rs->pos == 0) && (chunk->gain != rs->gain))
+    {
+        flags |= FOBOS_FLAG_GAIN_CHANGED;
+        rs->gain = chunk->gain;
+    }
+    _frequency = chunk->frequency;
+    _gain = chunk->gain;
+    timeNs = SoapySDR::ticksToTimeNs(chunk->counter + rs->pos, header->sample_rate);
+    flags |= SOAPY_SDR_HAS_TIME;
+    rs->pos += samples_count;
+    if (rs->pos >= header->chunk_len)
+    {
+        uint64_t next = next_chunk(rs, rs->chunk + 1);
+        if ((next != rs->chunk + 1) || (next == _capture->chunks_count))
+        {
+            // quiet chunks left out or the end of the file
+            flags |= SOAPY_SDR_END_BURST;
+        }
+        rs->chunk = next;
+        rs->pos = 0;
+    }
+    return samples_count;
+}
+
+/*******************************************************************
+ * Frequency API
+ ******************************************************************/
+
+void SoapyFobosReplay::setFrequency(
+        const int direction,
+        const size_t channel,
+        const std::string &name,
+        const double frequency,
+        const SoapySDR::Kwargs &args)
+{
+    (void)direction;
+    (void)channel;
+    (void)name;
+    (void)args;
+    if (frequency != getFrequency(SOAPY_SDR_RX, 0, "RF"))
+    {
+        throw std::runtime_error("replay: the frequency is the recorded one");
+    }
+}
+
+double SoapyFobosReplay::getFrequency(const int direction, const size_t channel, const std::string &name) const
+{
+    (void)direction;
+    (void)channel;
+    (void)name;
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _frequency;
+}
+
+std::vector<std::string> SoapyFobosReplay::listFrequencies(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    std::vector<std::string> names;
+    names.push_back("RF");
+    return names;
+}
+
+/*******************************************************************
+ * Gain API
+ ******************************************************************/
+
+double SoapyFobosReplay::getGain(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _gain;
+}
+
+/*******************************************************************
+ * Sample Rate API
+ ******************************************************************/
+
+void SoapyFobosReplay::setSampleRate(const int direction, const size_t channel, const double rate)
+{
+    (void)direction;
+    (void)channel;
+    if (rate != _capture->header->sample_rate)
+    {
+        throw std::runtime_error("replay: the sample rate is the recorded one");
+    }
+}
+
+double SoapyFobosReplay::getSampleRate(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    return _capture->header->sample_rate;
+}
+
+std::vector<double> SoapyFobosReplay::listSampleRates(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    std::vector<double> rates;
+    rates.push_back(_capture->header->sample_rate);
+    return rates;
+}
+
+/*******************************************************************
+ * Settings API
+ ******************************************************************/
+
+SoapySDR::ArgInfoList SoapyFobosReplay::getSettingInfo(void) const
+{
+    SoapySDR::ArgInfoList setArgs;
+    SoapySDR::ArgInfo info;
+    info.key = "seek";
+    info.value = "0";
+    info.name = "Position";
+    info.description = "Seconds from the start of the file all the streams continue at";
+    info.units = "s";
+    info.type = SoapySDR::ArgInfo::FLOAT;
+    info.range = SoapySDR::Range(0.0, _capture->chunks_count * _capture->header->chunk_len / _capture->header->sample_rate);
+    setArgs.push_back(info);
+    return setArgs;
+}
+
+void SoapyFobosReplay::writeSetting(const std::string &key, const std::string &value)
+{
+    if (key == "seek")
+    {
+        if (_capture->chunks_count == 0)
+        {
+            return;
+        }
+        long long counter = _capture->index[0].counter + llround(std::stod(value) * _capture->header->sample_rate);
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto rs : _streams)
+        {
+            seek(rs, counter);
+        }
+    }
+}
+
+std::string SoapyFobosReplay::readSetting(const std::string &key) const
+{
+    if (key == "seek")
+    {
+        // the position of the first stream
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_streams.empty() || (_capture->chunks_count == 0))
+        {
+            return "0";
+        }
+        const ReplayStream *rs = _streams.front();
+        long long counter = (rs->chunk < _capture->chunks_count) ?
+                _capture->index[rs->chunk].counter + rs->pos :
+                _capture->index[_capture->chunks_count - 1].counter + _capture->header->chunk_len;
+        return std::to_string((counter - _capture->index[0].counter) / _capture->header->sample_rate);
+    }
+    return "";
+}
+//==============================================================================
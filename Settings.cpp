@@ -6,17 +6,50 @@
 //  10.11.2025 - open by index support
 //  15.01.2026 - open by serial, specify clock_source by @oleksandrchumakovpaysera 
 //  01.04.2026 - added support for fobos-sdr-agile
+//  18.10.2026 - warm device handle pool, "pool_idle" argument
+//  18.10.2026 - query APIs answered from the capability descriptor
+//  18.10.2026 - tuning, gains and settings go through the control queue
+//  18.10.2026 - software AGC, "agc_target" and "agc_hysteresis" settings
+//  18.10.2026 - signal statistics sensors
+//  18.10.2026 - "shm_export" argument
+//  18.10.2026 - "ring_format" argument
+//  18.10.2026 - "rx_callback" setting of the push model API
+//  18.10.2026 - "wakeups" sensor
+//  18.10.2026 - "BB" and "CORR" frequency components, setFrequency() with "tolerance"
+//  18.10.2026 - "udp_stream" argument, "udp_packets" and "udp_dropped" sensors
+//  18.10.2026 - "dsp_threads" argument, "dsp_stages" sensor
+//  18.10.2026 - "history_seconds" and "history_format" arguments, "snapshot" setting
+//  18.10.2026 - "notify_fd:" setting of the readiness descriptors
+//  18.10.2026 - "record_buffer" and "record_format" arguments, "record" setting
+//  18.10.2026 - "CS12Z" record_format, lossless compressed
+//  18.10.2026 - setSampleRate() goes through the control queue, "latency" argument
+//  19.10.2026 - "reference" and "correlator_*" settings, detections
+//  19.10.2026 - the pool is asked by index too
+//  19.10.2026 - rx_gain is the gain of the stream read last
+//  19.10.2026 - setSampleRate() rejects rates above the highest native one, throws when not applied
+//  19.10.2026 - direct sampling and clock source probed on the device, LNA range of its steps
+//  19.10.2026 - the center frequency is stored once applied
+//  19.10.2026 - "rx_callback" is read only, see Registration.cpp
+//  19.10.2026 - "detection_callback" is read only as well
 //==============================================================================
 
 #include "SoapyFobosSDR.hpp"
+#include "SoapyFobosShm.hpp"
+#include "SoapyFobosHistory.hpp"
+#include "SoapyFobosCapture.hpp"
+#include "SoapyFobosCorrelator.hpp"
+#include <SoapySDR/Formats.hpp>
 #include <SoapySDR/Time.hpp>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <sstream>
 
 SoapyFobosSDR::SoapyFobosSDR(const SoapySDR::Kwargs &args):
     _device_index(0),
     _dev_stock(nullptr),
     _dev_agile(nullptr), 
+    _pool_idle(0.0),
     _sample_rate(25000000.0),
     _center_frequency(100000000.0),
     _direct_sampling(0),
@@ -25,10 +58,101 @@ SoapyFobosSDR::SoapyFobosSDR(const SoapySDR::Kwargs &args):
     _lna_gain_scale(1.0 / 16.0),
     _vga_gain(0),
     _vga_gain_scale(1.0 / 2.0),
+    _resample_interp(1),
+    _resample_decim(1),
+    _resample_changed(false),
+    _resampler(nullptr),
+    _bb_frequency(0.0),
+    _freq_correction(0.0),
+    _nco_changed(false),
+    _ctrl(),
+    _ctrl_applied(),
+    _ctrl_pending(false),
+    _ctrl_async(false),
+    _ctrl_stop(false),
+    _ctrl_gain_epoch(0),
+    _ctrl_gain_db(0.0),
+    _ctrl_rate_epoch(0),
+    _agc_enabled(false),
+    _agc_target(AGC_TARGET_DBFS),
+    _agc_hysteresis(AGC_HYSTERESIS_DB),
+    _agc_lna_idx(LNA_IDX_MIN),
+    _agc_vga_idx(VGA_IDX_MIN),
+    _agc_holdoff(0),
+    _ring_format(FOBOS_RING_CF32),
     _rx_bufs(0),
+    _rx_stage(nullptr),
+    _rx_mix(nullptr),
+    _rx_resampled(nullptr),
+    _rx_slots(0),
+    _rx_gain_read(0.0),
     _rx_buffs_count(DEFAULT_BUFS_COUNT),
     _rx_buff_len(DEFAULT_BUFF_LEN),
-    _rx_filled(0)
+    _rx_slot_cap(DEFAULT_BUFF_LEN),
+    _rx_slot_len(DEFAULT_BUFF_LEN),
+    _rx_ring_pos(0),
+    _rx_pos_start(0),
+    _rx_fill(0),
+    _rx_fill_idx(0),
+    _rx_fill_gain_epoch(0),
+    _rx_fill_gain(0.0),
+    _rx_seq_w(0),
+    _rx_seq_done(0),
+    _rx_pos_done(0),
+    _rx_seq_start(0),
+    _rx_wake_at(UINT64_MAX),
+    _rx_wakeups(0),
+    _rx_start_ns(0),
+    _overruns_count(0),
+    _rx_power(nullptr),
+    _rx_triggers(0),
+    _rx_noise_floor(0.0f),
+    _rx_epoch_ns(0),
+    _rx_stop_at(0),
+    _rx_in_pos(0),
+    _latency(0.0),
+    _rx_rate_epoch(0),
+    _rx_rate(25000000.0),
+    _rx_native(25000000.0),
+    _rx_rate_counter(0),
+    _rx_rate_time_ns(0),
+    _rx_rate_in(0),
+    _rx_counter_ns(0),
+    _rx_restart(false),
+    _rx_buff_next(DEFAULT_BUFF_LEN),
+    _rx_restart_ns(0),
+    _rx_restarted(false),
+    _rx_stopping(false),
+    _streams_active(0),
+    _lost_samples(0),
+    _spill_count(0),
+    _rx_notifies(0),
+    _push(),
+    _push_set(false),
+    _rx_pushed(0),
+    _shm(nullptr),
+    _net(nullptr),
+    _net_packets(0),
+    _net_dropped(0),
+    _dsp_threads(1),
+    _pipeline(nullptr),
+    _history_seconds(0.0),
+    _history_format(FOBOS_RING_CS16),
+    _snap_running(false),
+    _record_buffer(2.0),
+    _record_format(FOBOS_RING_CS16),
+    _rec_stop(false),
+    _corr_threshold(FOBOS_CORRELATOR_THRESHOLD),
+    _corr_offset(0.0),
+    _corr_window(0),
+    _corr_epoch(0),
+    _corr_stop(false),
+    _corr_hook(),
+    _corr_hook_set(false),
+    _corr_count(0),
+    _corr_lost(0),
+    _corr_fft_len(0),
+    _stats_count(0)
 {
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
     printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
@@ -45,6 +169,121 @@ SoapyFobosSDR::SoapyFobosSDR(const SoapySDR::Kwargs &args):
     int count_agile = 0;
     char serials[256] = {0};
 
+    const auto it_pool = args.find("pool_idle");
+    if (it_pool != args.end())
+    {
+        _pool_idle = std::stod(it_pool->second);
+    }
+    if (args.count("shm_export") != 0)
+    {
+        // the ring is created in shared memory by the first setupStream()
+        _shm_name = args.at("shm_export");
+    }
+    if (args.count("udp_stream") != 0)
+    {
+        // the socket is opened by the first setupStream()
+        for (auto & arg : args)
+        {
+            if (arg.first.compare(0, 4, "udp_") == 0)
+            {
+                _net_args[arg.first] = arg.second;
+            }
+        }
+    }
+    if (args.count("dsp_threads") != 0)
+    {
+        // the pool is started by the first setupStream(), 0 - one thread per core
+        _dsp_threads = std::stoul(args.at("dsp_threads"));
+        if (_dsp_threads == 0)
+        {
+            _dsp_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+    }
+    if (args.count("history_seconds") != 0)
+    {
+        // allocated by activateStream() for the rate it streams at
+        _history_seconds = std::stod(args.at("history_seconds"));
+    }
+    if (args.count("history_format") != 0)
+    {
+        const std::string &history_format = args.at("history_format");
+        if (history_format == SOAPY_SDR_CF32)
+        {
+            _history_format = FOBOS_RING_CF32;
+        }
+        else if (history_format == SOAPY_SDR_CS12)
+        {
+            _history_format = FOBOS_RING_CS12;
+        }
+        else if (history_format != SOAPY_SDR_CS16)
+        {
+            throw std::runtime_error("history_format=" + history_format + ": only CF32, CS16, CS12");
+        }
+    }
+    if (args.count("record_buffer") != 0)
+    {
+        _record_buffer = std::stod(args.at("record_buffer"));
+    }
+    if (args.count("record_format") != 0)
+    {
+        const std::string &record_format = args.at("record_format");
+        if (record_format == SOAPY_SDR_CF32)
+        {
+            _record_format = FOBOS_RING_CF32;
+        }
+        else if (record_format == SOAPY_SDR_CS12)
+        {
+            _record_format = FOBOS_RING_CS12;
+        }
+        else if (record_format == "CS12Z")
+        {
+            _record_format = FOBOS_CAPTURE_CS12Z;
+        }
+        else if (record_format != SOAPY_SDR_CS16)
+        {
+            throw std::runtime_error("record_format=" + record_format + ": only CF32, CS16, CS12, CS12Z");
+        }
+    }
+    if (args.count("ring_format") != 0)
+    {
+        // samples are packed in the ring and expanded by readStream()
+        const std::string &ring_format = args.at("ring_format");
+        if (ring_format == SOAPY_SDR_CS16)
+        {
+            _ring_format = FOBOS_RING_CS16;
+        }
+        else if (ring_format == SOAPY_SDR_CS12)
+        {
+            _ring_format = FOBOS_RING_CS12;
+        }
+        else if (ring_format != SOAPY_SDR_CF32)
+        {
+            throw std::runtime_error("ring_format=" + ring_format + ": only CF32, CS16, CS12");
+        }
+    }
+    if (args.count("latency") != 0)
+    {
+        // the transfers, so the ring slots, follow the sample rate
+        _latency = std::stod(args.at("latency"));
+        if (_latency < 0.0)
+        {
+            throw std::runtime_error("latency=" + args.at("latency") + ": seconds >= 0");
+        }
+    }
+    {
+        // Reuse the warm handle if the device has been released recently,
+        // this process still holds it open and could not open it again
+        // without a serial the devices are only listed when pooling is on
+        std::string pooled = ((_pool_idle > 0.0) || (args.count("serial") != 0)) ? pooled_serial(args) : "";
+        SoapyFobosHandle handle;
+        if (!pooled.empty() && soapy_fobos_pool_take(pooled, handle))
+        {
+            restore_handle(handle);
+            SoapySDR_logf(SOAPY_SDR_DEBUG, "device %s taken from the pool", serial);
+            return;
+        }
+    }
+
     fobos_rx_get_api_info(lib_stock_version, drv_stock_version);
     printf("API Info lib (stock): %s drv: %s\n", lib_stock_version, drv_stock_version); 
     fobos_sdr_get_api_info(lib_agile_version, drv_agile_version);
@@ -137,6 +376,7 @@ SoapyFobosSDR::SoapyFobosSDR(const SoapySDR::Kwargs &args):
             SoapySDR_logf(SOAPY_SDR_ERROR, "Unable to obtain devoce info");
         }
     }
+    build_caps();
 }
 
 SoapyFobosSDR::~SoapyFobosSDR(void)
@@ -144,6 +384,30 @@ SoapyFobosSDR::~SoapyFobosSDR(void)
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
     printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
 #endif
+    rx_stop();
+    if (_snap_thread.joinable())
+    {
+        // the snapshot being written is finished
+        _snap_thread.join();
+    }
+    for (auto st : _streams)
+    {
+        delete st;
+    }
+    _streams.clear();
+    ring_free();
+    delete _resampler;
+    _resampler = nullptr;
+    delete _pipeline;
+    _pipeline = nullptr;
+    if ((_pool_idle > 0.0) && (serial[0] != 0))
+    {
+        // Keep the handle open for the next makeSDR() with the same serial
+        SoapyFobosHandle handle;
+        save_handle(handle);
+        soapy_fobos_pool_put(handle, _pool_idle);
+        return;
+    }
     if (_dev_stock)
     {
         fobos_rx_close(_dev_stock);
@@ -154,6 +418,147 @@ SoapyFobosSDR::~SoapyFobosSDR(void)
     }
 }
 
+void SoapyFobosSDR::build_caps(void)
+{
+    unsigned int count = 0;
+    int r = -1;
+    _caps = SoapyFobosCaps();
+    _caps.agile = (_dev_agile != nullptr);
+    if (_dev_stock)
+    {
+        r = fobos_rx_get_samplerates(_dev_stock, 0, &count);
+    }
+    else if (_dev_agile)
+    {
+        r = fobos_sdr_get_samplerates(_dev_agile, 0, &count);
+    }
+    if ((r == 0) && (count > 0))
+    {
+        _caps.sample_rates.resize(count);
+        if (_dev_stock)
+        {
+            fobos_rx_get_samplerates(_dev_stock, _caps.sample_rates.data(), &count);
+        }
+        else if (_dev_agile)
+        {
+            fobos_sdr_get_samplerates(_dev_agile, _caps.sample_rates.data(), &count);
+        }
+        _caps.sample_rates.resize(count);
+        std::sort(_caps.sample_rates.begin(), _caps.sample_rates.end());
+    }
+    if (_caps.sample_rates.size() > 0)
+    {
+        // rates between the native ones are made by the resampler
+        _caps.sample_rate_range.push_back(SoapySDR::Range(_caps.sample_rates.front() / RESAMPLE_MAX_DECIM, _caps.sample_rates.back()));
+    }
+    if (hw_revision[0] == '4')
+    {
+        _caps.frequency_range.push_back(SoapySDR::Range(50E6, 9100E6));
+    }
+    else
+    {
+        _caps.frequency_range.push_back(SoapySDR::Range(50E6, 6000E6));
+    }
+    // one step per hardware index, the top one included
+    _caps.lna_gain_range = SoapySDR::Range(0.0, (LNA_IDX_MAX - LNA_IDX_MIN) / _lna_gain_scale, 1.0 / _lna_gain_scale);
+    _caps.vga_gain_range = SoapySDR::Range(VGA_IDX_MIN / _vga_gain_scale, VGA_IDX_MAX / _vga_gain_scale, 1.0 / _vga_gain_scale);
+    // there is no query for them: the state the device has just been opened
+    // with is set again, a library or firmware without them refuses it
+    if (_dev_stock)
+    {
+        _caps.has_direct_sampling = (fobos_rx_set_direct_sampling(_dev_stock, _direct_sampling) == 0);
+        _caps.has_clock_source = (fobos_rx_set_clk_source(_dev_stock, _clock_source) == 0);
+    }
+    else if (_dev_agile)
+    {
+        _caps.has_direct_sampling = (fobos_sdr_set_direct_sampling(_dev_agile, _direct_sampling) == 0);
+        _caps.has_clock_source = (fobos_sdr_set_clk_source(_dev_agile, _clock_source) == 0);
+    }
+}
+
+void SoapyFobosSDR::save_handle(SoapyFobosHandle &handle) const
+{
+    handle.device_index = _device_index;
+    handle.dev_stock = _dev_stock;
+    handle.dev_agile = _dev_agile;
+    memcpy(handle.lib_stock_version, lib_stock_version, INFO_LEN);
+    memcpy(handle.lib_agile_version, lib_agile_version, INFO_LEN);
+    memcpy(handle.drv_stock_version, drv_stock_version, INFO_LEN);
+    memcpy(handle.drv_agile_version, drv_agile_version, INFO_LEN);
+    memcpy(handle.hw_revision, hw_revision, INFO_LEN);
+    memcpy(handle.fw_version, fw_version, INFO_LEN);
+    memcpy(handle.manufacturer, manufacturer, INFO_LEN);
+    memcpy(handle.product, product, INFO_LEN);
+    memcpy(handle.serial, serial, INFO_LEN);
+    handle.caps = _caps;
+    handle.sample_rate = _sample_rate * _resample_decim / _resample_interp;     // the native one
+    handle.center_frequency = _center_frequency;
+    handle.direct_sampling = _direct_sampling;
+    handle.clock_source = _clock_source;
+    handle.lna_gain = _lna_gain;
+    handle.vga_gain = _vga_gain;
+    handle.applied = _ctrl_applied;
+}
+
+// The serial of the device the args ask for: "serial", else the one at "index"
+// among the devices listed, else "" (not pooled, the index is opened as usual)
+std::string SoapyFobosSDR::pooled_serial(const SoapySDR::Kwargs &args)
+{
+    if (args.count("serial") != 0)
+    {
+        return args.at("serial");
+    }
+    int index = (args.count("index") != 0) ? std::stoi(args.at("index")) : 0;
+    char serials_stock[256] = {0};
+    char serials_agile[256] = {0};
+    int count_stock = fobos_rx_list_devices(serials_stock);
+    int count_agile = fobos_sdr_list_devices(serials_agile);
+    std::vector<std::string> listed;
+    std::istringstream stock((count_stock > 0) ? serials_stock : "");
+    std::istringstream agile((count_agile > 0) ? serials_agile : "");
+    std::string item;
+    while (stock >> item)
+    {
+        listed.push_back(item);
+    }
+    while (agile >> item)
+    {
+        listed.push_back(item);
+    }
+    if ((index >= 0) && ((size_t)index < listed.size()))
+    {
+        return listed[index];
+    }
+    return "";
+}
+
+void SoapyFobosSDR::restore_handle(const SoapyFobosHandle &handle)
+{
+    _device_index = handle.device_index;
+    _dev_stock = handle.dev_stock;
+    _dev_agile = handle.dev_agile;
+    memcpy(lib_stock_version, handle.lib_stock_version, INFO_LEN);
+    memcpy(lib_agile_version, handle.lib_agile_version, INFO_LEN);
+    memcpy(drv_stock_version, handle.drv_stock_version, INFO_LEN);
+    memcpy(drv_agile_version, handle.drv_agile_version, INFO_LEN);
+    memcpy(hw_revision, handle.hw_revision, INFO_LEN);
+    memcpy(fw_version, handle.fw_version, INFO_LEN);
+    memcpy(manufacturer, handle.manufacturer, INFO_LEN);
+    memcpy(product, handle.product, INFO_LEN);
+    memcpy(serial, handle.serial, INFO_LEN);
+    _caps = handle.caps;
+    _sample_rate = handle.sample_rate;
+    _center_frequency = handle.center_frequency;
+    _direct_sampling = handle.direct_sampling;
+    _clock_source = handle.clock_source;
+    _lna_gain = handle.lna_gain;
+    _vga_gain = handle.vga_gain;
+    _ctrl_applied = handle.applied;
+    _ctrl_gain_db = applied_gain();
+    // the resampler starts over at the native rate
+    _ctrl_applied.mask &= ~CTRL_SAMPLE_RATE;
+}
+
 /*******************************************************************
  * Identification API
  ******************************************************************/
@@ -195,9 +600,14 @@ SoapySDR::Kwargs SoapyFobosSDR::getHardwareInfo(void) const
  * Channels API
  ******************************************************************/
 
+// direct sampling: HF1 and HF2 (I and Q of the ring) are two real channels
 size_t SoapyFobosSDR::getNumChannels(const int dir) const
 {
-    return (dir == SOAPY_SDR_RX) ? 1 : 0;
+    if (dir != SOAPY_SDR_RX)
+    {
+        return 0;
+    }
+    return _direct_sampling ? 2 : 1;
 }
 
 bool SoapyFobosSDR::getFullDuplex(const int direction, const size_t channel) const
@@ -263,9 +673,31 @@ bool SoapyFobosSDR::hasDCOffsetMode(const int direction, const size_t channel) c
 
 bool SoapyFobosSDR::hasFrequencyCorrection(const int direction, const size_t channel) const
 {
-    (void)direction;
-    (void)channel;
-    return false;
+    return (direction == SOAPY_SDR_RX) && (channel == 0);
+}
+
+// the crystal error is made up for by the NCO, the LO is not retuned
+void SoapyFobosSDR::setFrequencyCorrection(const int direction, const size_t channel, const double value)
+{
+    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "Setting frequency correction: %f ppm", value);
+        {
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
+            _freq_correction = std::min(std::max(value, -CORR_MAX_PPM), CORR_MAX_PPM);
+        }
+        _nco_changed = true;
+    }
+}
+
+double SoapyFobosSDR::getFrequencyCorrection(const int direction, const size_t channel) const
+{
+    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        return _freq_correction;
+    }
+    return 0.0;
 }
 
 /*******************************************************************
@@ -288,8 +720,31 @@ std::vector<std::string> SoapyFobosSDR::listGains(const int direction, const siz
 
 bool SoapyFobosSDR::hasGainMode(const int direction, const size_t channel) const
 {
-    (void)direction;
-    (void)channel;
+    return (direction == SOAPY_SDR_RX) && (channel == 0);
+}
+
+void SoapyFobosSDR::setGainMode(const int direction, const size_t channel, const bool automatic)
+{
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s(%d, %d, %d)\n", __CLASS__, __FUNCTION__, direction, (int)channel, (int)automatic);
+#endif  
+    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    {
+        if (automatic && !_agc_enabled)
+        {
+            agc_start();
+        }
+        _agc_enabled = automatic;
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "AGC: %s", automatic ? "on" : "off");
+    }
+}
+
+bool SoapyFobosSDR::getGainMode(const int direction, const size_t channel) const
+{
+    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    {
+        return _agc_enabled;
+    }
     return false;
 }
 
@@ -313,32 +768,26 @@ void SoapyFobosSDR::setGain(const int direction, const size_t channel, const std
 #endif    
     if ((direction == SOAPY_SDR_RX) && (channel == 0))
     {
+        SoapyFobosControl request;
         if (name == "LNA")
         {
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
             this->_lna_gain = value;
-            unsigned int idx = (round(value * _lna_gain_scale)) + 1;
-            if (_dev_stock)
-            {
-                fobos_rx_set_lna_gain(_dev_stock, idx);
-            }
-            else if (_dev_agile)
-            {
-                fobos_sdr_set_lna_gain(_dev_agile, idx);
-            }
+            request.mask = CTRL_LNA_GAIN;
+            request.lna_idx = (round(value * _lna_gain_scale)) + 1;
         }
         else if (name == "VGA")
         {
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
             this->_vga_gain = value;
-            unsigned int idx = uint8_t(round(value * _vga_gain_scale));
-            if (_dev_stock)
-            {
-                fobos_rx_set_vga_gain(_dev_stock, idx);
-            }
-            else if (_dev_agile)
-            {
-                fobos_sdr_set_vga_gain(_dev_agile, idx);
-            }
+            request.mask = CTRL_VGA_GAIN;
+            request.vga_idx = uint8_t(round(value * _vga_gain_scale));
+        }
+        else
+        {
+            return;
         }
+        control_submit(request);
     }
 }
 
@@ -350,6 +799,7 @@ double SoapyFobosSDR::getGain(const int direction, const size_t channel, const s
 #endif  
     if ((direction == SOAPY_SDR_RX) && (channel == 0))
     {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
         if (name == "LNA")
         {
             return this->_lna_gain;
@@ -371,11 +821,11 @@ SoapySDR::Range SoapyFobosSDR::getGainRange(const int direction, const size_t ch
     {
         if (name == "LNA")
         {
-            return SoapySDR::Range(0.0, 33.0);
+            return _caps.lna_gain_range;
         }
         if (name == "VGA")
         {
-            return SoapySDR::Range(0.0, 30.0);
+            return _caps.vga_gain_range;
         }
     }
     return SoapySDR::Range(0, 0);
@@ -385,6 +835,41 @@ SoapySDR::Range SoapyFobosSDR::getGainRange(const int direction, const size_t ch
  * Frequency API
  ******************************************************************************/
 /******************************************************************************/
+// With the "tolerance" argument (Hz) a frequency that close to the LO and
+// within the passband is reached by the NCO alone, no PLL retune.
+// Otherwise RF is tuned and BB takes what is left, CORR stays as it is.
+void SoapyFobosSDR::setFrequency(
+        const int direction,
+        const size_t channel,
+        const double frequency,
+        const SoapySDR::Kwargs &args)
+{
+    if ((direction != SOAPY_SDR_RX) || (channel != 0))
+    {
+        return;
+    }
+    const auto it = args.find("tolerance");
+    if ((it != args.end()) && (_direct_sampling == 0))
+    {
+        double rf;
+        double limit;
+        {
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
+            rf = _center_frequency;
+            limit = _sample_rate * BB_PASSBAND;
+        }
+        limit = std::min(limit, std::stod(it->second));
+        if (std::fabs(frequency - rf) <= limit)
+        {
+            setFrequency(direction, channel, "BB", frequency - rf, args);
+            return;
+        }
+    }
+    SoapySDR::Kwargs components = args;
+    components["CORR"] = "IGNORE";
+    SoapySDR::Device::setFrequency(direction, channel, frequency, components);
+}
+/******************************************************************************/
 void SoapyFobosSDR::setFrequency(
         const int direction,
         const size_t channel,
@@ -396,25 +881,33 @@ void SoapyFobosSDR::setFrequency(
     printf(">>> %s::%s(%d, %d, %s, %f)\n", __CLASS__, __FUNCTION__, direction, (int)channel, name.c_str(),  frequency);
 #endif  
     (void)args;
-    double actual;
-    int r = -1;
     if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "RF"))
     {
         SoapySDR_logf(SOAPY_SDR_DEBUG, "Setting center freq: %f", frequency);
-        if (_dev_stock)
-        {
-            r = fobos_rx_set_frequency(_dev_stock, frequency, &actual);
-            _center_frequency = actual;
-        }
-        else if (_dev_agile)
+        SoapyFobosControl request;
+        request.mask = CTRL_FREQUENCY;
+        request.frequency = frequency;
+        // _center_frequency is set by control_apply() once the LO is there,
+        // the NCO follows it. While streaming the request is queued and
+        // errors are only logged
+        if (control_submit(request) != 0)
         {
-            r = fobos_sdr_set_frequency(_dev_agile, frequency);
-            _center_frequency = frequency;
+            throw std::runtime_error("setFrequency failed");
         }
-        if (r != 0)
+    }
+    else if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "BB"))
+    {
+        SoapySDR_logf(SOAPY_SDR_DEBUG, "Setting baseband shift: %f", frequency);
         {
-            throw std::runtime_error("setFrequency failed");
+            std::lock_guard<std::mutex> lock(_ctrl_mutex);
+            double limit = _sample_rate / 2.0;
+            _bb_frequency = std::min(std::max(frequency, -limit), limit);
         }
+        _nco_changed = true;
+    }
+    else if (name == "CORR")
+    {
+        setFrequencyCorrection(direction, channel, frequency);
     }
 }
 /******************************************************************************/
@@ -425,11 +918,28 @@ double SoapyFobosSDR::getFrequency(const int direction, const size_t channel, co
 #endif     
     if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "RF"))
     {
-        return _center_frequency;
+        // the one requested while streaming until the control thread applies it
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        return (_ctrl.mask & CTRL_FREQUENCY) ? _ctrl.frequency : _center_frequency;
+    }
+    if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "BB"))
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        return _bb_frequency;
+    }
+    if (name == "CORR")
+    {
+        return getFrequencyCorrection(direction, channel);
     }
     return 0.0;
 }
 /******************************************************************************/
+// RF + BB, CORR is in ppm and not a part of the sum
+double SoapyFobosSDR::getFrequency(const int direction, const size_t channel) const
+{
+    return getFrequency(direction, channel, "RF") + getFrequency(direction, channel, "BB");
+}
+/******************************************************************************/
 std::vector<std::string> SoapyFobosSDR::listFrequencies(const int direction, const size_t channel) const
 {
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
@@ -439,6 +949,8 @@ std::vector<std::string> SoapyFobosSDR::listFrequencies(const int direction, con
     if ((direction == SOAPY_SDR_RX) && (channel == 0))
     {
         names.push_back("RF");
+        names.push_back("BB");
+        names.push_back("CORR");
     }
     return names;
 }
@@ -451,25 +963,37 @@ SoapySDR::RangeList SoapyFobosSDR::getFrequencyRange(
     SoapySDR::RangeList results;
     if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "RF"))
     {
-        if (hw_revision[0] == '4')
-        {
-            results.push_back(SoapySDR::Range(50E6, 9100E6));
-        }
-        else
-        {
-            results.push_back(SoapySDR::Range(50E6, 6000E6));
-        }
+        results = _caps.frequency_range;
+    }
+    else if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "BB"))
+    {
+        results.push_back(SoapySDR::Range(-_sample_rate / 2.0, _sample_rate / 2.0));
+    }
+    else if ((direction == SOAPY_SDR_RX) && (channel == 0) && (name == "CORR"))
+    {
+        results.push_back(SoapySDR::Range(-CORR_MAX_PPM, CORR_MAX_PPM));
     }
     return results;
 }
 /******************************************************************************/
+SoapySDR::RangeList SoapyFobosSDR::getFrequencyRange(const int direction, const size_t channel) const
+{
+    return getFrequencyRange(direction, channel, "RF");
+}
+/******************************************************************************/
 SoapySDR::ArgInfoList SoapyFobosSDR::getFrequencyArgsInfo(const int direction, const size_t channel) const
 {
     SoapySDR::ArgInfoList freqArgs;
     if ((direction == SOAPY_SDR_RX) && (channel == 0))
     {
-        // TODO: frequency arguments
-        return freqArgs;
+        SoapySDR::ArgInfo info;
+        info.key = "tolerance";
+        info.value = "0";
+        info.name = "Tolerance";
+        info.description = "Frequencies this close to the LO are tuned by the NCO only, up to 0.4 of the sample rate";
+        info.units = "Hz";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        freqArgs.push_back(info);
     }
     return freqArgs;
 }
@@ -484,35 +1008,52 @@ void SoapyFobosSDR::setSampleRate(const int direction, const size_t channel, con
     printf(">>> %s::%s(%d, %d, %f)\n", __CLASS__, __FUNCTION__, direction, (int)channel, rate);
 #endif  
     SoapySDR_logf(SOAPY_SDR_DEBUG, "Setting sample rate: %f", rate);
-    double actual = rate;
-    int r = -1;
-    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    if ((direction == SOAPY_SDR_RX) && (channel < getNumChannels(direction)))
     {
-        if (_dev_stock)
+        // the hardware runs at the nearest native rate at or above the requested one
+        double native = rate;
+        for (double value : _caps.sample_rates)
         {
-            r = fobos_rx_set_samplerate(_dev_stock, rate, &actual);
+            native = value;
+            if (value >= rate * (1.0 - 1E-9))
+            {
+                break;
+            }
         }
-        else if (_dev_agile)
+        // front() / RESAMPLE_MAX_DECIM .. back(), nothing above the highest native rate
+        bool in_range = !_caps.sample_rate_range.empty() &&
+            (rate >= _caps.sample_rate_range.front().minimum() * (1.0 - 1E-9)) &&
+            (rate <= _caps.sample_rate_range.front().maximum() * (1.0 + 1E-9));
+        if (!in_range || (native > rate * RESAMPLE_MAX_DECIM))
         {
-            r = fobos_sdr_set_samplerate(_dev_agile, rate);
+            throw std::runtime_error("setSampleRate(" + std::to_string(rate) + ") is out of the range");
         }
-        if (r == 0)
+        SoapyFobosControl request;
+        request.mask = CTRL_SAMPLE_RATE;
+        request.sample_rate = rate;
+        request.native_rate = native;
+        if (_ctrl_async && (fabs(rate - getSampleRate(direction, channel)) > rate * 1E-9))
         {
-            _sample_rate = actual;
-            SoapySDR_logf(SOAPY_SDR_DEBUG, "actual: %f", actual);
+            // a recording holds one rate, it ends with the slots of this one
+            std::atomic_store(&_rec_buffer, std::shared_ptr<SoapyFobosHistory>());
+            _rec_stop = true;
         }
-        else
+        int r = control_submit(request);
+        if (r != 0)
         {
-            SoapySDR_logf(SOAPY_SDR_DEBUG, "falied, err#: %d", r);
+            SoapySDR_logf(SOAPY_SDR_ERROR, "setSampleRate(%f) failed, err#: %d", rate, r);
+            throw std::runtime_error("setSampleRate failed");
         }
     }
 }
 
 double SoapyFobosSDR::getSampleRate(const int direction, const size_t channel) const
 {
-    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    if ((direction == SOAPY_SDR_RX) && (channel < getNumChannels(direction)))
     {
-        return _sample_rate;
+        // the one requested while streaming until the next transfer applies it
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        return (_ctrl.mask & CTRL_SAMPLE_RATE) ? _ctrl.sample_rate : _sample_rate;
     }
     return 0.0;
 }
@@ -522,35 +1063,10 @@ std::vector<double> SoapyFobosSDR::listSampleRates(const int direction, const si
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
     printf(">>> %s::%s(%d, %d)\n", __CLASS__, __FUNCTION__, direction, (int)channel);
 #endif      
-    unsigned int count;
     std::vector<double> rates;
-    int r = -1;
-    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    if ((direction == SOAPY_SDR_RX) && (channel < getNumChannels(direction)))
     {
-        if (_dev_stock)
-        {
-            r = fobos_rx_get_samplerates(_dev_stock, 0, &count);
-        }
-        else if (_dev_agile)
-        {
-            r = fobos_sdr_get_samplerates(_dev_agile, 0, &count);
-        }
-        if ((r == 0) && (count > 0))
-        {
-            rates.resize(count);
-            if (_dev_stock)
-            {
-                fobos_rx_get_samplerates(_dev_stock, rates.data(), &count);
-            }
-            else if (_dev_agile)
-            {
-                fobos_sdr_get_samplerates(_dev_agile, rates.data(), &count);
-            }
-            if (rates[0] > rates[count - 1])
-            {
-                std::reverse(rates.begin(), rates.end());
-            }
-        }
+        rates = _caps.sample_rates;
     }
     return rates;
 }
@@ -561,41 +1077,197 @@ SoapySDR::RangeList SoapyFobosSDR::getSampleRateRange(const int direction, const
     printf(">>> %s::%s(%d, %d)\n", __CLASS__, __FUNCTION__, direction, (int)channel);
 #endif      
     SoapySDR::RangeList results;
+    if ((direction == SOAPY_SDR_RX) && (channel < getNumChannels(direction)))
+    {
+        results = _caps.sample_rate_range;
+    }
+    return results;
+}
+
+/*******************************************************************
+ * Sensor API
+ ******************************************************************/
+
+static double to_dbfs(float power)
+{
+    return 10.0 * log10(power + 1E-20);
+}
+
+std::vector<std::string> SoapyFobosSDR::listSensors(const int direction, const size_t channel) const
+{
+    std::vector<std::string> sensors;
     if ((direction == SOAPY_SDR_RX) && (channel == 0))
     {
-        std::vector<double> rates;
-        unsigned int count;
-        int r = -1;
-        if (_dev_stock)
+        sensors.push_back("power");
+        sensors.push_back("peak");
+        sensors.push_back("clip_count");
+        sensors.push_back("dc_offset");
+        sensors.push_back("stats_history");
+        sensors.push_back("overruns");
+        sensors.push_back("lost_samples");
+        sensors.push_back("wakeups");
+        sensors.push_back("dsp_stages");
+        if (!_net_args.empty())
         {
-            r = fobos_rx_get_samplerates(_dev_stock, 0, &count);
+            sensors.push_back("udp_packets");
+            sensors.push_back("udp_dropped");
         }
-        else if (_dev_agile)
+    }
+    return sensors;
+}
+
+SoapySDR::ArgInfo SoapyFobosSDR::getSensorInfo(const int direction, const size_t channel, const std::string &key) const
+{
+    (void)direction;
+    (void)channel;
+    SoapySDR::ArgInfo info;
+    info.key = key;
+    if (key == "power")
+    {
+        info.name = "Power";
+        info.description = "Mean power of the last received buffer";
+        info.units = "dBFS";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+    }
+    else if (key == "peak")
+    {
+        info.name = "Peak";
+        info.description = "Peak sample power of the last received buffer";
+        info.units = "dBFS";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+    }
+    else if (key == "clip_count")
+    {
+        info.name = "Clip Count";
+        info.description = "Samples at the ADC limit in the last received buffer";
+        info.type = SoapySDR::ArgInfo::INT;
+    }
+    else if (key == "dc_offset")
+    {
+        info.name = "DC Offset";
+        info.description = "Mean I,Q of the last received buffer";
+        info.type = SoapySDR::ArgInfo::STRING;
+    }
+    else if (key == "stats_history")
+    {
+        info.name = "Statistics History";
+        info.description = "Last buffers, oldest first, ';' separated: buffer#,power dBFS,peak dBFS,clip count,DC I,DC Q";
+        info.type = SoapySDR::ArgInfo::STRING;
+    }
+    else if (key == "overruns")
+    {
+        info.name = "Overruns";
+        info.description = "Buffers lost by the streams since the transfers have started";
+        info.type = SoapySDR::ArgInfo::INT;
+    }
+    else if (key == "lost_samples")
+    {
+        info.name = "Lost Samples";
+        info.description = "Samples skipped by the streams since the transfers have started, the time stamps jump by as many";
+        info.type = SoapySDR::ArgInfo::INT;
+    }
+    else if (key == "udp_packets")
+    {
+        info.name = "UDP Packets";
+        info.description = "VITA-49 datagrams sent";
+        info.type = SoapySDR::ArgInfo::INT;
+    }
+    else if (key == "udp_dropped")
+    {
+        info.name = "UDP Dropped";
+        info.description = "VITA-49 datagrams the socket has not taken";
+        info.type = SoapySDR::ArgInfo::INT;
+    }
+    else if (key == "dsp_stages")
+    {
+        info.name = "DSP Stages";
+        info.description = "Streaming thread stages since the transfers have started, ';' separated: "
+                "stage,runs,wall ms,CPU ms of all the threads,cores (CPU time per second)";
+        info.type = SoapySDR::ArgInfo::STRING;
+    }
+    else if (key == "wakeups")
+    {
+        info.name = "Wakeups";
+        info.description = "Times readStream() of all the streams woke up from sleeping, per second since the transfers have started";
+        info.units = "1/s";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+    }
+    return info;
+}
+
+std::string SoapyFobosSDR::readSensor(const int direction, const size_t channel, const std::string &key) const
+{
+    if ((direction != SOAPY_SDR_RX) || (channel != 0))
+    {
+        return "";
+    }
+    if (key == "overruns")
+    {
+        return std::to_string(_overruns_count.load());
+    }
+    if (key == "lost_samples")
+    {
+        return std::to_string(_lost_samples.load());
+    }
+    if (key == "udp_packets")
+    {
+        return std::to_string(_net_packets.load());
+    }
+    if (key == "udp_dropped")
+    {
+        return std::to_string(_net_dropped.load());
+    }
+    if ((key == "wakeups") || (key == "dsp_stages"))
+    {
+        long long start_ns = _rx_start_ns;
+        long long now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        double elapsed = ((start_ns == 0) || (now_ns <= start_ns)) ? 0.0 : (now_ns - start_ns) * 1E-9;
+        if (key == "dsp_stages")
         {
-            r = fobos_sdr_get_samplerates(_dev_agile, 0, &count);
+            return _pipeline ? _pipeline->timing(elapsed) : "";
         }
-        if ((r == 0) && (count > 0))
+        if (elapsed == 0.0)
         {
-            rates.resize(count);
-            if (_dev_stock)
-            {
-                fobos_rx_get_samplerates(_dev_stock, rates.data(), &count);
-            }
-            else if (_dev_agile)
-            {
-                fobos_sdr_get_samplerates(_dev_agile, rates.data(), &count);
-            }
-            if (rates[0] > rates[count - 1])
-            {
-                results.push_back(SoapySDR::Range(rates[count - 1], rates[0]));    
-            }
-            else
-            {
-                results.push_back(SoapySDR::Range(rates[0], rates[count - 1]));
-            }
+            return "0";
         }
+        return std::to_string(_rx_wakeups.load() / elapsed);
     }
-    return results;
+    std::lock_guard<std::mutex> lock(_stats_mutex);
+    if (_stats_count == 0)
+    {
+        return "";
+    }
+    const SoapyFobosStats & last = _stats_history[(_stats_count - 1) % STATS_HISTORY_LEN];
+    if (key == "power")
+    {
+        return std::to_string(to_dbfs(last.power));
+    }
+    if (key == "peak")
+    {
+        return std::to_string(to_dbfs(last.peak));
+    }
+    if (key == "clip_count")
+    {
+        return std::to_string(last.clips);
+    }
+    if (key == "dc_offset")
+    {
+        return std::to_string(last.dc_i) + "," + std::to_string(last.dc_q);
+    }
+    if (key == "stats_history")
+    {
+        std::ostringstream out;
+        size_t count = std::min(_stats_count, (size_t)STATS_HISTORY_LEN);
+        for (size_t i = _stats_count - count; i < _stats_count; i++)
+        {
+            const SoapyFobosStats & stats = _stats_history[i % STATS_HISTORY_LEN];
+            out << stats.counter << "," << to_dbfs(stats.power) << "," << to_dbfs(stats.peak) << ","
+                << stats.clips << "," << stats.dc_i << "," << stats.dc_q << ";";
+        }
+        return out.str();
+    }
+    return "";
 }
 
 /*******************************************************************
@@ -608,6 +1280,7 @@ SoapySDR::ArgInfoList SoapyFobosSDR::getSettingInfo(void) const
     printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
 #endif      
     SoapySDR::ArgInfoList args;
+    if (_caps.has_direct_sampling)
     {
         SoapySDR::ArgInfo info;
         info.key = "direct_samp";
@@ -621,6 +1294,7 @@ SoapySDR::ArgInfoList SoapyFobosSDR::getSettingInfo(void) const
         info.optionNames.push_back("On");
         args.push_back(info);
     }
+    if (_caps.has_clock_source)
     {
         SoapySDR::ArgInfo info;
         info.key = "clock_source";
@@ -634,6 +1308,89 @@ SoapySDR::ArgInfoList SoapyFobosSDR::getSettingInfo(void) const
         info.optionNames.push_back("External");
         args.push_back(info);
     }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "agc_target";
+        info.value = std::to_string(AGC_TARGET_DBFS);
+        info.name = "AGC Target";
+        info.description = "Mean power the software AGC keeps the signal at";
+        info.units = "dBFS";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        info.range = SoapySDR::Range(-60.0, -6.0);
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "agc_hysteresis";
+        info.value = std::to_string(AGC_HYSTERESIS_DB);
+        info.name = "AGC Hysteresis";
+        info.description = "Power window around the target where the AGC leaves the gain alone";
+        info.units = "dB";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        info.range = SoapySDR::Range(2.0, 20.0);
+        args.push_back(info);
+    }
+    if (_history_seconds > 0.0)
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "snapshot";
+        info.value = "";
+        info.name = "Snapshot";
+        info.description = "path,seconds: writes the last seconds of the history to path.sigmf-data/.sigmf-meta "
+                "in the background, reads back the state of the last one";
+        info.type = SoapySDR::ArgInfo::STRING;
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "record";
+        info.value = "";
+        info.name = "Record";
+        info.description = "path: records the samples to an indexed capture file while streaming, "
+                "empty - stops, reads back the state of the recording";
+        info.type = SoapySDR::ArgInfo::STRING;
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "reference";
+        info.value = "";
+        info.name = "Reference";
+        info.description = "path: adds a CF32 waveform the correlator looks for while streaming, "
+                "empty - removes them all";
+        info.type = SoapySDR::ArgInfo::STRING;
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "correlator_threshold";
+        info.value = std::to_string(FOBOS_CORRELATOR_THRESHOLD);
+        info.name = "Correlator Threshold";
+        info.description = "Normalized correlation peak a detection needs";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        info.range = SoapySDR::Range(0.0, 1.0);
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "correlator_offset";
+        info.value = "0";
+        info.name = "Correlator Offset";
+        info.description = "Frequency offset the correlator searches either way, in FFT bin steps";
+        info.units = "Hz";
+        info.type = SoapySDR::ArgInfo::FLOAT;
+        args.push_back(info);
+    }
+    {
+        SoapySDR::ArgInfo info;
+        info.key = "correlator_window";
+        info.value = "0";
+        info.name = "Correlator Window";
+        info.description = "Samples around every detection passed to the detection callback";
+        info.units = "samples";
+        info.type = SoapySDR::ArgInfo::INT;
+        args.push_back(info);
+    }
     return args;
 }
 
@@ -642,7 +1399,7 @@ void SoapyFobosSDR::writeSetting(const std::string &key, const std::string &valu
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
     printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
 #endif      
-    int r = -1;
+    SoapyFobosControl request;
     if (key == "direct_samp")
     {
         if (value == "1" || value == "On" || value == "on")
@@ -659,18 +1416,11 @@ void SoapyFobosSDR::writeSetting(const std::string &key, const std::string &valu
             _direct_sampling = 0;
         }
         SoapySDR_logf(SOAPY_SDR_DEBUG, "Direct sampling mode: %d", _direct_sampling);
-        if (_dev_stock)
-        {
-            r = fobos_rx_set_direct_sampling(_dev_stock, _direct_sampling);
-        }
-        else if (_dev_agile)
-        {
-            r = fobos_sdr_set_direct_sampling(_dev_agile, _direct_sampling);
-        }
-        if (r != 0)
-        {
-            SoapySDR_logf(SOAPY_SDR_ERROR, "set direct_samp failed with code %d", r);
-        }
+        // no NCO on the real HF1/HF2 samples
+        _nco_changed = true;
+        request.mask = CTRL_DIRECT_SAMPLING;
+        request.direct_sampling = _direct_sampling;
+        control_submit(request);
     }
     else if (key == "clock_source")
     {
@@ -687,23 +1437,178 @@ void SoapyFobosSDR::writeSetting(const std::string &key, const std::string &valu
             SoapySDR_logf(SOAPY_SDR_ERROR, "Invalid clock source '%s', use: 0/internal/master or 1/external/slave", value.c_str());
             return;
         }
-        
+
         SoapySDR_logf(SOAPY_SDR_INFO, "Setting clock source: %d (%s)", _clock_source, _clock_source ? "external" : "internal");
-        if (_dev_stock)
+        request.mask = CTRL_CLOCK_SOURCE;
+        request.clock_source = _clock_source;
+        control_submit(request);
+    }
+    else if (key == "agc_target")
+    {
+        _agc_target = std::stod(value);
+    }
+    else if (key == "agc_hysteresis")
+    {
+        _agc_hysteresis = std::stod(value);
+    }
+    else if (key == "snapshot")
+    {
+        // "path,seconds", all of the history without seconds
+        std::string path = value;
+        double seconds = 0.0;
+        size_t comma = value.rfind(',');
+        if (comma != std::string::npos)
         {
-            r = fobos_rx_set_clk_source(_dev_stock, _clock_source);
+            path = value.substr(0, comma);
+            seconds = std::stod(value.substr(comma + 1));
         }
-        else if (_dev_agile)
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        if (!_history)
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "Snapshot: no history, see the history_seconds argument");
+            return;
+        }
+        if (_snap_running)
         {
-            r = fobos_sdr_set_clk_source(_dev_agile, _clock_source);
+            SoapySDR_logf(SOAPY_SDR_ERROR, "Snapshot: the last one is still being written (%s)", _snap_status.c_str());
+            return;
         }
-        if (r != 0)
+        if (_snap_thread.joinable())
         {
-            SoapySDR_logf(SOAPY_SDR_ERROR, "set clock_source failed with code %d", r);
+            _snap_thread.join();
         }
+        uint64_t last = _history->seq_done;
+        size_t slots = _history->slots_kept;
+        if (seconds > 0.0)
+        {
+            slots = std::min((size_t)ceil(seconds * _history->sample_rate / _history->slot_len), slots);
+        }
+        uint64_t first = (last > slots) ? last - slots : 0;
+        long long epoch_ns = utc_epoch_ns();
+        _snap_running = true;
+        _snap_status = "writing " + path;
+        SoapySDR_logf(SOAPY_SDR_INFO, "Snapshot of %.1f s to %s", (last - first) * _history->slot_len / _history->sample_rate, path.c_str());
+        _snap_thread = std::thread(&SoapyFobosSDR::snapshot_write, this, _history, path, first, last, epoch_ns);
+    }
+    else if (key == "record")
+    {
+        // "path" starts, "" stops
+        record_stop();
+        if (value.empty())
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> streams_lock(_streams_mutex);
+        if (_streams_active == 0)
+        {
+            SoapySDR_logf(SOAPY_SDR_ERROR, "Record: no stream is active");
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_rec_mutex);
+        long long epoch_ns = utc_epoch_ns();
+        SoapyFobosCaptureWriter *writer;
+        std::shared_ptr<SoapyFobosHistory> buffer;
+        try
+        {
+            // the slots go through a history the streaming thread never waits for
+            int buffer_format = (_record_format == FOBOS_CAPTURE_CS12Z) ? FOBOS_RING_CS12 : _record_format;
+            buffer.reset(soapy_fobos_history_create(_record_buffer, _sample_rate, _rx_slot_len, buffer_format),
+                    soapy_fobos_history_close);
+            writer = soapy_fobos_capture_create(value, _record_format, _rx_slot_len, _sample_rate, epoch_ns, serial);
+        }
+        catch (const std::exception &e)
+        {
+            _rec_status = std::string("error ") + e.what();
+            SoapySDR_logf(SOAPY_SDR_ERROR, "Record: %s", e.what());
+            return;
+        }
+        _rec_stop = false;
+        _rec_status = "recording " + value;
+        _rec_thread = std::thread(&SoapyFobosSDR::record_write, this, buffer, writer, epoch_ns);
+        std::atomic_store(&_rec_buffer, buffer);
+        SoapySDR_logf(SOAPY_SDR_INFO, "Recording to %s", value.c_str());
+    }
+    else if (key == "reference")
+    {
+        // "path" adds a reference, "" removes them all
+        std::vector<float> samples;
+        if (!value.empty())
+        {
+            try
+            {
+                samples = soapy_fobos_reference_load(value);
+            }
+            catch (const std::exception &e)
+            {
+                SoapySDR_logf(SOAPY_SDR_ERROR, "Reference: %s", e.what());
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> streams_lock(_streams_mutex);
+        {
+            std::lock_guard<std::mutex> lock(_corr_mutex);
+            if (value.empty())
+            {
+                _corr_refs.clear();
+                _corr_paths.clear();
+            }
+            else
+            {
+                _corr_refs.push_back(std::move(samples));
+                _corr_paths.push_back(value);
+                SoapySDR_logf(SOAPY_SDR_INFO, "Reference %d: %s, %d samples", (int)_corr_refs.size() - 1,
+                        value.c_str(), (int)(_corr_refs.back().size() / 2));
+            }
+            // the correlator running is built again
+            _corr_epoch++;
+        }
+        if (_streams_active > 0)
+        {
+            correlator_start();
+        }
+    }
+    else if (key == "correlator_threshold")
+    {
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        _corr_threshold = std::stof(value);
+        _corr_epoch++;
+    }
+    else if (key == "correlator_offset")
+    {
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        _corr_offset = fabs(std::stod(value));
+        _corr_epoch++;
+    }
+    else if (key == "correlator_window")
+    {
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        _corr_window = (size_t)std::stoul(value);
+        _corr_epoch++;
     }
 }
 
+// see soapy_fobos_set_rx_callback()
+void SoapyFobosSDR::set_rx_hook(SoapyFobosRxCallback callback, void *user)
+{
+    // waits for the callback running now
+    std::lock_guard<std::mutex> lock(_push_mutex);
+    _push.callback = callback;
+    _push.user = (callback != nullptr) ? user : nullptr;
+    _push_set = (callback != nullptr);
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "Receive callback %s", _push_set ? "registered" : "unregistered");
+}
+
+// see soapy_fobos_set_detection_callback()
+void SoapyFobosSDR::set_detection_hook(SoapyFobosDetectionCallback callback, void *user)
+{
+    // waits for the callback running now
+    std::lock_guard<std::mutex> lock(_corr_hook_mutex);
+    _corr_hook.callback = callback;
+    _corr_hook.user = (callback != nullptr) ? user : nullptr;
+    _corr_hook_set = (callback != nullptr);
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "Detection callback %s", _corr_hook_set ? "registered" : "unregistered");
+}
+
 std::string SoapyFobosSDR::readSetting(const std::string &key) const
 {
     if (key == "direct_samp") 
@@ -714,5 +1619,102 @@ std::string SoapyFobosSDR::readSetting(const std::string &key) const
     {
         return std::to_string(_clock_source);
     }
+    if (key == "shm_export")
+    {
+        return _shm_name;
+    }
+    if (key == "udp_stream")
+    {
+        return _net_args.empty() ? "" : _net_args.at("udp_stream");
+    }
+    if (key == "ring_format")
+    {
+        return (_ring_format == FOBOS_RING_CS16) ? SOAPY_SDR_CS16 : ((_ring_format == FOBOS_RING_CS12) ? SOAPY_SDR_CS12 : SOAPY_SDR_CF32);
+    }
+    if (key == "agc_target")
+    {
+        return std::to_string(_agc_target);
+    }
+    if (key == "agc_hysteresis")
+    {
+        return std::to_string(_agc_hysteresis);
+    }
+    if (key == "snapshot")
+    {
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        return _snap_status;
+    }
+    if (key == "record")
+    {
+        std::lock_guard<std::mutex> lock(_rec_mutex);
+        return _rec_status;
+    }
+    if (key == "reference")
+    {
+        // the paths loaded, ';' separated
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        std::string paths;
+        for (const auto &path : _corr_paths)
+        {
+            paths += (paths.empty() ? "" : ";") + path;
+        }
+        return paths;
+    }
+    if (key == "correlator")
+    {
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        if (_corr_refs.empty())
+        {
+            return "off";
+        }
+        char text[128];
+        snprintf(text, sizeof(text), "%d references, FFT %d, %llu detections, %llu samples lost", (int)_corr_refs.size(),
+                (int)_corr_fft_len, (unsigned long long)_corr_count, (unsigned long long)_corr_lost);
+        return text;
+    }
+    if (key == "detections")
+    {
+        // the detections since the last call, one per line:
+        // reference,counter,time_ns,frequency_offset,peak,power
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        std::string lines;
+        for (const auto &detection : _corr_detections)
+        {
+            char text[160];
+            snprintf(text, sizeof(text), "%u,%lld,%lld,%.1f,%.4f,%.6g\n", detection.reference, detection.counter,
+                    detection.time_ns, detection.frequency_offset, detection.peak, detection.power);
+            lines += text;
+        }
+        _corr_detections.clear();
+        return lines;
+    }
+    if (key == "detection_callback")
+    {
+        return _corr_hook_set ? "1" : "0";
+    }
+    if (key.compare(0, strlen(FOBOS_NOTIFY_FD_SETTING), FOBOS_NOTIFY_FD_SETTING) == 0)
+    {
+        // the address of a stream, see soapy_fobos_stream_fd()
+        uintptr_t address = (uintptr_t)std::stoull(key.substr(strlen(FOBOS_NOTIFY_FD_SETTING)), nullptr, 0);
+        std::lock_guard<std::mutex> lock(_notify_mutex);
+        for (auto st : _notify_streams)
+        {
+            if ((uintptr_t)st == address)
+            {
+                return std::to_string(st->notify_fd);
+            }
+        }
+        return "";
+    }
+    if (key == "rx_callback")
+    {
+        return _push_set ? "1" : "0";
+    }
+    if (key == "rx_gain")
+    {
+        // gain the samples last returned by readStream() were captured with,
+        // of whichever stream has read last
+        return std::to_string(_rx_gain_read.load(std::memory_order_relaxed));
+    }
     return "";
 }
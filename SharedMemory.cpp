@@ -0,0 +1,222 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - receive ring in POSIX shared memory
+//  18.10.2026 - compact ring formats
+//  19.10.2026 - a segment is only replaced when its owner is gone
+//==============================================================================
+
+#include "SoapyFobosShm.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+static size_t align_up(size_t value)
+{
+    return (value + 63) & ~(size_t)63;
+}
+
+double soapy_fobos_shm_get(const std::atomic<uint64_t> &value)
+{
+    uint64_t bits = value.load();
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+void soapy_fobos_shm_set(std::atomic<uint64_t> &value, double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    value.store(bits);
+}
+
+#ifndef _WIN32
+
+// The segment is a ring of this version and the process that has exported it
+// still runs; false when there is no such segment or it may be replaced.
+static bool shm_owner_alive(const std::string &shm_name, uint32_t &owner_pid)
+{
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(SoapyFobosShmHeader)))
+    {
+        close(fd);
+        return false;
+    }
+    void *base = mmap(nullptr, sizeof(SoapyFobosShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    const SoapyFobosShmHeader *header = (const SoapyFobosShmHeader *)base;
+    bool ring = (header->magic == FOBOS_SHM_MAGIC) && (header->version == FOBOS_SHM_VERSION);
+    owner_pid = header->owner_pid;
+    munmap(base, sizeof(SoapyFobosShmHeader));
+    if (!ring || (owner_pid == 0))
+    {
+        return false;
+    }
+    // EPERM: it runs as another user
+    return (kill((pid_t)owner_pid, 0) == 0) || (errno == EPERM);
+}
+
+SoapyFobosShm * soapy_fobos_shm_create(const std::string &name, size_t slots_count, size_t slot_len, int ring_format, const char *serial)
+{
+    std::string shm_name = FOBOS_SHM_PREFIX + name;
+    size_t slots_offset = align_up(sizeof(SoapyFobosShmHeader));
+    size_t data_offset = align_up(slots_offset + slots_count * sizeof(SoapyFobosSlot));
+    size_t size = data_offset + slots_count * slot_len * fobos_ring_sample_bytes(ring_format);
+    uint32_t owner_pid = 0;
+    if (shm_owner_alive(shm_name, owner_pid))
+    {
+        throw std::runtime_error(shm_name + " is already exported by pid " + std::to_string(owner_pid));
+    }
+    // a segment left by a crashed owner is replaced, its clients keep the old mapping
+    shm_unlink(shm_name.c_str());
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("shm_open(" + shm_name + ") failed: " + strerror(errno));
+    }
+    if (ftruncate(fd, size) != 0)
+    {
+        int err = errno;
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        throw std::runtime_error("ftruncate(" + shm_name + ") failed: " + strerror(err));
+    }
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        int err = errno;
+        shm_unlink(shm_name.c_str());
+        throw std::runtime_error("mmap(" + shm_name + ") failed: " + strerror(err));
+    }
+    SoapyFobosShm *shm = new SoapyFobosShm();
+    shm->name = shm_name;
+    shm->owner = true;
+    shm->base = base;
+    shm->size = size;
+    shm->header = new (base) SoapyFobosShmHeader();
+    shm->slots = (SoapyFobosSlot *)((char *)base + slots_offset);
+    shm->data = (uint8_t *)base + data_offset;
+    SoapyFobosShmHeader *header = shm->header;
+    header->version = FOBOS_SHM_VERSION;
+    header->slots_count = (uint32_t)slots_count;
+    header->slot_capacity = (uint32_t)slot_len;
+    header->ring_format = (uint32_t)ring_format;
+    header->slot_len = (uint32_t)slot_len;
+    header->slots_offset = slots_offset;
+    header->data_offset = data_offset;
+    strncpy(header->serial, serial, INFO_LEN - 1);
+    header->owner_pid = (uint32_t)getpid();
+    header->state = FOBOS_SHM_STOPPED;
+    header->generation = 0;
+    header->seq_w = 0;
+    header->seq_done = 0;
+    soapy_fobos_shm_set(header->sample_rate, 0.0);
+    soapy_fobos_shm_set(header->frequency, 0.0);
+    // the clients check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = FOBOS_SHM_MAGIC;
+    SoapySDR_logf(SOAPY_SDR_INFO, "Exporting the receive ring to %s (%d MB)", shm_name.c_str(), (int)(size >> 20));
+    return shm;
+}
+
+SoapyFobosShm * soapy_fobos_shm_open(const std::string &name)
+{
+    std::string shm_name = FOBOS_SHM_PREFIX + name;
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(SoapyFobosShmHeader)))
+    {
+        close(fd);
+        return nullptr;
+    }
+    size_t size = st.st_size;
+    void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    SoapyFobosShmHeader *header = (SoapyFobosShmHeader *)base;
+    if ((header->magic != FOBOS_SHM_MAGIC) || (header->version != FOBOS_SHM_VERSION) ||
+        (header->data_offset + (size_t)header->slots_count * header->slot_capacity * fobos_ring_sample_bytes(header->ring_format) > size))
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "%s is not a Fobos SDR ring", shm_name.c_str());
+        munmap(base, size);
+        return nullptr;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    SoapyFobosShm *shm = new SoapyFobosShm();
+    shm->name = shm_name;
+    shm->owner = false;
+    shm->base = base;
+    shm->size = size;
+    shm->header = header;
+    shm->slots = (SoapyFobosSlot *)((char *)base + header->slots_offset);
+    shm->data = (uint8_t *)base + header->data_offset;
+    return shm;
+}
+
+void soapy_fobos_shm_close(SoapyFobosShm *shm)
+{
+    if (shm == nullptr)
+    {
+        return;
+    }
+    if (shm->owner)
+    {
+        shm->header->state = FOBOS_SHM_CLOSED;
+        shm_unlink(shm->name.c_str());
+    }
+    munmap(shm->base, shm->size);
+    delete shm;
+}
+
+#else
+
+SoapyFobosShm * soapy_fobos_shm_create(const std::string &name, size_t slots_count, size_t slot_len, int ring_format, const char *serial)
+{
+    (void)name;
+    (void)slots_count;
+    (void)slot_len;
+    (void)ring_format;
+    (void)serial;
+    throw std::runtime_error("shm_export is not supported on this platform");
+}
+
+SoapyFobosShm * soapy_fobos_shm_open(const std::string &name)
+{
+    (void)name;
+    return nullptr;
+}
+
+void soapy_fobos_shm_close(SoapyFobosShm *shm)
+{
+    (void)shm;
+}
+
+#endif
+//==============================================================================
@@ -0,0 +1,461 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Device reading the receive ring exported by another process
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - compact ring formats
+//  18.10.2026 - slots of any length, time stamps and flags across rate changes
+//  19.10.2026 - readStream() flags are output only
+//  19.10.2026 - segments refcounted across reattach, slot lengths checked before use
+//==============================================================================
+
+#include "SoapyFobosShm.hpp"
+#include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Formats.hpp>
+#include <SoapySDR/Time.hpp>
+#include <chrono>
+#include <cstring>
+
+SoapyFobosShmClient::SoapyFobosShmClient(const SoapySDR::Kwargs &args):
+    _name(args.at("shm"))
+{
+    SoapyFobosShm *shm = soapy_fobos_shm_open(_name);
+    if (shm == nullptr)
+    {
+        throw std::runtime_error("shm: " + _name + " is not exported");
+    }
+    _shm.reset(shm, soapy_fobos_shm_close);
+    SoapySDR_logf(SOAPY_SDR_INFO, "Attached to %s of the process %d", _shm->name.c_str(), (int)_shm->header->owner_pid);
+}
+
+SoapyFobosShmClient::~SoapyFobosShmClient(void)
+{
+}
+
+std::shared_ptr<SoapyFobosShm> SoapyFobosShmClient::segment(void) const
+{
+    std::lock_guard<std::mutex> lock(_shm_mutex);
+    return _shm;
+}
+
+/*******************************************************************
+ * Identification API
+ ******************************************************************/
+
+std::string SoapyFobosShmClient::getDriverKey(void) const
+{
+    return "Fobos SDR";
+}
+
+std::string SoapyFobosShmClient::getHardwareKey(void) const
+{
+    return "RigExpert Fobos SDR (shared)";
+}
+
+SoapySDR::Kwargs SoapyFobosShmClient::getHardwareInfo(void) const
+{
+    std::shared_ptr<SoapyFobosShm> shm = segment();
+    SoapySDR::Kwargs info;
+    info["shm"] = _name;
+    info["serial"] = shm->header->serial;
+    info["owner_pid"] = std::to_string(shm->header->owner_pid);
+    return info;
+}
+
+/*******************************************************************
+ * Channels API
+ ******************************************************************/
+
+size_t SoapyFobosShmClient::getNumChannels(const int direction) const
+{
+    return (direction == SOAPY_SDR_RX) ? 1 : 0;
+}
+
+/*******************************************************************
+ * Stream API
+ ******************************************************************/
+
+std::vector<std::string> SoapyFobosShmClient::getStreamFormats(const int direction, const size_t channel) const
+{
+    (void)channel;
+    std::vector<std::string> formats;
+    if (direction == SOAPY_SDR_RX)
+    {
+        formats.push_back(SOAPY_SDR_CF32);
+    }
+    return formats;
+}
+
+std::string SoapyFobosShmClient::getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const
+{
+    (void)direction;
+    (void)channel;
+    fullScale = 1.0;
+    return SOAPY_SDR_CF32;
+}
+
+SoapySDR::Stream *SoapyFobosShmClient::setupStream(
+        const int direction,
+        const std::string &format,
+        const std::vector<size_t> &channels,
+        const SoapySDR::Kwargs &args)
+{
+    (void)args;
+    if (direction != SOAPY_SDR_RX)
+    {
+        throw std::runtime_error("!direction: only SOAPY_SDR_RX");
+    }
+    if (channels.size() > 1 or (channels.size() > 0 and channels.at(0) != 0))
+    {
+        throw std::runtime_error("!channels: only one");
+    }
+    if (format != SOAPY_SDR_CF32)
+    {
+        throw std::runtime_error("!format: only SOAPY_SDR_CF32");
+    }
+    ClientStream *cs = new ClientStream();
+    cs->active = false;
+    std::lock_guard<std::mutex> lock(_shm_mutex);
+    resync(cs);
+    return (SoapySDR::Stream *) cs;
+}
+
+void SoapyFobosShmClient::closeStream(SoapySDR::Stream *stream)
+{
+    delete (ClientStream *) stream;
+}
+
+size_t SoapyFobosShmClient::getStreamMTU(SoapySDR::Stream *stream) const
+{
+    (void)stream;
+    return segment()->header->slot_len;
+}
+
+int SoapyFobosShmClient::activateStream(
+        SoapySDR::Stream *stream,
+        const int flags,
+        const long long timeNs,
+        const size_t numElems)
+{
+    (void)timeNs;
+    (void)numElems;
+    if (flags != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    ClientStream *cs = (ClientStream *) stream;
+    std::lock_guard<std::mutex> lock(_shm_mutex);
+    resync(cs);
+    cs->active = true;
+    return 0;
+}
+
+int SoapyFobosShmClient::deactivateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs)
+{
+    (void)timeNs;
+    if (flags != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    ((ClientStream *) stream)->active = false;
+    return 0;
+}
+
+// Continues with the next slot the owner writes to the segment attached last,
+// must be called with _shm_mutex locked
+void SoapyFobosShmClient::resync(ClientStream *cs)
+{
+    cs->shm = _shm;
+    const SoapyFobosShmHeader *header = cs->shm->header;
+    cs->generation = header->generation;
+    cs->seq_r = header->seq_done;
+    cs->pos_r = 0;
+    cs->gain_epoch = (cs->seq_r > 0) ? cs->shm->slots[(cs->seq_r - 1) % header->slots_count].gain_epoch : 0;
+    cs->rate_epoch = (cs->seq_r > 0) ? cs->shm->slots[(cs->seq_r - 1) % header->slots_count].rate_epoch : 0;
+}
+
+// The slot being read by cs has been (or is being) overwritten by the owner
+bool SoapyFobosShmClient::slot_lost(const ClientStream *cs) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const SoapyFobosShmHeader *header = cs->shm->header;
+    return (header->generation != cs->generation) || (cs->seq_r + header->slots_count <= header->seq_w);
+}
+
+// Copies the header of the slot cs reads: false when it has been lapped, or
+// the slot does not hold the read position (torn or republished shorter)
+bool SoapyFobosShmClient::slot_take(const ClientStream *cs, SoapyFobosSlot &slot) const
+{
+    slot = cs->shm->slots[cs->seq_r % cs->shm->header->slots_count];
+    if (slot_lost(cs))
+    {
+        return false;
+    }
+    slot.len = std::min(slot.len, cs->shm->header->slot_capacity);
+    return cs->pos_r < slot.len;
+}
+
+// Waits for the slot cs->seq_r: 0 - ready, SOAPY_SDR_TIMEOUT or SOAPY_SDR_OVERFLOW
+int SoapyFobosShmClient::wait_slot(ClientStream *cs, const long timeoutUs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_shm_mutex);
+            if (_shm->header->state == FOBOS_SHM_CLOSED)
+            {
+                // the owner has closed the ring, attach to the next one; the
+                // streams still reading the old one keep it mapped
+                SoapyFobosShm *shm = soapy_fobos_shm_open(_name);
+                if ((shm != nullptr) && (shm->header->state != FOBOS_SHM_CLOSED))
+                {
+                    _shm.reset(shm, soapy_fobos_shm_close);
+                }
+                else
+                {
+                    soapy_fobos_shm_close(shm);
+                }
+            }
+            if (cs->shm != _shm)
+            {
+                // attached anew by this stream or another one, the counters
+                // of the old segment mean nothing in the new one
+                resync(cs);
+                return SOAPY_SDR_OVERFLOW;
+            }
+            else if (_shm->header->state == FOBOS_SHM_CLOSED)
+            {
+                // no next one yet
+            }
+            else if (slot_lost(cs) || (cs->seq_r > _shm->header->seq_done))
+            {
+                // lapped, or the owner has restarted streaming
+                resync(cs);
+                return SOAPY_SDR_OVERFLOW;
+            }
+            else if (cs->seq_r < _shm->header->seq_done)
+            {
+                return 0;
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return SOAPY_SDR_TIMEOUT;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(FOBOS_SHM_POLL_US));
+    }
+}
+
+int SoapyFobosShmClient::readStream(
+        SoapySDR::Stream *stream,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    ClientStream *cs = (ClientStream *) stream;
+    flags = 0;
+    if (!cs->active)
+    {
+        return 0;
+    }
+    int r = wait_slot(cs, timeoutUs);
+    if (r != 0)
+    {
+        return r;
+    }
+    // the segment this stream reads, mapped while cs holds it
+    const SoapyFobosShm *shm = cs->shm.get();
+    size_t idx = cs->seq_r % shm->header->slots_count;
+    SoapyFobosSlot slot;
+    if (!slot_take(cs, slot))
+    {
+        std::lock_guard<std::mutex> lock(_shm_mutex);
+        resync(cs);
+        return SOAPY_SDR_OVERFLOW;
+    }
+    size_t samples_count = std::min((size_t)slot.len - cs->pos_r, numElems);
+    fobos_ring_unpack(shm->header->ring_format, shm->slot_data(idx), cs->pos_r, (float*)buffs[0], samples_count);
+    if (slot_lost(cs))
+    {
+        std::lock_guard<std::mutex> lock(_shm_mutex);
+        resync(cs);
+        return SOAPY_SDR_OVERFLOW;
+    }
+    if ((cs->pos_r == 0) && (slot.gain_epoch != cs->gain_epoch))
+    {
+        flags |= FOBOS_FLAG_GAIN_CHANGED;
+        cs->gain_epoch = slot.gain_epoch;
+    }
+    if ((cs->pos_r == 0) && (slot.rate_epoch != cs->rate_epoch))
+    {
+        flags |= FOBOS_FLAG_RATE_CHANGED;
+        cs->rate_epoch = slot.rate_epoch;
+    }
+    timeNs = slot.time_ns(cs->pos_r);
+    flags |= SOAPY_SDR_HAS_TIME;
+    cs->pos_r += samples_count;
+    if (cs->pos_r >= slot.len)
+    {
+        cs->pos_r = 0;
+        cs->seq_r++;
+    }
+    return samples_count;
+}
+
+/*******************************************************************
+ * Direct buffer access API
+ * The handle is the slot index, the samples are read in place. The
+ * owner does not wait for the clients, a buffer held longer than the
+ * ring length is overwritten and the next acquire tells the overflow.
+ ******************************************************************/
+
+size_t SoapyFobosShmClient::getNumDirectAccessBuffers(SoapySDR::Stream *stream)
+{
+    const SoapyFobosShm *shm = ((ClientStream *) stream)->shm.get();
+    if (shm->header->ring_format != FOBOS_RING_CF32)
+    {
+        // compact ring, the samples are not CF32 in place
+        return 0;
+    }
+    return shm->header->slots_count;
+}
+
+int SoapyFobosShmClient::getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs)
+{
+    const SoapyFobosShm *shm = ((ClientStream *) stream)->shm.get();
+    if ((handle >= shm->header->slots_count) || (shm->header->ring_format != FOBOS_RING_CF32))
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    buffs[0] = shm->slot_data(handle);
+    return 0;
+}
+
+int SoapyFobosShmClient::acquireReadBuffer(
+        SoapySDR::Stream *stream,
+        size_t &handle,
+        const void **buffs,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    ClientStream *cs = (ClientStream *) stream;
+    if (!cs->active)
+    {
+        return 0;
+    }
+    int r = wait_slot(cs, timeoutUs);
+    if (r != 0)
+    {
+        return r;
+    }
+    // a reattach may have brought another ring format
+    const SoapyFobosShm *shm = cs->shm.get();
+    if (shm->header->ring_format != FOBOS_RING_CF32)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    handle = cs->seq_r % shm->header->slots_count;
+    SoapyFobosSlot slot;
+    if (!slot_take(cs, slot))
+    {
+        std::lock_guard<std::mutex> lock(_shm_mutex);
+        resync(cs);
+        return SOAPY_SDR_OVERFLOW;
+    }
+    buffs[0] = (const float *)shm->slot_data(handle) + cs->pos_r * 2;
+    flags = SOAPY_SDR_HAS_TIME;
+    if ((cs->pos_r == 0) && (slot.gain_epoch != cs->gain_epoch))
+    {
+        flags |= FOBOS_FLAG_GAIN_CHANGED;
+        cs->gain_epoch = slot.gain_epoch;
+    }
+    if ((cs->pos_r == 0) && (slot.rate_epoch != cs->rate_epoch))
+    {
+        flags |= FOBOS_FLAG_RATE_CHANGED;
+        cs->rate_epoch = slot.rate_epoch;
+    }
+    timeNs = slot.time_ns(cs->pos_r);
+    return slot.len - cs->pos_r;
+}
+
+void SoapyFobosShmClient::releaseReadBuffer(SoapySDR::Stream *stream, const size_t handle)
+{
+    (void)handle;
+    ClientStream *cs = (ClientStream *) stream;
+    cs->pos_r = 0;
+    cs->seq_r++;
+}
+
+/*******************************************************************
+ * Frequency API
+ ******************************************************************/
+
+void SoapyFobosShmClient::setFrequency(
+        const int direction,
+        const size_t channel,
+        const std::string &name,
+        const double frequency,
+        const SoapySDR::Kwargs &args)
+{
+    (void)direction;
+    (void)channel;
+    (void)name;
+    (void)args;
+    if (frequency != soapy_fobos_shm_get(segment()->header->frequency))
+    {
+        throw std::runtime_error("shm: the frequency is controlled by the process owning the device");
+    }
+}
+
+double SoapyFobosShmClient::getFrequency(const int direction, const size_t channel, const std::string &name) const
+{
+    (void)direction;
+    (void)channel;
+    (void)name;
+    return soapy_fobos_shm_get(segment()->header->frequency);
+}
+
+std::vector<std::string> SoapyFobosShmClient::listFrequencies(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    std::vector<std::string> names;
+    names.push_back("RF");
+    return names;
+}
+
+/*******************************************************************
+ * Sample Rate API
+ ******************************************************************/
+
+void SoapyFobosShmClient::setSampleRate(const int direction, const size_t channel, const double rate)
+{
+    (void)direction;
+    (void)channel;
+    if (rate != soapy_fobos_shm_get(segment()->header->sample_rate))
+    {
+        throw std::runtime_error("shm: the sample rate is controlled by the process owning the device");
+    }
+}
+
+double SoapyFobosShmClient::getSampleRate(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    return soapy_fobos_shm_get(segment()->header->sample_rate);
+}
+
+std::vector<double> SoapyFobosShmClient::listSampleRates(const int direction, const size_t channel) const
+{
+    (void)direction;
+    (void)channel;
+    std::vector<double> rates;
+    rates.push_back(soapy_fobos_shm_get(segment()->header->sample_rate));
+    return rates;
+}
+//==============================================================================
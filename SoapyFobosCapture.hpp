@@ -0,0 +1,258 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Indexed chunked capture files, the recorder writing them and the replay device
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - compressed chunks (SoapyFobosCodec.hpp)
+//==============================================================================
+
+#pragma once
+
+#include "SoapyFobosSDR.hpp"
+#include "SoapyFobosCodec.hpp"
+#include <cstdio>
+//==============================================================================
+#define FOBOS_CAPTURE_MAGIC         0x50414346  // "FCAP"
+#define FOBOS_CAPTURE_CHUNK_MAGIC   0x4b484346  // "FCHK"
+#define FOBOS_CAPTURE_VERSION       1
+// SoapyFobosCaptureHeader::format next to FOBOS_RING_*, chunks of any size
+#define FOBOS_CAPTURE_CS12Z         3       // fobos_z12_encode() streams
+// the file header takes one page, the chunks start at page boundaries
+#define FOBOS_CAPTURE_ALIGN         4096
+// the recorder thread looks for new slots while idle
+#define FOBOS_RECORD_POLL_MS        10
+//==============================================================================
+// File layout, little endian:
+//   SoapyFobosCaptureHeader, padded to FOBOS_CAPTURE_ALIGN
+//   chunk 0 .. chunks_count - 1, chunk_bytes each: SoapyFobosCaptureChunk, chunk_len
+//       samples in format, zero padded to a multiple of FOBOS_CAPTURE_ALIGN
+//   SoapyFobosCaptureIndex[chunks_count] at index_offset
+// Chunk i is at FOBOS_CAPTURE_ALIGN + i * chunk_bytes, the index at the end
+// holds the sample counter and the power of every chunk, so a reader finds a
+// time and skips the quiet chunks without touching the samples. A file the
+// recorder has not closed has chunks_count 0, its index is rebuilt from the
+// chunk headers, as is an index that does not fit the chunks of the file.
+// FOBOS_CAPTURE_CS12Z chunks hold the bytes of one compressed stream of
+// chunk_len samples, padded to a multiple of 64, chunk_bytes is 0 and the
+// index tells where they are.
+struct SoapyFobosCaptureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;                        // FOBOS_RING_*
+    uint32_t chunk_len;                     // I/Q samples per chunk
+    uint64_t chunk_bytes;
+    double sample_rate;
+    int64_t epoch_ns;                       // UTC (ns since 1970) of sample counter 0, 0 - unknown
+    uint64_t chunks_count;                  // written at close
+    uint64_t index_offset;                  // written at close
+    char serial[INFO_LEN];
+};
+
+struct SoapyFobosCaptureChunk
+{
+    uint32_t magic;                         // FOBOS_CAPTURE_CHUNK_MAGIC
+    uint32_t clips;                         // samples with I or Q at the ADC limit
+    uint64_t seq;                           // chunk number in the file
+    int64_t counter;                        // sample counter of the first sample
+    int64_t time_ns;                        // UTC of the first sample, 0 - unknown
+    double frequency;                       // Hz, RF + BB
+    double gain;                            // LNA + VGA, dB
+    float power;                            // mean |x|^2
+    float peak;                             // max |x|^2
+    uint32_t bytes;                         // of the samples following
+    uint8_t reserved[4];
+};
+
+struct SoapyFobosCaptureIndex
+{
+    int64_t counter;
+    uint64_t offset;                        // of the chunk in the file
+    float power;
+    float peak;
+};
+
+static_assert(sizeof(SoapyFobosCaptureChunk) == 64, "capture chunk header layout");
+static_assert(sizeof(SoapyFobosCaptureIndex) == 24, "capture index layout");
+//==============================================================================
+// Writer, used by the recorder thread
+struct SoapyFobosCaptureWriter
+{
+    std::string path;
+    FILE *file;
+    SoapyFobosCaptureHeader header;
+    std::vector<SoapyFobosCaptureIndex> index;
+    uint64_t offset;                        // of the next chunk
+    std::vector<uint8_t> padding;           // zeros up to chunk_bytes
+    std::string error;                      // the first write error
+};
+
+// Throws when the file can not be created.
+SoapyFobosCaptureWriter * soapy_fobos_capture_create(const std::string &path, int format, size_t chunk_len,
+        double sample_rate, long long epoch_ns, const char *serial);
+
+// Appends one chunk of bytes samples (chunk_len samples in the format, any
+// length for FOBOS_CAPTURE_CS12Z), seq, magic and bytes of chunk are filled in.
+// false after an error.
+bool soapy_fobos_capture_write(SoapyFobosCaptureWriter *writer, SoapyFobosCaptureChunk &chunk, const void *samples, size_t bytes);
+
+// Writes the index and the final header, closes and deletes the writer.
+// Returns false with the reason in error.
+bool soapy_fobos_capture_finish(SoapyFobosCaptureWriter *writer, std::string &error);
+//==============================================================================
+// Reader, the file is mapped read only
+struct SoapyFobosCapture
+{
+    std::string path;
+    void *base;
+    size_t size;
+    const SoapyFobosCaptureHeader *header;
+    uint64_t chunks_count;
+    const SoapyFobosCaptureIndex *index;    // [chunks_count], in the file or in rebuilt
+    std::vector<SoapyFobosCaptureIndex> rebuilt;
+
+    const SoapyFobosCaptureChunk * chunk(uint64_t i) const
+    {
+        return (const SoapyFobosCaptureChunk *)((const uint8_t *)base + index[i].offset);
+    }
+
+    const void * chunk_data(uint64_t i) const
+    {
+        return chunk(i) + 1;
+    }
+};
+
+// Throws when the file is not a capture file.
+SoapyFobosCapture * soapy_fobos_capture_open(const std::string &path);
+void soapy_fobos_capture_close(SoapyFobosCapture *capture);
+
+// The chunk holding sample counter, or the first one after it when it falls in
+// a gap, chunks_count past the end. O(1) while the counters have no gaps.
+uint64_t soapy_fobos_capture_find(const SoapyFobosCapture *capture, long long counter);
+//==============================================================================
+// "driver=fobos,replay=PATH" streams a capture file as the device recorded it:
+// the time stamps are the sample counter time, the frequency and the gain
+// follow the chunks being read. Read only, the samples come as fast as they
+// are read.
+class SoapyFobosReplay: public SoapySDR::Device
+{
+public:
+    SoapyFobosReplay(const SoapySDR::Kwargs &args);
+
+    ~SoapyFobosReplay(void);
+
+    /*******************************************************************
+     * Identification API
+     ******************************************************************/
+
+    std::string getDriverKey(void) const;
+
+    std::string getHardwareKey(void) const;
+
+    SoapySDR::Kwargs getHardwareInfo(void) const;
+
+    /*******************************************************************
+     * Channels API
+     ******************************************************************/
+
+    size_t getNumChannels(const int direction) const;
+
+    /*******************************************************************
+     * Stream API
+     ******************************************************************/
+
+    std::vector<std::string> getStreamFormats(const int direction, const size_t channel) const;
+
+    std::string getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const;
+
+    SoapySDR::ArgInfoList getStreamArgsInfo(const int direction, const size_t channel) const;
+
+    SoapySDR::Stream *setupStream(const int direction, const std::string &format, const std::vector<size_t> &channels =
+            std::vector<size_t>(), const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    void closeStream(SoapySDR::Stream *stream);
+
+    size_t getStreamMTU(SoapySDR::Stream *stream) const;
+
+    int activateStream(
+            SoapySDR::Stream *stream,
+            const int flags = 0,
+            const long long timeNs = 0,
+            const size_t numElems = 0);
+
+    int deactivateStream(SoapySDR::Stream *stream, const int flags = 0, const long long timeNs = 0);
+
+    int readStream(
+            SoapySDR::Stream *stream,
+            void * const *buffs,
+            const size_t numElems,
+            int &flags,
+            long long &timeNs,
+            const long timeoutUs = 100000);
+
+    /*******************************************************************
+     * Frequency API
+     ******************************************************************/
+
+    void setFrequency(
+            const int direction,
+            const size_t channel,
+            const std::string &name,
+            const double frequency,
+            const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    double getFrequency(const int direction, const size_t channel, const std::string &name) const;
+
+    std::vector<std::string> listFrequencies(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Gain API
+     ******************************************************************/
+
+    double getGain(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Sample Rate API
+     ******************************************************************/
+
+    void setSampleRate(const int direction, const size_t channel, const double rate);
+
+    double getSampleRate(const int direction, const size_t channel) const;
+
+    std::vector<double> listSampleRates(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Settings API
+     ******************************************************************/
+
+    SoapySDR::ArgInfoList getSettingInfo(void) const;
+
+    void writeSetting(const std::string &key, const std::string &value);
+
+    std::string readSetting(const std::string &key) const;
+
+private:
+    SoapyFobosCapture *_capture;
+    mutable std::mutex _mutex;              // guards the streams and the values of the last chunk read
+    double _frequency;
+    double _gain;
+
+    struct ReplayStream
+    {
+        bool active;
+        bool cs16;                          // CS16, else CF32
+        float skip_below;                   // mean |x|^2 of the chunks left out, 0 - none
+        uint64_t chunk;                     // being read
+        size_t pos;                         // samples of it already read
+        double gain;                        // of the last chunk read
+        std::vector<float> expanded;        // CF32 of a CS16 read from a CF32 or CS12 file
+        std::vector<float> decoded;         // CF32 of a compressed chunk
+        uint64_t decoded_chunk;             // in decoded, UINT64_MAX - none
+    };
+    std::vector<ReplayStream *> _streams;
+
+    uint64_t next_chunk(const ReplayStream *rs, uint64_t chunk) const;
+    void seek(ReplayStream *rs, long long counter);
+};
+//==============================================================================
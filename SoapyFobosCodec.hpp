@@ -0,0 +1,331 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Lossless compressed 12 bit I/Q samples ("CS12Z")
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  19.10.2026 - header only: the encoder and the decoder are inline, nothing to link
+//  19.10.2026 - one refill per decoded value, branchless bit writer, residuals vectorised
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+//==============================================================================
+// The samples are quantised to the 12 bits of the ADC as FOBOS_RING_CS12 does
+// (full scale 2047, saturated), so decoding gives back exactly what a CS12 ring
+// or capture file holds. Every block of FOBOS_Z12_BLOCK samples is predicted
+// per component from nothing (white noise) or from the previous sample (narrow
+// band signals), whichever is smaller, and the residuals are Rice coded with
+// the parameter of the block. Noise dominated bands take 5..8 bits per component.
+//
+// Stream: uint32_t little endian sample count, then the blocks as one bit
+// stream, least significant bit first, padded to a whole byte. Block: 1 bit
+// predictor, 4 bits Rice parameter k, then per value q = z >> k in unary
+// (q zeros and a one) and the k low bits of z, z being the zigzag residual;
+// q >= FOBOS_Z12_ESCAPE is sent as FOBOS_Z12_ESCAPE zeros, a one and 16 bits of z.
+#define FOBOS_Z12_BLOCK         64
+#define FOBOS_Z12_ESCAPE        20
+#define FOBOS_Z12_HEADER        4
+// bytes a block takes at most, with the 3 the writer stores ahead of its end
+#define FOBOS_Z12_BLOCK_MAX     (FOBOS_Z12_BLOCK * 2 * (FOBOS_Z12_ESCAPE + 17) / 8 + 6)
+//==============================================================================
+static inline int32_t fobos_z12_quantise(float x)
+{
+    float v = x * 2047.0f;
+    v = (v > 2047.0f) ? 2047.0f : ((v < -2047.0f) ? -2047.0f : v);
+    // lrintf() without the call: to nearest even, as fobos_ring_pack() rounds
+    v = (v + 12582912.0f) - 12582912.0f;
+    return (int32_t)v;
+}
+
+static inline uint32_t fobos_z12_zigzag(int32_t r)
+{
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static inline int32_t fobos_z12_unzigzag(uint32_t z)
+{
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+static inline unsigned int fobos_z12_trailing_zeros(uint64_t x)
+{
+    if (x == 0)
+    {
+        return 64;
+    }
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return (unsigned int)idx;
+#else
+    return (unsigned int)__builtin_ctzll(x);
+#endif
+}
+
+// least significant bit first, whole 32 bit words while running
+struct FobosZ12BitWriter
+{
+    uint8_t* dst;
+    size_t pos;
+    uint64_t acc;
+    unsigned int n;
+
+    // the low word is stored every time and kept only once full, no branch
+    void put(uint32_t value, unsigned int bits)
+    {
+        acc |= (uint64_t)value << n;
+        n += bits;
+        dst[pos] = (uint8_t)acc;
+        dst[pos + 1] = (uint8_t)(acc >> 8);
+        dst[pos + 2] = (uint8_t)(acc >> 16);
+        dst[pos + 3] = (uint8_t)(acc >> 24);
+        unsigned int full = n >> 5;
+        pos += full * 4;
+        acc >>= full * 32;
+        n &= 31;
+    }
+
+    size_t bytes(void) const
+    {
+        return pos + (n + 7) / 8;
+    }
+
+    size_t finish(void)
+    {
+        for (; n > 0; n = (n > 8) ? n - 8 : 0)
+        {
+            dst[pos++] = (uint8_t)acc;
+            acc >>= 8;
+        }
+        return pos;
+    }
+};
+
+// bytes past the end read as zeros, loaded tells how far it has gone
+struct FobosZ12BitReader
+{
+    const uint8_t* src;
+    size_t size;
+    size_t pos;
+    uint64_t acc;
+    unsigned int n;
+
+    // at least 56 bits in acc, enough for any value: one 64 bit load takes
+    // the whole bytes that fit, the bits above n are those of the next ones
+    void refill(void)
+    {
+        if (pos + 8 <= size)
+        {
+            const uint8_t* p = src + pos;
+            uint64_t word = (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+                    ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+            acc |= word << n;
+            pos += (63 - n) >> 3;
+            n |= 56;
+            return;
+        }
+        for (; n < 56; n += 8)
+        {
+            acc |= (uint64_t)((pos < size) ? src[pos] : 0) << n;
+            pos++;
+        }
+    }
+
+    void skip(unsigned int bits)
+    {
+        acc >>= bits;
+        n -= bits;
+    }
+
+    size_t bits_used(void) const
+    {
+        return pos * 8 - n;
+    }
+};
+
+static inline void fobos_z12_encode_block(FobosZ12BitWriter &w, const int32_t* v, size_t values, int32_t prev[2])
+{
+    uint32_t z0[FOBOS_Z12_BLOCK * 2];
+    uint32_t z1[FOBOS_Z12_BLOCK * 2];
+    uint64_t s0 = 0;
+    uint64_t s1 = 0;
+    // values is I/Q pairs: each component is predicted from the one two
+    // values back, after the first pair no state is carried and it vectorises
+    z0[0] = fobos_z12_zigzag(v[0]);
+    z0[1] = fobos_z12_zigzag(v[1]);
+    z1[0] = fobos_z12_zigzag(v[0] - prev[0]);
+    z1[1] = fobos_z12_zigzag(v[1] - prev[1]);
+    for (size_t i = 2; i < values; i++)
+    {
+        z0[i] = fobos_z12_zigzag(v[i]);
+        z1[i] = fobos_z12_zigzag(v[i] - v[i - 2]);
+    }
+    for (size_t i = 0; i < values; i++)
+    {
+        s0 += z0[i];
+        s1 += z1[i];
+    }
+    prev[0] = v[values - 2];
+    prev[1] = v[values - 1];
+    bool delta = (s1 < s0);
+    const uint32_t* z = delta ? z1 : z0;
+    uint64_t s = delta ? s1 : s0;
+    // about log2 of the mean
+    unsigned int k = 0;
+    while ((k < 15) && (((uint64_t)values << (k + 1)) <= s))
+    {
+        k++;
+    }
+    w.put((delta ? 1 : 0) | (k << 1), 5);
+    uint32_t mask = (1u << k) - 1;
+    for (size_t i = 0; i < values; i++)
+    {
+        uint32_t q = z[i] >> k;
+        if ((q < FOBOS_Z12_ESCAPE) && (q + 1 + k <= 32))
+        {
+            w.put((1u << q) | ((z[i] & mask) << (q + 1)), q + 1 + k);
+        }
+        else if (q < FOBOS_Z12_ESCAPE)
+        {
+            w.put(1u << q, q + 1);
+            w.put(z[i] & mask, k);
+        }
+        else
+        {
+            w.put(1u << FOBOS_Z12_ESCAPE, FOBOS_Z12_ESCAPE + 1);
+            w.put(z[i], 16);
+        }
+    }
+}
+
+// Room the encoding of count samples may take.
+static inline size_t fobos_z12_bound(size_t count)
+{
+    return FOBOS_Z12_HEADER + (count + FOBOS_Z12_BLOCK - 1) / FOBOS_Z12_BLOCK * FOBOS_Z12_BLOCK_MAX;
+}
+
+// Encodes CF32 samples from src while the stream fits capacity bytes, in whole
+// blocks: consumed tells how many of count it has taken, at least one block
+// if capacity >= FOBOS_Z12_HEADER + FOBOS_Z12_BLOCK_MAX. dst must have room
+// for capacity + FOBOS_Z12_BLOCK_MAX bytes. Returns the bytes written.
+static inline size_t fobos_z12_encode(const float* src, size_t count, uint8_t* dst, size_t capacity, size_t &consumed)
+{
+    FobosZ12BitWriter w;
+    w.dst = dst + FOBOS_Z12_HEADER;
+    w.pos = 0;
+    w.acc = 0;
+    w.n = 0;
+    int32_t prev[2] = {0, 0};
+    int32_t v[FOBOS_Z12_BLOCK * 2];
+    consumed = 0;
+    while (consumed < count)
+    {
+        size_t len = std::min(count - consumed, (size_t)FOBOS_Z12_BLOCK);
+        for (size_t i = 0; i < len * 2; i++)
+        {
+            v[i] = fobos_z12_quantise(src[consumed * 2 + i]);
+        }
+        FobosZ12BitWriter saved = w;
+        int32_t saved_prev[2] = {prev[0], prev[1]};
+        fobos_z12_encode_block(w, v, len * 2, prev);
+        if (FOBOS_Z12_HEADER + w.bytes() > capacity)
+        {
+            // written into the room past capacity, taken back
+            w = saved;
+            prev[0] = saved_prev[0];
+            prev[1] = saved_prev[1];
+            break;
+        }
+        consumed += len;
+    }
+    size_t bytes = FOBOS_Z12_HEADER + w.finish();
+    dst[0] = (uint8_t)consumed;
+    dst[1] = (uint8_t)(consumed >> 8);
+    dst[2] = (uint8_t)(consumed >> 16);
+    dst[3] = (uint8_t)(consumed >> 24);
+    return bytes;
+}
+
+// The sample count of a stream, 0 if bytes is too short.
+static inline size_t fobos_z12_count(const uint8_t* src, size_t bytes)
+{
+    if (bytes < FOBOS_Z12_HEADER)
+    {
+        return 0;
+    }
+    return (size_t)src[0] | ((size_t)src[1] << 8) | ((size_t)src[2] << 16) | ((size_t)src[3] << 24);
+}
+
+// Decodes a stream of bytes to at most count CF32 samples, returns the number
+// of samples or 0 when the stream is damaged.
+static inline size_t fobos_z12_decode(const uint8_t* src, size_t bytes, float* dst, size_t count)
+{
+    size_t total = fobos_z12_count(src, bytes);
+    if ((total == 0) || (total > count))
+    {
+        return 0;
+    }
+    FobosZ12BitReader r;
+    r.src = src + FOBOS_Z12_HEADER;
+    r.size = bytes - FOBOS_Z12_HEADER;
+    r.pos = 0;
+    r.acc = 0;
+    r.n = 0;
+    int32_t prev[2] = {0, 0};
+    for (size_t done = 0; done < total; )
+    {
+        size_t values = std::min(total - done, (size_t)FOBOS_Z12_BLOCK) * 2;
+        r.refill();
+        bool delta = (r.acc & 1) != 0;
+        unsigned int k = (unsigned int)(r.acc >> 1) & 15;
+        r.skip(5);
+        uint32_t mask = (1u << k) - 1;
+        float* out = dst + done * 2;
+        int32_t keep = delta ? -1 : 0;      // the previous sample is added or not
+        for (size_t i = 0; i < values; i++)
+        {
+            // a value takes at most FOBOS_Z12_ESCAPE + 17 bits, one refill
+            r.refill();
+            unsigned int q = fobos_z12_trailing_zeros(r.acc);
+            uint32_t z;
+            if (q < FOBOS_Z12_ESCAPE)
+            {
+                z = (q << k) | ((uint32_t)(r.acc >> (q + 1)) & mask);
+                r.skip(q + 1 + k);
+            }
+            else if (q == FOBOS_Z12_ESCAPE)
+            {
+                z = (uint32_t)(r.acc >> (FOBOS_Z12_ESCAPE + 1)) & 0xffff;
+                r.skip(FOBOS_Z12_ESCAPE + 17);
+            }
+            else
+            {
+                return 0;
+            }
+            int32_t *p = &prev[i & 1];
+            int32_t value = fobos_z12_unzigzag(z) + (*p & keep);
+            if ((uint32_t)(value + 2047) > 4094)
+            {
+                // no 12 bit sample
+                return 0;
+            }
+            *p = value;
+            out[i] = value * (1.0f / 2047.0f);
+        }
+        done += values / 2;
+    }
+    if (r.bits_used() > r.size * 8)
+    {
+        // ran past the end
+        return 0;
+    }
+    return total;
+}
+//==============================================================================
@@ -0,0 +1,102 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Overlap-save FFT correlator looking for known waveforms in the ring slots
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  19.10.2026 - initial
+//==============================================================================
+
+#pragma once
+
+#include "SoapyFobosDsp.hpp"
+#include "SoapyFobosDetect.hpp"
+#include <string>
+#include <vector>
+//==============================================================================
+#define FOBOS_CORRELATOR_MAX_LEN    65536   // samples of a reference
+#define FOBOS_CORRELATOR_MIN_FFT    4096
+// the FFT is at least this many times the longest reference
+#define FOBOS_CORRELATOR_FFT_RATIO  4
+// the correlator thread looks for new slots while idle
+#define FOBOS_CORRELATOR_POLL_MS    10
+// "correlator_threshold" setting default, of the normalized peak
+#define FOBOS_CORRELATOR_THRESHOLD  0.5f
+// detections kept for readSetting("detections"), the oldest ones go first
+#define FOBOS_DETECTIONS_MAX        1024
+//==============================================================================
+struct SoapyFobosCorrelatorHit
+{
+    size_t reference;
+    long long counter;                      // of the first sample matched
+    size_t len;                             // samples matched, of the reference
+    int bin;                                // frequency offset in FFT bins
+    float peak;                             // normalized, 0..1
+    float power;                            // mean |x|^2 of the samples matched
+};
+
+// Correlates a stream of I/Q samples with the references: blocks of fft_len()
+// samples overlapping by the longest reference - 1, one forward FFT each and one
+// inverse per reference and frequency offset. An offset of b bins circularly
+// shifts the spectrum of the block, so the samples shifted b * sample_rate /
+// fft_len() Hz from a reference still match it, without a mixer per offset.
+// The peaks are normalized by the energy of the samples under the reference,
+// so the threshold does not depend on the signal level.
+class SoapyFobosCorrelator
+{
+public:
+    // references: interleaved I/Q CF32, 1..FOBOS_CORRELATOR_MAX_LEN samples each,
+    // threshold of the normalized peak, max_offset Hz either way
+    SoapyFobosCorrelator(const std::vector<std::vector<float>> &references, float threshold, double max_offset);
+
+    size_t fft_len(void) const { return _fft.len(); }
+
+    // the counter of a hit is at most this many samples before the end of
+    // the samples taken when it comes out
+    size_t delay(void) const { return _fft.len() + _overlap + 1; }
+
+    double sample_rate(void) const { return _sample_rate; }
+
+    double bin_hz(void) const { return _sample_rate / _fft.len(); }
+
+    // The samples from counter on start over at sample_rate (a gap or a new
+    // rate). The samples buffered so far are correlated as far as they go and
+    // the hits waiting for a higher peak are completed to hits.
+    void reset(long long counter, double sample_rate, std::vector<SoapyFobosCorrelatorHit> &hits);
+
+    // Takes the next count samples, the hits completed by them go to hits.
+    void process(const float* samples, size_t count, std::vector<SoapyFobosCorrelatorHit> &hits);
+
+private:
+    struct Reference
+    {
+        size_t len;
+        std::vector<float> spectrum;        // conj(FFT(ref)) / (fft_len * sqrt(|ref|^2))
+        bool pending;                       // hit is waiting for a higher peak
+        SoapyFobosCorrelatorHit hit;
+    };
+
+    SoapyFobosFft _fft;
+    std::vector<Reference> _refs;
+    float _threshold;
+    double _max_offset;
+    double _sample_rate;
+    int _bins;                              // offsets searched either way
+    size_t _overlap;                        // longest reference - 1
+    std::vector<float> _block;              // fft_len I/Q samples
+    size_t _fill;
+    long long _counter;                     // of _block[0]
+    std::vector<float> _spectrum;
+    std::vector<float> _work;
+    std::vector<double> _energy;            // running sum of |x|^2 of the block, fft_len + 1
+    std::vector<float> _best;               // peak of any offset at every position
+    std::vector<int> _best_bin;
+
+    // valid positions of the block, hits of them go to hits
+    void correlate(size_t valid, std::vector<SoapyFobosCorrelatorHit> &hits);
+};
+//==============================================================================
+// Reads a reference waveform: raw interleaved I/Q float32 little endian, as
+// SigMF cf32_le data files or GNU Radio file sinks of complex samples.
+// Throws when it can not be read or has no usable length.
+std::vector<float> soapy_fobos_reference_load(const std::string &path);
+//==============================================================================
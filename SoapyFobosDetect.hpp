@@ -0,0 +1,60 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Detections of the FFT correlator, extension API for in-process consumers
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  19.10.2026 - initial
+//  19.10.2026 - the callback is registered by an exported function, not a setting
+//==============================================================================
+
+#pragma once
+
+#include <SoapySDR/Config.h>
+#include <SoapySDR/Device.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+// the registration function is exported by the module, FobosSDRSupport
+#ifndef SOAPY_FOBOS_API
+#ifdef SOAPY_FOBOS_DLL_EXPORTS
+#define SOAPY_FOBOS_API SOAPY_SDR_HELPER_DLL_EXPORT
+#else
+#define SOAPY_FOBOS_API SOAPY_SDR_HELPER_DLL_IMPORT
+#endif
+#endif
+//==============================================================================
+// One match of a reference waveform loaded by writeSetting("reference", path),
+// the highest peak of that reference within its length.
+struct SoapyFobosDetection
+{
+    uint32_t reference;                     // in the order loaded, from 0
+    float peak;                             // |<x, ref>|^2 / (|x|^2 * |ref|^2), 0..1
+    float power;                            // mean |x|^2 of the samples matched
+    double frequency_offset;                // Hz the samples are above the reference, FFT bin steps
+    long long counter;                      // sample counter of the first sample matched
+    long long time_ns;                      // its time stamp, as readStream() returns it
+    long long window_counter;               // sample counter of window[0]
+    size_t window_len;                      // I/Q samples of the window, 0 - none
+};
+
+// Called by the correlator thread with every detection. window holds the
+// "correlator_window" samples around it, interleaved I/Q float, shorter at
+// the start of the stream or a gap, nullptr without one. Both are only valid
+// during the call; a slow callback makes the correlator lose samples, never
+// the readers of the stream. The callback must not change the settings or
+// the streams of the device.
+typedef void (*SoapyFobosDetectionCallback)(const SoapyFobosDetection* detection, const float* window, void* user);
+
+struct SoapyFobosDetectionHook
+{
+    SoapyFobosDetectionCallback callback;
+    void* user;
+};
+//==============================================================================
+// Registers the callback for the device made by "driver=fobos", nullptr
+// unregisters it; readSetting("detection_callback") tells "1" while one is
+// set. Once this returns an unregistered callback is not running and will
+// not be called again. Not to be called from the callback itself.
+// Returns 0, SOAPY_SDR_NOT_SUPPORTED for a device this module has not made.
+extern "C" SOAPY_FOBOS_API int soapy_fobos_set_detection_callback(SoapySDR::Device *device, SoapyFobosDetectionCallback callback, void *user);
+//==============================================================================
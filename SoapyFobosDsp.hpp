@@ -0,0 +1,211 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Signal processing kernels used on the streaming path
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - per buffer signal statistics
+//  18.10.2026 - decimator, sample format conversion
+//  18.10.2026 - rational polyphase resampler
+//  18.10.2026 - real input to complex half rate (fs/4 mix + halfband), real formats
+//  18.10.2026 - compact ring storage formats
+//  18.10.2026 - NCO for the digital fine tuning
+//  18.10.2026 - chunk by chunk NCO and resampler for the pipeline, statistics merge
+//  19.10.2026 - radix 2 FFT for the correlator
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+// sample magnitude (I or Q) treated as ADC clipping
+#define FOBOS_CLIP_LEVEL        0.999f
+// ring storage formats
+#define FOBOS_RING_CF32         0       // 8 bytes per I/Q sample
+#define FOBOS_RING_CS16         1       // 4 bytes, full scale 32767
+#define FOBOS_RING_CS12         2       // 3 bytes, I and Q 12 bit little endian packed, full scale 2047
+//==============================================================================
+// Statistics of one buffer of interleaved I/Q samples
+struct SoapyFobosStats
+{
+    uint64_t counter;       // buffer number since the stream has been activated
+    float power;            // mean |x|^2
+    float peak;             // max |x|^2
+    uint32_t clips;         // samples with I or Q at the ADC limit
+    float dc_i;             // mean I
+    float dc_q;             // mean Q
+};
+//==============================================================================
+// Copies count I/Q samples from src to dst and fills stats in the same pass.
+void fobos_copy_stats(float* dst, const float* src, size_t count, SoapyFobosStats &stats);
+
+// Same statistics without copying.
+void fobos_stats(const float* src, size_t count, SoapyFobosStats &stats);
+
+// Adds the statistics of part_count more samples to the ones of count samples.
+void fobos_stats_add(SoapyFobosStats &stats, size_t count, const SoapyFobosStats &part, size_t part_count);
+
+// Numerically controlled oscillator shifting I/Q samples in frequency.
+// The phase is kept between the calls, a new frequency takes effect
+// without a phase jump.
+class SoapyFobosNco
+{
+public:
+    SoapyFobosNco(void);
+
+    // Cycles per sample, the input is multiplied by exp(j * 2 * pi * frequency * n).
+    void set(double frequency);
+
+    bool active(void) const { return _step != 0.0; }
+
+    // Shifts count I/Q samples from in to out, fills the statistics of
+    // the input in the same pass (fobos_copy_stats() with a mixer).
+    void mix(const float* in, float* out, size_t count, SoapyFobosStats &stats);
+
+    // Same for the samples offset samples after the next one, the phase
+    // stays; the chunks of a buffer may be mixed in any order and then
+    // the phase advanced past all of them.
+    void mix_at(const float* in, float* out, size_t count, size_t offset, SoapyFobosStats &stats) const;
+    void advance(size_t count);
+
+private:
+    double _step;                   // radians per sample
+    double _phase;                  // radians, of the next input sample
+};
+
+// Mean |x|^2 of every block_len samples, count / block_len values.
+// block_len * 2 must be a multiple of 8.
+void fobos_block_power(const float* src, size_t count, size_t block_len, float* power);
+
+// CF32 to CS16 / CS8, full scale 1.0 maps to 32767 / 127, saturated.
+void fobos_cf32_to_cs16(const float* src, int16_t* dst, size_t count);
+void fobos_cf32_to_cs8(const float* src, int8_t* dst, size_t count);
+
+// Real samples taken every stride floats from src, i.e. stride 2 picks I or Q.
+void fobos_f32_copy(const float* src, size_t stride, float* dst, size_t count);
+void fobos_f32_to_s16(const float* src, size_t stride, int16_t* dst, size_t count);
+void fobos_f32_to_s8(const float* src, size_t stride, int8_t* dst, size_t count);
+//==============================================================================
+// Bytes per I/Q sample of a FOBOS_RING_* format.
+size_t fobos_ring_sample_bytes(int format);
+
+// Packs count I/Q samples from src to dst in the ring format, saturated.
+void fobos_ring_pack(int format, const float* src, void* dst, size_t count);
+
+// Unpacks count I/Q samples starting at the sample pos of src to CF32.
+void fobos_ring_unpack(int format, const void* src, size_t pos, float* dst, size_t count);
+//==============================================================================
+// Integer decimator of interleaved I/Q samples, windowed-sinc low pass.
+// The filter state is kept between the calls.
+class SoapyFobosDecimator
+{
+public:
+    SoapyFobosDecimator(size_t factor);
+
+    size_t factor(void) const { return _factor; }
+
+    void reset(void);
+
+    // How many input samples may be passed to produce at most count outputs.
+    size_t input_for(size_t count) const;
+
+    // Consumes count input samples, returns the number of output samples.
+    size_t process(const float* in, size_t count, float* out);
+
+private:
+    size_t _factor;
+    size_t _phase;                  // input samples since the last output
+    std::vector<float> _taps;
+    std::vector<float> _work;       // I/Q history followed by the current input
+};
+//==============================================================================
+// Real input (taken every stride floats) to complex baseband at half the rate:
+// mixed down by fs/4 and decimated by 2 with a halfband low pass, so the input
+// band 0..fs/2 comes out as -fs/4..fs/4. A real full scale sine gives a
+// complex full scale one. The filter state is kept between the calls.
+class SoapyFobosHalfband
+{
+public:
+    SoapyFobosHalfband(void);
+
+    size_t factor(void) const { return 2; }
+
+    void reset(void);
+
+    // How many input samples may be passed to produce at most count outputs.
+    size_t input_for(size_t count) const;
+
+    // Consumes count input samples, returns the number of output samples.
+    size_t process(const float* in, size_t stride, size_t count, float* out);
+
+private:
+    size_t _phase;                  // input samples since the last output
+    bool _negate;                   // the mixer is at -1 for the next output
+    float _center;                  // center tap with the mixer sign
+    std::vector<float> _taps;       // odd input taps with the mixer sign, oldest first
+    std::vector<float> _even;       // even input history, the center tap input first
+    std::vector<float> _odd;        // odd input history followed by the current input
+};
+//==============================================================================
+// Rational resampler of interleaved I/Q samples, output rate = input rate * interp / decim,
+// interp <= decim. Polyphase windowed-sinc low pass, the state is kept between the calls.
+class SoapyFobosResampler
+{
+public:
+    SoapyFobosResampler(size_t interp, size_t decim);
+
+    size_t interp(void) const { return _interp; }
+    size_t decim(void) const { return _decim; }
+
+    void reset(void);
+
+    // How many input samples may be passed to produce at most count outputs.
+    size_t input_for(size_t count) const;
+
+    // Consumes count input samples, returns the number of output samples.
+    size_t process(const float* in, size_t count, float* out);
+
+    // process() in three steps, so the outputs may be computed chunk by chunk:
+    // load() takes count input samples and returns the number of outputs,
+    // process_range() computes any of them, consume() drops the input but
+    // the history the next load() needs.
+    size_t load(const float* in, size_t count);
+    void process_range(size_t first, size_t count, float* out) const;
+    void consume(void);
+
+    // interp / decim closest to ratio (0..1] with interp <= max_interp
+    static void rational(double ratio, size_t max_interp, size_t &interp, size_t &decim);
+
+private:
+    size_t _interp;
+    size_t _decim;
+    size_t _phase_len;              // taps per phase
+    size_t _next;                   // next output, interpolated sample index from the current input start
+    size_t _loaded;                 // input samples after the history in _work
+    std::vector<float> _taps;       // [phase][tap]
+    std::vector<float> _work;       // I/Q history followed by the current input
+};
+//==============================================================================
+// In place FFT of len interleaved I/Q samples, len a power of 2.
+// Radix 2, the twiddles and the bit reversal are computed once.
+class SoapyFobosFft
+{
+public:
+    SoapyFobosFft(size_t len);
+
+    size_t len(void) const { return _len; }
+
+    // X[k] = sum x[n] * exp(-j * 2 * pi * k * n / len)
+    void forward(float* data) const;
+
+    // x[n] = sum X[k] * exp(j * 2 * pi * k * n / len), not divided by len
+    void inverse(float* data) const;
+
+private:
+    size_t _len;
+    std::vector<float> _twiddles;   // exp(-j * 2 * pi * k / len), k < len / 2
+    std::vector<uint32_t> _swaps;   // index pairs of the bit reversal
+
+    void transform(float* data, float sign) const;
+};
+//==============================================================================
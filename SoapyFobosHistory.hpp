@@ -0,0 +1,65 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Deep history of the ring slots and its snapshots to SigMF files
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - gain and statistics of the slots for the recorder
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+//==============================================================================
+// slots kept on top of history_seconds, so a snapshot of all of them gets
+// ahead of the writer before it comes round
+#define FOBOS_HISTORY_MARGIN    8       // 1 / 8 more, at least 2 slots
+//==============================================================================
+struct SoapyFobosHistorySlot
+{
+    long long counter;                      // sample counter of the first sample
+    double frequency;                       // Hz, RF + BB
+    double gain;                            // LNA + VGA, dB
+    float power;                            // mean |x|^2
+    float peak;                             // max |x|^2
+    uint32_t clips;
+};
+
+// Written by the streaming thread only, never waits for the snapshots or the recorder:
+// slot seq is in data[seq % slots_count] until seq_w passes seq + slots_count,
+// as the receive ring
+struct SoapyFobosHistory
+{
+    int format;                             // FOBOS_RING_*
+    double sample_rate;
+    size_t slot_len;                        // samples per slot
+    size_t slot_bytes;
+    size_t slots_count;
+    size_t slots_kept;                      // a snapshot takes at most, the rest is the margin
+    uint8_t* data;                          // [slots_count][slot_bytes]
+    std::vector<SoapyFobosHistorySlot> slots;
+    std::atomic<uint64_t> seq_w;            // slots started
+    std::atomic<uint64_t> seq_done;         // slots complete
+};
+
+// seconds at sample_rate in slots of slot_len samples, memory is not
+// touched until written
+SoapyFobosHistory * soapy_fobos_history_create(double seconds, double sample_rate, size_t slot_len, int format);
+void soapy_fobos_history_close(SoapyFobosHistory *history);
+
+// Stores one completed ring slot: packed in packed_format, samples the same in CF32.
+void soapy_fobos_history_put(SoapyFobosHistory *history, const float *samples, const void *packed, int packed_format,
+        const SoapyFobosHistorySlot &slot);
+
+// Writes slots [first, last) to path.sigmf-data and path.sigmf-meta (CF32 as cf32_le,
+// CS16 and CS12 as ci16_le). A capture segment starts at every counter or frequency
+// jump, epoch_ns is the UTC time (ns since 1970) of sample counter 0, 0 - unknown.
+// The slots the writer overwrites while being written are left out.
+// Returns false with the reason in status.
+bool soapy_fobos_history_dump(const SoapyFobosHistory *history, const std::string &path, uint64_t first, uint64_t last,
+        long long epoch_ns, const std::string &hw, std::string &status);
+//==============================================================================
@@ -0,0 +1,211 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Several coherent Fobos SDR receivers as one multi-channel device
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - frequency correction, overall frequency forwarded to the receivers
+//  19.10.2026 - the receivers for the callback registration
+//==============================================================================
+
+#pragma once
+
+#include "SoapyFobosSDR.hpp"
+//==============================================================================
+// "driver=fobos,serials=A;B;C" opens the listed devices in parallel and shows
+// them as channels 0..N-1. The devices are expected to share one reference
+// clock (clock_source=1). Streams of all channels are aligned by the sample
+// counter and returned by one readStream() call with one time stamp.
+class SoapyFobosMulti: public SoapySDR::Device
+{
+public:
+    SoapyFobosMulti(const SoapySDR::Kwargs &args);
+
+    ~SoapyFobosMulti(void);
+
+    static std::vector<std::string> split_serials(const std::string &serials);
+
+    /*******************************************************************
+     * Identification API
+     ******************************************************************/
+
+    std::string getDriverKey(void) const;
+
+    std::string getHardwareKey(void) const;
+
+    SoapySDR::Kwargs getHardwareInfo(void) const;
+
+    /*******************************************************************
+     * Channels API
+     ******************************************************************/
+
+    size_t getNumChannels(const int direction) const;
+
+    bool getFullDuplex(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Stream API
+     ******************************************************************/
+
+    std::vector<std::string> getStreamFormats(const int direction, const size_t channel) const;
+
+    std::string getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const;
+
+    SoapySDR::ArgInfoList getStreamArgsInfo(const int direction, const size_t channel) const;
+
+    SoapySDR::Stream *setupStream(const int direction, const std::string &format, const std::vector<size_t> &channels =
+            std::vector<size_t>(), const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    void closeStream(SoapySDR::Stream *stream);
+
+    size_t getStreamMTU(SoapySDR::Stream *stream) const;
+
+    int activateStream(
+            SoapySDR::Stream *stream,
+            const int flags = 0,
+            const long long timeNs = 0,
+            const size_t numElems = 0);
+
+    int deactivateStream(SoapySDR::Stream *stream, const int flags = 0, const long long timeNs = 0);
+
+    int readStream(
+            SoapySDR::Stream *stream,
+            void * const *buffs,
+            const size_t numElems,
+            int &flags,
+            long long &timeNs,
+            const long timeoutUs = 100000);
+
+    /*******************************************************************
+     * Antenna API
+     ******************************************************************/
+
+    std::vector<std::string> listAntennas(const int direction, const size_t channel) const;
+
+    void setAntenna(const int direction, const size_t channel, const std::string &name);
+
+    std::string getAntenna(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Gain API
+     ******************************************************************/
+
+    std::vector<std::string> listGains(const int direction, const size_t channel) const;
+
+    bool hasGainMode(const int direction, const size_t channel) const;
+
+    void setGainMode(const int direction, const size_t channel, const bool automatic);
+
+    bool getGainMode(const int direction, const size_t channel) const;
+
+    void setGain(const int direction, const size_t channel, const std::string &name, const double value);
+
+    double getGain(const int direction, const size_t channel, const std::string &name) const;
+
+    SoapySDR::Range getGainRange(const int direction, const size_t channel, const std::string &name) const;
+
+    /*******************************************************************
+     * Frontend corrections API
+     ******************************************************************/
+
+    bool hasFrequencyCorrection(const int direction, const size_t channel) const;
+
+    void setFrequencyCorrection(const int direction, const size_t channel, const double value);
+
+    double getFrequencyCorrection(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Frequency API
+     ******************************************************************/
+
+    void setFrequency(
+            const int direction,
+            const size_t channel,
+            const double frequency,
+            const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    void setFrequency(
+            const int direction,
+            const size_t channel,
+            const std::string &name,
+            const double frequency,
+            const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    double getFrequency(const int direction, const size_t channel) const;
+
+    double getFrequency(const int direction, const size_t channel, const std::string &name) const;
+
+    std::vector<std::string> listFrequencies(const int direction, const size_t channel) const;
+
+    SoapySDR::RangeList getFrequencyRange(const int direction, const size_t channel) const;
+
+    SoapySDR::RangeList getFrequencyRange(const int direction, const size_t channel, const std::string &name) const;
+
+    /*******************************************************************
+     * Sample Rate API
+     ******************************************************************/
+
+    void setSampleRate(const int direction, const size_t channel, const double rate);
+
+    double getSampleRate(const int direction, const size_t channel) const;
+
+    std::vector<double> listSampleRates(const int direction, const size_t channel) const;
+
+    SoapySDR::RangeList getSampleRateRange(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Sensor API
+     ******************************************************************/
+
+    std::vector<std::string> listSensors(const int direction, const size_t channel) const;
+
+    SoapySDR::ArgInfo getSensorInfo(const int direction, const size_t channel, const std::string &key) const;
+
+    std::string readSensor(const int direction, const size_t channel, const std::string &key) const;
+
+    /*******************************************************************
+     * Settings API
+     ******************************************************************/
+
+    SoapySDR::ArgInfoList getSettingInfo(void) const;
+
+    void writeSetting(const std::string &key, const std::string &value);
+
+    std::string readSetting(const std::string &key) const;
+
+    SoapySDR::ArgInfoList getSettingInfo(const int direction, const size_t channel) const;
+
+    void writeSetting(const int direction, const size_t channel, const std::string &key, const std::string &value);
+
+    std::string readSetting(const int direction, const size_t channel, const std::string &key) const;
+
+    // the receivers, the callbacks are registered with each of them
+    const std::vector<SoapyFobosSDR*> &devices(void) const;
+
+private:
+    SoapyFobosSDR * child(const int direction, const size_t channel) const;
+
+    std::vector<std::string> _serials;
+    std::vector<SoapyFobosSDR*> _devs;
+
+    // one child stream per channel
+    struct MultiStream
+    {
+        std::vector<size_t> channels;
+        std::vector<SoapySDR::Stream*> streams;
+        std::vector<std::vector<float>> carry;      // read ahead of the other channels
+        std::vector<long long> child_next;          // sample counter of the next sample to read from the child
+        std::vector<long long> base;                // child sample counter of the composite sample #0
+        bool aligned;
+        long long counter;                          // composite sample counter of the next sample to deliver
+        double sample_rate;
+        size_t mtu;
+    };
+    std::vector<long long> _sample_offsets;        // user correction of the alignment, samples
+
+    bool align(MultiStream *ms);
+    int read_child(MultiStream *ms, size_t i, float *dst, size_t count, int &flags, bool &gap, const long timeoutUs);
+    int drop_leading(MultiStream *ms, size_t i, const long timeoutUs);
+    void resync(MultiStream *ms);
+};
+//==============================================================================
@@ -0,0 +1,66 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Receive ring slots sent as VITA-49 UDP datagrams by the streaming thread
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - CS12Z payloads
+//==============================================================================
+
+#pragma once
+
+#include <SoapySDR/Types.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+//==============================================================================
+#define FOBOS_NET_MTU           1500
+#define FOBOS_NET_IP_UDP_LEN    28          // IPv4 + UDP headers
+#define FOBOS_NET_BATCH         64          // datagrams per sendmmsg()
+// VITA-49 IF data packet with stream id, no class id, no trailer,
+// no integer time stamp, fractional time stamp = sample count
+#define FOBOS_VRT_HEADER_WORDS  4
+#define FOBOS_VRT_IF_DATA_SID   0x1
+#define FOBOS_VRT_TSF_SAMPLES   0x1
+// SoapyFobosNet::format, big endian I/Q pairs as VITA-49 has them
+#define FOBOS_NET_CS8           0
+#define FOBOS_NET_CS16          1
+#define FOBOS_NET_CF32          2
+// one fobos_z12_encode() stream of as many samples as fit, see SoapyFobosCodec.hpp
+#define FOBOS_NET_CS12Z         3
+//==============================================================================
+// One UDP destination, used by the streaming thread only.
+// Datagram: header word, stream id, 64 bit sample counter of the first
+// sample, samples_per_packet I/Q samples (fewer in the last one of a slot).
+// CS12Z: the compressed stream instead of the samples, zero padded to a whole
+// word, it tells how many samples it holds.
+struct SoapyFobosNet
+{
+    std::string address;                    // "host:port" as given
+    int fd;
+    std::vector<uint8_t> addr;              // struct sockaddr_in
+    int format;                             // FOBOS_NET_*
+    size_t sample_bytes;
+    size_t samples_per_packet;              // CS12Z: 0, as many as fit payload_bytes
+    size_t payload_bytes;
+    size_t packet_bytes;                    // room per datagram
+    uint32_t stream_id;
+    uint32_t packet_count;                  // 4 bit VITA-49 packet counter
+    uint64_t packets;                       // sent
+    uint64_t dropped;                       // refused by the socket
+    std::vector<uint8_t> packets_data;      // [FOBOS_NET_BATCH][packet_bytes]
+    std::vector<size_t> packets_len;
+};
+
+// "udp_stream=host:port" (unicast or IPv4 multicast) with the optional
+// "udp_format" (CS16 default, CS8, CF32, CS12Z), "udp_mtu", "udp_stream_id",
+// multicast "udp_ttl" (1 default) and "udp_iface" (address of the interface)
+// device arguments
+SoapyFobosNet * soapy_fobos_net_create(const SoapySDR::Kwargs &args);
+void soapy_fobos_net_close(SoapyFobosNet *net);
+
+// Sends count CF32 I/Q samples, the first one has sample counter counter.
+// Never blocks, datagrams the socket does not take are counted as dropped.
+void soapy_fobos_net_send(SoapyFobosNet *net, const float *samples, size_t count, uint64_t counter);
+//==============================================================================
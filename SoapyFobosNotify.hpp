@@ -0,0 +1,33 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Readiness descriptors of the streams, extension API for event loops
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//==============================================================================
+
+#pragma once
+
+#include <SoapySDR/Device.hpp>
+#include <stdint.h>
+#include <string>
+//==============================================================================
+// A stream set up with the "notify=N" stream arg has a descriptor that polls
+// readable (POLLIN / EPOLLIN) once N samples of the stream are there to read:
+// an eventfd on Linux, the read end of a pipe on other POSIX systems.
+// readStream() clears it and arms it for the next N samples, so an event loop
+// calls readStream() with timeoutUs = 0 when it is readable, until it returns
+// SOAPY_SDR_TIMEOUT. It is also made readable once when the transfers stop.
+// The descriptor belongs to the stream, closeStream() closes it.
+
+// readSetting() key prefix, followed by the address of the SoapySDR::Stream
+#define FOBOS_NOTIFY_FD_SETTING     "notify_fd:"
+//==============================================================================
+// The descriptor of a stream of the device made by "driver=fobos",
+// -1 without "notify"
+inline int soapy_fobos_stream_fd(SoapySDR::Device *device, SoapySDR::Stream *stream)
+{
+    std::string value = device->readSetting(FOBOS_NOTIFY_FD_SETTING + std::to_string((unsigned long long)(uintptr_t)stream));
+    return value.empty() ? -1 : std::stoi(value);
+}
+//==============================================================================
@@ -0,0 +1,121 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Work stealing pool running the stages of the streaming thread chunk by chunk
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//==============================================================================
+// stages of read_samples(), see the "dsp_stages" sensor
+#define FOBOS_STAGE_MIX         0       // NCO of the fine tuning
+#define FOBOS_STAGE_PUSH        1       // push model callback
+#define FOBOS_STAGE_RESAMPLE    2       // rates the hardware does not have
+#define FOBOS_STAGE_PACK        3       // statistics, copy or pack to the ring slot
+#define FOBOS_STAGE_PUBLISH     4       // trigger power, readers wakeup, UDP, AGC
+#define FOBOS_STAGE_COUNT       5
+// chunks start at multiples of it (trigger power blocks, NCO renormalization)
+#define FOBOS_CHUNK_ALIGN       1024
+// chunks per thread, the others take over the chunks of a preempted one
+#define FOBOS_CHUNKS_PER_THREAD 4
+#define FOBOS_DSP_THREADS_MAX   64
+//==============================================================================
+// Fork / join pool: run() splits [0, count) into chunks, every thread starts
+// with its own contiguous run of chunks and steals from the far end of the
+// others when done. run() returns when all the chunks are done, each task
+// writes its own part of the output, so it comes out in order.
+// The calling thread takes part, with 1 thread there is no pool at all.
+// Only one thread calls run() and account(), timing() may be called by any.
+class SoapyFobosPipeline
+{
+public:
+    // threads: all together with the calling one
+    SoapyFobosPipeline(size_t threads);
+    ~SoapyFobosPipeline();
+
+    size_t threads(void) const { return _threads; }
+
+    // Upper bound of chunks() for any count.
+    size_t max_chunks(void) const { return _threads * FOBOS_CHUNKS_PER_THREAD; }
+
+    // Samples per chunk, at least min_len unless count is shorter.
+    size_t chunk_len(size_t count, size_t min_len) const;
+    size_t chunks(size_t count, size_t min_len) const;
+
+    // Calls task(chunk, first, len) for every chunk of [0, count), the last
+    // one may be shorter. The stage gets the wall time and the CPU time
+    // of the threads.
+    template <typename TASK>
+    void run(int stage, size_t count, size_t min_len, TASK &task)
+    {
+        run_job(stage, count, min_len, &call<TASK>, &task);
+    }
+
+    // The caller has run the stage alone since start.
+    void account(int stage, std::chrono::steady_clock::time_point start);
+
+    void reset_timing(void);
+
+    // ';' separated: stage,runs,wall ms,CPU ms,cores (CPU time / elapsed seconds)
+    std::string timing(double elapsed) const;
+
+private:
+    typedef void (*Call)(void* task, size_t chunk, size_t first, size_t len);
+
+    template <typename TASK>
+    static void call(void* task, size_t chunk, size_t first, size_t len)
+    {
+        (*(TASK*)task)(chunk, first, len);
+    }
+
+    struct Job
+    {
+        Call call;
+        void* task;
+        int stage;
+        size_t count;
+        size_t len;
+    };
+
+    // chunks [front, back) not taken yet, front << 32 | back, a cache line each
+    struct Queue
+    {
+        std::atomic<uint64_t> range;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    struct StageTime
+    {
+        std::atomic<uint64_t> runs;
+        std::atomic<uint64_t> wall_ns;
+        std::atomic<uint64_t> busy_ns;
+    };
+
+    size_t _threads;
+    Queue* _queues;                         // [_threads], 0 - the calling thread
+    std::vector<std::thread> _workers;
+    std::atomic<const Job*> _job;
+    std::atomic<size_t> _left;              // chunks of the job not done yet
+    std::mutex _mutex;
+    std::condition_variable _start_cond;    // new job or stop
+    std::condition_variable _done_cond;     // _left has reached 0
+    uint64_t _generation;                   // jobs started, guarded by _mutex
+    bool _stop;
+    StageTime _times[FOBOS_STAGE_COUNT];
+
+    void run_job(int stage, size_t count, size_t min_len, Call call, void* task);
+    void work(size_t self);
+    void worker_loop(size_t self);
+};
+//==============================================================================
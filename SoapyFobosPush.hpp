@@ -0,0 +1,51 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Push model receive callback, extension API for in-process consumers
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  19.10.2026 - the callback is registered by an exported function, not a setting
+//==============================================================================
+
+#pragma once
+
+#include <SoapySDR/Config.h>
+#include <SoapySDR/Device.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+// the registration functions are exported by the module, FobosSDRSupport
+#ifndef SOAPY_FOBOS_API
+#ifdef SOAPY_FOBOS_DLL_EXPORTS
+#define SOAPY_FOBOS_API SOAPY_SDR_HELPER_DLL_EXPORT
+#else
+#define SOAPY_FOBOS_API SOAPY_SDR_HELPER_DLL_IMPORT
+#endif
+#endif
+//==============================================================================
+// Called by the streaming thread with every buffer as the library delivers it:
+// count interleaved I/Q float samples at the native sample rate, counter is
+// the number of the first one since the transfers have started.
+// Returns 0 when done with the buffer, the receive ring is bypassed.
+// Returns non 0 when behind: this buffer goes to the receive ring and
+// readStream() of the activated streams gets it as usual.
+// The samples are only valid during the call. Samples resampled to a rate
+// the hardware does not have always go to the ring as well.
+typedef int (*SoapyFobosRxCallback)(const float* samples, size_t count, uint64_t counter, void* user);
+
+struct SoapyFobosRxHook
+{
+    SoapyFobosRxCallback callback;
+    void* user;
+};
+//==============================================================================
+// Registers the callback for the device made by "driver=fobos", nullptr
+// unregisters it; readSetting("rx_callback") tells "1" while one is set.
+// Once this returns an unregistered callback is not running and will not be
+// called again. The transfers still run while a stream is activated. Not to
+// be called from the callback itself.
+// Returns 0, SOAPY_SDR_NOT_SUPPORTED for a device this module has not made.
+// The application links against the module or takes the function from it
+// with dlsym().
+extern "C" SOAPY_FOBOS_API int soapy_fobos_set_rx_callback(SoapySDR::Device *device, SoapyFobosRxCallback callback, void *user);
+//==============================================================================
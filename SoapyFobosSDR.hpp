@@ -4,24 +4,320 @@
 //  LGPL-2.1 or above LICENSE
 //  05.06.2024
 //  01.04.2026 - added support for fobos-sdr-agile
+//  18.10.2026 - warm device handle pool
+//  18.10.2026 - capability descriptor built at open time
+//  18.10.2026 - non-blocking coalescing control queue
+//  18.10.2026 - software AGC
+//  18.10.2026 - per buffer signal statistics, sensors API
+//  18.10.2026 - sample counter time stamps, composite multi-device (SoapyFobosMulti.hpp)
+//  18.10.2026 - multiple streams reading one ring
+//  18.10.2026 - receive ring export to shared memory (SoapyFobosShm.hpp)
+//  18.10.2026 - triggered burst capture
+//  18.10.2026 - finite acquisition
+//  18.10.2026 - any sample rate in the range through the resampler
+//  18.10.2026 - direct sampling HF1/HF2 as two channels
+//  18.10.2026 - compact ring storage, "ring_format" argument
+//  18.10.2026 - overflow policy of the streams, spill buffer
+//  18.10.2026 - push model receive callback (SoapyFobosPush.hpp)
+//  18.10.2026 - wait strategies of the streams, coalesced wakeups
+//  18.10.2026 - "BB" and "CORR" frequency components, digital fine tuning
+//  18.10.2026 - VITA-49 UDP output of the ring slots (SoapyFobosNet.hpp)
+//  18.10.2026 - streaming thread stages on a work stealing pool (SoapyFobosPipeline.hpp)
+//  18.10.2026 - deep history of the ring slots, SigMF snapshots (SoapyFobosHistory.hpp)
+//  18.10.2026 - readiness descriptors of the streams (SoapyFobosNotify.hpp)
+//  18.10.2026 - recorder to indexed chunked capture files (SoapyFobosCapture.hpp)
+//  18.10.2026 - sample rate changes while streaming, slots carry their rate and length
+//  19.10.2026 - FFT correlator of the ring slots, detections (SoapyFobosDetect.hpp)
+//  19.10.2026 - the gain of the samples read last is atomic, written by any stream
+//  19.10.2026 - the ring counters run on across a restart while streams are active
+//  19.10.2026 - receive callback set by the registration function
+//  19.10.2026 - detection callback set by the registration function
 //==============================================================================
 
 #pragma once
 
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Logger.h>
-#include <SoapySDR/Types.h>
+#include <SoapySDR/Time.hpp>
+#include <SoapySDR/Types.hpp>
 #include <fobos.h>
 #include <fobos_sdr.h>
+#include "SoapyFobosDsp.hpp"
+#include "SoapyFobosPush.hpp"
+#include "SoapyFobosNotify.hpp"
+#include "SoapyFobosDetect.hpp"
+#include "SoapyFobosPipeline.hpp"
 #include <stdexcept>
 #include <thread>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 // uncomment to bisplay debug info
 //#define SOAPY_FOBOS_PRINT_DEBUG
 #define DEFAULT_BUFF_LEN        (128 * 1024)
 #define DEFAULT_BUFS_COUNT      16
 #define INFO_LEN                64
+#define STATS_HISTORY_LEN       64
+#define MIN_BUFS_COUNT          4
+// resampler: output = native * interp / decim
+#define RESAMPLE_MAX_INTERP     1024
+#define RESAMPLE_MAX_DECIM      64      // lowest rate = lowest native rate / RESAMPLE_MAX_DECIM
+#define RESAMPLE_CHUNK_MIN      1024    // resampler outputs per pipeline chunk at least
+#define STAGE_CHUNK_MIN         16384   // samples per pipeline chunk of the copy and pack stages
+// SoapyFobosStream::hf, streams set up in the direct sampling mode
+#define FOBOS_HF_OFF            0       // complex I/Q of the ring
+#define FOBOS_HF_COMPLEX        1       // HF1/HF2 mixed by fs/4 to complex, half rate
+#define FOBOS_HF_REAL           2       // HF1/HF2 raw real samples
+// SoapyFobosStream::overflow, what a stream lapped by the writer reads next
+#define FOBOS_OVERFLOW_KEEP     0       // the oldest slot still in the ring
+#define FOBOS_OVERFLOW_LATEST   1       // the newest slot, drops the backlog
+#define FOBOS_OVERFLOW_SPILL    2       // slots it has not read are copied to its spill buffer first
+#define DEFAULT_SPILL_SLOTS     64
+// SoapyFobosStream::wait, how readStream() waits for the next slots
+#define FOBOS_WAIT_BLOCK        0       // sleeps until a slot is written
+#define FOBOS_WAIT_SPIN         1       // busy-polls the ring up to the timeout, never sleeps
+#define FOBOS_WAIT_HYBRID       2       // busy-polls WAIT_SPIN_US, then sleeps
+#define FOBOS_WAIT_COALESCE     3       // sleeps until "coalesce" slots or the requested samples are written
+#define WAIT_SPIN_US            200
+// setFrequency() with "tolerance" shifts digitally up to this part of the sample rate off the LO
+#define BB_PASSBAND             0.4
+#define CORR_MAX_PPM            1000.0
+// triggered capture, power detector resolution and noise floor tracking
+#define TRIGGER_BLOCK_LEN       1024
+#define TRIGGER_FLOOR_GATE      4.0f        // blocks above floor * gate do not move the floor up
+#define TRIGGER_FLOOR_UP        (1.0f / 1024.0f)
+#define TRIGGER_FLOOR_DOWN      (1.0f / 16.0f)
+// control requests, see SoapyFobosControl::mask
+#define CTRL_FREQUENCY          0x01
+#define CTRL_LNA_GAIN           0x02
+#define CTRL_VGA_GAIN           0x04
+#define CTRL_DIRECT_SAMPLING    0x08
+#define CTRL_CLOCK_SOURCE       0x10
+#define CTRL_SAMPLE_RATE        0x20
+// hardware gain indexes
+#define LNA_IDX_MIN             1
+#define LNA_IDX_MAX             3
+#define VGA_IDX_MIN             0
+#define VGA_IDX_MAX             15
+// software AGC defaults
+#define AGC_TARGET_DBFS         (-30.0)
+#define AGC_HYSTERESIS_DB       6.0
+#define AGC_CLIP_DBFS           (-1.0)
+// readStream() flag of the first samples captured after a gain change
+#define FOBOS_FLAG_GAIN_CHANGED SOAPY_SDR_USER_FLAG0
+// readStream() flag of the first samples at a new sample rate
+#define FOBOS_FLAG_RATE_CHANGED SOAPY_SDR_USER_FLAG1
+// "latency" argument: transfers of this many samples at least, a multiple of it
+#define LATENCY_BUFF_ALIGN      8192
+// rx_stop() cancels a restart of the transfers begun after its cancel
+#define RX_STOP_POLL_MS         10
+//==============================================================================
+// What the opened board can do. Built once when the device is opened and never
+// changed afterwards, all the query APIs are answered from it.
+struct SoapyFobosCaps
+{
+    bool agile;                             // fobos-sdr-agile backend
+    std::vector<double> sample_rates;       // ascending
+    SoapySDR::RangeList sample_rate_range;
+    SoapySDR::RangeList frequency_range;    // "RF"
+    SoapySDR::Range lna_gain_range;         // dB, step is one hardware index
+    SoapySDR::Range vga_gain_range;         // dB, step is one hardware index
+    bool has_direct_sampling;
+    bool has_clock_source;
+};
+//==============================================================================
+// Pending control requests. A newer request of the same kind replaces the
+// older one, so only the latest frequency or gain reaches the hardware.
+struct SoapyFobosControl
+{
+    unsigned int mask;          // CTRL_* bits of the valid fields
+    double frequency;
+    int lna_idx;
+    int vga_idx;
+    int direct_sampling;
+    int clock_source;
+    double sample_rate;         // output, at native_rate through the resampler
+    double native_rate;         // the hardware one
+};
+//==============================================================================
+// Information about the samples held by one ring slot
+struct SoapyFobosSlot
+{
+    long long counter;      // sample number of the first sample since activateStream()
+    uint64_t pos;           // ring position, the samples of all the slots before it
+    uint32_t len;           // samples, the last one at a sample rate may be shorter
+    unsigned int gain_epoch;// _ctrl_gain_epoch the samples were captured with
+    double gain;            // LNA + VGA gain applied, dB
+    float noise_floor;      // mean |x|^2 of the quiet blocks, 0 while unknown
+    unsigned int rate_epoch;// _ctrl_rate_epoch of the sample rate
+    double rate;            // sample rate of the samples
+    long long rate_counter; // counter of the first sample at this rate
+    long long rate_time_ns; // and its time stamp
+
+    // time stamp of sample offset of the slot, continued across the rate changes
+    long long time_ns(long long offset) const
+    {
+        return rate_time_ns + SoapySDR::ticksToTimeNs(counter - rate_counter + offset, rate);
+    }
+};
+//==============================================================================
+// Ring slot copied aside for a FOBOS_OVERFLOW_SPILL stream
+struct SoapyFobosSpillSlot
+{
+    uint64_t seq;
+    SoapyFobosSlot slot;
+    std::vector<uint8_t> data;      // in the ring format
+};
+//==============================================================================
+// One stream made by setupStream(). All the streams read the same ring of
+// received buffers, each one with its own cursor, format and decimation, so a
+// slow reader only loses its own samples.
+struct SoapyFobosStream
+{
+    SoapyFobosStream(const std::string &format, size_t decimation):
+        format(format),
+        decimator(decimation),
+        hf(FOBOS_HF_OFF),
+        channels(1, 0),
+        active(false),
+        seq_r(0),
+        pos_r(0),
+        base_r(0),
+        start_pos(0),
+        gain_epoch(0),
+        rate_epoch(0),
+        overruns(0),
+        lost(0),
+        overflow(FOBOS_OVERFLOW_KEEP),
+        spill_pos(0),
+        spill_max(0),
+        wait(FOBOS_WAIT_BLOCK),
+        coalesce(1),
+        trigger_ratio(0.0f),
+        pretrigger(0),
+        hangover(0),
+        triggered(false),
+        scan_pos(0),
+        scan_seq(0),
+        scan_base(0),
+        scan_min(0),
+        segment_end(0),
+        finite(false),
+        remaining(0),
+        end_pos(0),
+        notify_len(0),
+        notify_fd(-1),
+        notify_wfd(-1),
+        notify_at(UINT64_MAX)
+    {
+    }
+
+    std::string format;             // SOAPY_SDR_CF32, SOAPY_SDR_CS16, SOAPY_SDR_CS8, real ones for FOBOS_HF_REAL
+    SoapyFobosDecimator decimator;
+    int hf;                         // FOBOS_HF_*
+    std::vector<size_t> channels;   // HF1 - 0 (I), HF2 - 1 (Q)
+    std::vector<SoapyFobosHalfband> halfbands;  // per channel, FOBOS_HF_COMPLEX
+    bool active;
+    uint64_t seq_r;                 // ring sequence number of the slot being read
+    size_t pos_r;                   // samples of this slot already read
+    uint64_t base_r;                // ring position of slot seq_r
+    uint64_t start_pos;             // SOAPY_SDR_HAS_TIME: the ring samples before it are passed over
+    unsigned int gain_epoch;        // of the last samples returned
+    unsigned int rate_epoch;        // the sample rate of the last samples returned
+    uint64_t overruns;              // slots lost by this stream
+    uint64_t lost;                  // ring samples lost by this stream
+    int overflow;                   // FOBOS_OVERFLOW_*
+    // spill buffer, filled by the writer with the slots it overwrites before
+    // the stream has read them, oldest first
+    std::atomic<uint64_t> spill_pos;    // the first slot the stream still needs
+    std::mutex spill_mutex;             // guards the containers, not the slots in them
+    std::deque<SoapyFobosSpillSlot> spill;
+    std::vector<std::vector<uint8_t>> spill_free;
+    size_t spill_max;
+    int wait;                       // FOBOS_WAIT_*
+    size_t coalesce;                // slots to wait for, FOBOS_WAIT_COALESCE
+    std::vector<float> work;        // decimated samples before the format conversion
+    std::vector<float> unpacked;    // CF32 samples of a compact ring
+    // triggered capture, the positions are ring positions
+    float trigger_ratio;            // block power over the noise floor, 0 - continuous stream
+    size_t pretrigger;              // samples delivered before the trigger
+    size_t hangover;                // samples delivered after the last block over the level
+    bool triggered;                 // a segment is being delivered
+    uint64_t scan_pos;              // next block to check
+    uint64_t scan_seq;              // the slot holding it
+    uint64_t scan_base;             // and its ring position
+    uint64_t scan_min;              // the pre-trigger history does not reach before it
+    uint64_t segment_end;
+    // finite acquisition, activateStream() with SOAPY_SDR_END_BURST
+    bool finite;
+    uint64_t remaining;             // samples to deliver
+    uint64_t end_pos;               // first input sample not needed, the ring may stop there
+    // readiness descriptor, see SoapyFobosNotify.hpp
+    size_t notify_len;              // stream samples, "notify" stream arg, 0 - none
+    int notify_fd;                  // pollable end
+    int notify_wfd;                 // written by the writer, the same one for an eventfd
+    std::atomic<uint64_t> notify_at;    // _rx_seq_done to signal at, UINT64_MAX - signalled
+
+    // ring samples per output sample
+    size_t factor(void) const
+    {
+        return (hf == FOBOS_HF_COMPLEX) ? 2 : decimator.factor();
+    }
+
+    void reset_dsp(void)
+    {
+        decimator.reset();
+        for (auto & halfband : halfbands)
+        {
+            halfband.reset();
+        }
+    }
+};
+//==============================================================================
+// Everything that belongs to an opened device and is worth keeping between
+// make/unmake cycles: handles, board info, sample rate table and the settings
+// last applied to the hardware.
+struct SoapyFobosHandle
+{
+    int device_index;
+    fobos_dev_t *dev_stock;
+    fobos_sdr_dev_t *dev_agile;
+    char lib_stock_version[INFO_LEN];
+    char lib_agile_version[INFO_LEN];
+    char drv_stock_version[INFO_LEN];
+    char drv_agile_version[INFO_LEN];
+    char hw_revision[INFO_LEN];
+    char fw_version[INFO_LEN];
+    char manufacturer[INFO_LEN];
+    char product[INFO_LEN];
+    char serial[INFO_LEN];
+    SoapyFobosCaps caps;
+    double sample_rate;
+    double center_frequency;
+    int direct_sampling;
+    int clock_source;
+    double lna_gain;
+    double vga_gain;
+    SoapyFobosControl applied;
+};
+//==============================================================================
+struct SoapyFobosShm;
+struct SoapyFobosNet;
+struct SoapyFobosHistory;
+struct SoapyFobosCaptureWriter;
+//==============================================================================
+// Warm handle pool (DevicePool.cpp), keyed by serial.
+// A released handle stays open for idle_s seconds and is closed afterwards,
+// unless it is taken back by the next device made with the same serial.
+// A handle whose board does not answer any more is closed instead of taken.
+bool soapy_fobos_pool_take(const std::string &serial, SoapyFobosHandle &handle);
+void soapy_fobos_pool_put(const SoapyFobosHandle &handle, double idle_s);
+std::vector<SoapyFobosHandle> soapy_fobos_pool_list(void);
 //==============================================================================
 class SoapyFobosSDR: public SoapySDR::Device
 {
@@ -99,6 +395,10 @@ public:
 
     bool hasFrequencyCorrection(const int direction, const size_t channel) const;
 
+    void setFrequencyCorrection(const int direction, const size_t channel, const double value);
+
+    double getFrequencyCorrection(const int direction, const size_t channel) const;
+
     /*******************************************************************
      * Gain API
      ******************************************************************/
@@ -107,6 +407,10 @@ public:
 
     bool hasGainMode(const int direction, const size_t channel) const;
 
+    void setGainMode(const int direction, const size_t channel, const bool automatic);
+
+    bool getGainMode(const int direction, const size_t channel) const;
+
     void setGain(const int direction, const size_t channel, const double value);
 
     void setGain(const int direction, const size_t channel, const std::string &name, const double value);
@@ -119,6 +423,12 @@ public:
      * Frequency API
      ******************************************************************/
 
+    void setFrequency(
+            const int direction,
+            const size_t channel,
+            const double frequency,
+            const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
     void setFrequency(
             const int direction,
             const size_t channel,
@@ -126,10 +436,14 @@ public:
             const double frequency,
             const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
 
+    double getFrequency(const int direction, const size_t channel) const;
+
     double getFrequency(const int direction, const size_t channel, const std::string &name) const;
 
     std::vector<std::string> listFrequencies(const int direction, const size_t channel) const;
 
+    SoapySDR::RangeList getFrequencyRange(const int direction, const size_t channel) const;
+
     SoapySDR::RangeList getFrequencyRange(const int direction, const size_t channel, const std::string &name) const;
 
     SoapySDR::ArgInfoList getFrequencyArgsInfo(const int direction, const size_t channel) const;
@@ -146,6 +460,16 @@ public:
 
     SoapySDR::RangeList getSampleRateRange(const int direction, const size_t channel) const;
 
+    /*******************************************************************
+     * Sensor API
+     ******************************************************************/
+
+    std::vector<std::string> listSensors(const int direction, const size_t channel) const;
+
+    SoapySDR::ArgInfo getSensorInfo(const int direction, const size_t channel, const std::string &key) const;
+
+    std::string readSensor(const int direction, const size_t channel, const std::string &key) const;
+
     /*******************************************************************
      * Settings API
      ******************************************************************/
@@ -173,6 +497,13 @@ private:
     char manufacturer[INFO_LEN];
     char product[INFO_LEN];
     char serial[INFO_LEN]; 
+    SoapyFobosCaps _caps;
+    double _pool_idle;                  // seconds to keep the handle open after release, 0 - close immediately
+
+    void build_caps(void);
+    void save_handle(SoapyFobosHandle &handle) const;
+    void restore_handle(const SoapyFobosHandle &handle);
+    static std::string pooled_serial(const SoapySDR::Kwargs &args);
 
     //cached settings
     double _sample_rate;
@@ -184,6 +515,49 @@ private:
     double _vga_gain;
     double _vga_gain_scale;
 
+    //resampling to a rate the hardware does not have, output = native * interp / decim
+    size_t _resample_interp;
+    size_t _resample_decim;
+    std::atomic<bool> _resample_changed;
+    SoapyFobosResampler* _resampler;        // used by the streaming thread only
+    void resampler_update(void);
+
+    //digital fine tuning, "BB" and "CORR" frequency components
+    double _bb_frequency;                   // Hz off the LO
+    double _freq_correction;                // ppm of the LO the NCO makes up for
+    std::atomic<bool> _nco_changed;
+    SoapyFobosNco _nco;                     // used by the streaming thread only, native rate
+    void nco_update(void);
+
+    //control plane, see Control.cpp
+    mutable std::mutex _ctrl_mutex;         // guards _ctrl and the cached settings above
+    std::mutex _ctrl_apply_mutex;           // serializes library control calls
+    SoapyFobosControl _ctrl;                // requested, not applied yet
+    SoapyFobosControl _ctrl_applied;        // shadow of the hardware state, mask tells which fields are known
+    std::atomic<bool> _ctrl_pending;        // set and cleared under _ctrl_mutex
+    std::atomic<bool> _ctrl_async;          // the control thread services the queue
+    std::condition_variable _ctrl_cond;     // wakes the control thread up
+    bool _ctrl_stop;
+    std::thread _ctrl_thread;               // while streaming
+    int control_submit(const SoapyFobosControl &request);
+    int control_service(void);
+    int control_apply(SoapyFobosControl &request);
+    void control_thread_loop(void);
+    std::atomic<unsigned int> _ctrl_gain_epoch;   // counts gain changes applied to the hardware
+    std::atomic<double> _ctrl_gain_db;      // applied_gain() for the streaming thread
+    std::atomic<unsigned int> _ctrl_rate_epoch;   // counts sample rate changes applied to the hardware
+    double applied_gain(void) const;
+
+    //software AGC, see Control.cpp
+    std::atomic<bool> _agc_enabled;
+    double _agc_target;                     // mean power, dBFS
+    double _agc_hysteresis;                 // dB
+    int _agc_lna_idx;
+    int _agc_vga_idx;
+    size_t _agc_holdoff;                    // slots to skip until the last change shows up in the data
+    void agc_start(void);
+    void agc_update(float power, float peak);
+
     //async api usage
     std::thread _rx_async_thread;
     void rx_async_thread_loop(void);
@@ -192,18 +566,171 @@ private:
     bool _running;
     std::mutex _rx_mutex;
     std::condition_variable _rx_cond;
-    float** _rx_bufs;
+    int _ring_format;                       // FOBOS_RING_*, "ring_format" argument
+    uint8_t** _rx_bufs;                     // slots in _ring_format
+    float* _rx_stage;                       // CF32 slot being filled, compact formats only
+    float* _rx_mix;                         // shifted transfer, when it does not go straight to the ring
+    float* _rx_resampled;                   // resampler output of one transfer
+    SoapyFobosSlot* _rx_slots;
+    // gain of the samples last returned by readStream() of any stream, the
+    // last reader wins when there are several
+    std::atomic<double> _rx_gain_read;
     size_t _rx_buffs_count;
-    size_t _rx_buff_len;
-    size_t _rx_filled;
-    size_t _rx_idx_w;
-    size_t _rx_pos_w;
-    size_t _rx_idx_r;
-    size_t _rx_pos_r;
-    uint32_t _overruns_count;
+    size_t _rx_buff_len;                    // samples per transfer, see transfer_len()
+    size_t _rx_slot_cap;                    // samples a ring slot has room for, >= _rx_buff_len
+    size_t _rx_slot_len;                    // samples per ring slot at the current rate, <= _rx_buff_len
+    uint64_t _rx_ring_pos;                  // ring position of the next slot
+    uint64_t _rx_pos_start;                 // _rx_ring_pos at rx_start(), sample counter 0
+    size_t _rx_fill;                        // samples in the slot being filled by the resampler
+    size_t _rx_fill_idx;
+    unsigned int _rx_fill_gain_epoch;
+    double _rx_fill_gain;
+    size_t slot_begin(void);
+    void slot_publish(size_t idx, const float* samples, size_t len, SoapyFobosStats &stats, unsigned int gain_epoch, double gain);
+    // The writer never waits for the readers: slot seq % _rx_buffs_count is
+    // overwritten as soon as _rx_seq_w passes seq + _rx_buffs_count.
+    std::atomic<uint64_t> _rx_seq_w;        // slots the writer has started
+    std::atomic<uint64_t> _rx_seq_done;     // slots completely written, changed with _rx_mutex locked
+    std::atomic<uint64_t> _rx_pos_done;     // ring position after them, changed with _rx_seq_done
+    uint64_t _rx_seq_start;                 // first slot since rx_start(), the ones before it are of the last run
+    uint64_t _rx_wake_at;                   // _rx_seq_done the sleeping readers wait for, guarded by _rx_mutex
+    std::atomic<uint64_t> _rx_wakeups;      // readStream() returns from sleeping
+    std::atomic<long long> _rx_start_ns;    // host steady clock time of rx_start()
+    uint64_t rx_wait(SoapyFobosStream *st, uint64_t target, std::chrono::steady_clock::time_point deadline);
+    std::atomic<uint32_t> _overruns_count;  // slots lost by all the streams
+    float* _rx_power;                       // [slot][block] mean |x|^2 of TRIGGER_BLOCK_LEN samples
+    std::atomic<int> _rx_triggers;          // streams using the power blocks
+    float _rx_noise_floor;
+    std::atomic<long long> _rx_epoch_ns;    // host steady clock time estimate of sample #0
+    std::atomic<uint64_t> _rx_stop_at;      // ring position to cancel the transfers at, 0 - never
+    uint64_t _rx_in_pos;                    // transfer samples taken since rx_start()
+    void rx_cancel(void);
+
+    //sample rate changes while streaming, see rate_boundary()
+    double _latency;                        // "latency" argument, seconds per transfer, 0 - DEFAULT_BUFF_LEN samples
+    std::atomic<unsigned int> _rx_rate_epoch;   // _ctrl_rate_epoch of the slots being written
+    double _rx_rate;                        // output rate of the slots being written
+    double _rx_native;                      // hardware rate of the transfers
+    long long _rx_rate_counter;             // sample counter of the first sample at _rx_rate
+    long long _rx_rate_time_ns;             // its time stamp
+    uint64_t _rx_rate_in;                   // transfer samples taken at _rx_native since then
+    std::atomic<long long> _rx_counter_ns;  // time stamp of sample counter 0 at _rx_rate
+    std::atomic<bool> _rx_restart;          // the transfers are being restarted with _rx_buff_next samples
+    size_t _rx_buff_next;
+    long long _rx_restart_ns;               // host steady clock time of the restart
+    bool _rx_restarted;                     // the first transfer after it is still to come
+    std::atomic<bool> _rx_stopping;
+    size_t transfer_len(double native) const;
+    size_t slot_len_for(size_t buff_len, size_t interp, size_t decim) const;
+    void rate_boundary(void);
+
+    //streams, see Streaming.cpp
+    std::mutex _streams_mutex;              // guards the list and the activation
+    std::vector<SoapyFobosStream*> _streams;
+    size_t _streams_active;
+    void rx_start(void);
+    void rx_stop(void);
+    void update_stop_at(void);
+    void ring_free(void);
+    bool slot_lost(const SoapyFobosStream *st) const;
+    std::atomic<uint64_t> _lost_samples;    // ring samples lost by all the streams
+    // spill buffers of the FOBOS_OVERFLOW_SPILL streams, the writer takes
+    // _spill_mutex only, never _streams_mutex
+    std::mutex _spill_mutex;
+    std::vector<SoapyFobosStream*> _spill_streams;
+    std::atomic<size_t> _spill_count;       // _spill_streams.size(), looked at by the writer without the lock
+    void spill_save(uint64_t seq);
+    const SoapyFobosSpillSlot * spill_front(SoapyFobosStream *st);
+    void spill_pop(SoapyFobosStream *st);
+    size_t trigger_gate(SoapyFobosStream *st, uint64_t seq_done);
+    // streams with a readiness descriptor, the writer takes _notify_mutex only
+    mutable std::mutex _notify_mutex;
+    std::vector<SoapyFobosStream*> _notify_streams;
+    std::atomic<int> _rx_notifies;
+    void notify_arm(SoapyFobosStream *st);
+    int read_stream(SoapyFobosStream *st, void * const *buffs, const size_t numElems, int &flags, long long &timeNs, const long timeoutUs);
+
+    //push model consumer, see SoapyFobosPush.hpp
+    std::mutex _push_mutex;                 // held while the callback runs
+    SoapyFobosRxHook _push;
+    std::atomic<bool> _push_set;
+    std::atomic<uint64_t> _rx_pushed;       // samples taken by the callback, not in the ring
+
+    //receive ring in shared memory, see SharedMemory.cpp
+    std::string _shm_name;                  // "shm_export" argument, empty - not exported
+    SoapyFobosShm* _shm;
+
+    //VITA-49 UDP output of the ring slots, see Network.cpp
+    SoapySDR::Kwargs _net_args;             // "udp_*" arguments, empty - no output
+    SoapyFobosNet* _net;                    // used by the streaming thread only
+    std::atomic<uint64_t> _net_packets;
+    std::atomic<uint64_t> _net_dropped;
+
+    //stages of the streaming thread chunk by chunk, see Pipeline.cpp
+    size_t _dsp_threads;                    // "dsp_threads" argument, 1 - the streaming thread alone
+    SoapyFobosPipeline* _pipeline;          // from the first setupStream() on
+    std::vector<SoapyFobosStats> _chunk_stats;  // used by the streaming thread only
+    void stage_copy(int stage, const float* src, float* dst, void* packed, size_t count, bool mix, SoapyFobosStats* stats);
+
+    //deep history of the ring slots and its snapshots, see History.cpp
+    double _history_seconds;                // "history_seconds" argument, 0 - no history
+    int _history_format;                    // FOBOS_RING_*, "history_format" argument
+    std::shared_ptr<SoapyFobosHistory> _history;    // written by the streaming thread, replaced by rx_start()
+    mutable std::mutex _snap_mutex;         // guards _history, the thread and the status
+    std::thread _snap_thread;
+    bool _snap_running;
+    std::string _snap_status;               // "snapshot" setting
+    void snapshot_write(std::shared_ptr<SoapyFobosHistory> history, std::string path, uint64_t first, uint64_t last, long long epoch_ns);
+    long long utc_epoch_ns(void) const;
+
+    //recording to an indexed chunked capture file, see Capture.cpp
+    double _record_buffer;                  // "record_buffer" argument, seconds the disk may fall behind
+    int _record_format;                     // FOBOS_RING_*, "record_format" argument
+    std::shared_ptr<SoapyFobosHistory> _rec_buffer;     // std::atomic_load() by the streaming thread
+    mutable std::mutex _rec_mutex;          // guards the thread and the status
+    std::thread _rec_thread;
+    std::atomic<bool> _rec_stop;
+    std::string _rec_status;                // "record" setting
+    void record_write(std::shared_ptr<SoapyFobosHistory> buffer, SoapyFobosCaptureWriter *writer, long long epoch_ns);
+    void record_stop(void);
+
+    //FFT correlator reading the ring behind the streaming thread, see Correlator.cpp
+    mutable std::mutex _corr_mutex;         // guards the settings, the thread and the detections
+    std::vector<std::vector<float>> _corr_refs;     // "reference" setting, CF32
+    std::vector<std::string> _corr_paths;
+    float _corr_threshold;                  // "correlator_threshold" setting
+    double _corr_offset;                    // "correlator_offset" setting, Hz
+    size_t _corr_window;                    // "correlator_window" setting, samples
+    unsigned int _corr_epoch;               // settings changes, the thread builds the correlator again
+    std::thread _corr_thread;               // while streaming with references
+    std::atomic<bool> _corr_stop;
+    std::mutex _corr_hook_mutex;            // held while the callback runs
+    SoapyFobosDetectionHook _corr_hook;
+    std::atomic<bool> _corr_hook_set;
+    mutable std::deque<SoapyFobosDetection> _corr_detections;   // taken by readSetting("detections")
+    uint64_t _corr_count;                   // detections since activateStream()
+    uint64_t _corr_lost;                    // samples the correlator has fallen behind the ring by
+    size_t _corr_fft_len;
+    void correlate_run(void);
+    void correlator_start(void);
+    void correlator_stop(void);
+    void detection_deliver(SoapyFobosDetection &detection, const float *window);
+
+    //signal statistics of the received buffers
+    mutable std::mutex _stats_mutex;
+    SoapyFobosStats _stats_history[STATS_HISTORY_LEN];
+    size_t _stats_count;                    // written since activateStream()
 
 public:
     void read_samples(float* buf, uint32_t buf_length);
 
+    // see soapy_fobos_set_rx_callback() and soapy_fobos_set_detection_callback()
+    void set_rx_hook(SoapyFobosRxCallback callback, void *user);
+    void set_detection_hook(SoapyFobosDetectionCallback callback, void *user);
+
+    // host steady clock time (ns) of the first sample of the stream, 
+    // estimated from the buffer arrival times, 0 while unknown
+    long long stream_epoch_ns(void) const;
+
 };
 //==============================================================================
@@ -0,0 +1,202 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Receive ring exported to POSIX shared memory and the device reading it
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  18.10.2026 - initial
+//  18.10.2026 - compact ring formats
+//  18.10.2026 - version 2: the slots carry their length and sample rate
+//  19.10.2026 - the client streams hold the segment they read, slot lengths checked
+//==============================================================================
+
+#pragma once
+
+#include "SoapyFobosSDR.hpp"
+#include <memory>
+//==============================================================================
+#define FOBOS_SHM_MAGIC         0x534f4246  // "FBOS"
+#define FOBOS_SHM_VERSION       2
+#define FOBOS_SHM_PREFIX        "/fobos_"
+// SoapyFobosShmHeader::state
+#define FOBOS_SHM_STOPPED       0
+#define FOBOS_SHM_RUNNING       1
+#define FOBOS_SHM_CLOSED        2
+// clients poll the write counter while waiting for data
+#define FOBOS_SHM_POLL_US       200
+//==============================================================================
+// Segment layout: header, SoapyFobosSlot[slots_count], [slots_count][slot_capacity] samples in ring_format.
+// The owner writes, the clients only read, the same way the streams of the
+// owner read its ring: slot seq % slots_count holds valid samples while
+// seq < seq_done and seq + slots_count > seq_w.
+struct SoapyFobosShmHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots_count;
+    uint32_t slot_capacity;                 // I/Q samples room per slot
+    uint32_t ring_format;                   // FOBOS_RING_*
+    uint64_t slots_offset;                  // bytes from the segment start
+    uint64_t data_offset;                   // bytes from the segment start
+    char serial[INFO_LEN];
+    std::atomic<uint32_t> owner_pid;
+    std::atomic<uint32_t> state;            // FOBOS_SHM_*
+    std::atomic<uint32_t> generation;       // incremented when the owner (re)starts streaming
+    std::atomic<uint32_t> slot_len;         // I/Q samples per slot at the current rate, SoapyFobosSlot::len tells
+    std::atomic<uint64_t> seq_w;            // slots the owner has started
+    std::atomic<uint64_t> seq_done;         // slots completely written
+    std::atomic<uint64_t> sample_rate;      // bits of double, the current one, SoapyFobosSlot::rate tells
+    std::atomic<uint64_t> frequency;        // bits of double
+};
+//==============================================================================
+// One mapping of the segment
+struct SoapyFobosShm
+{
+    std::string name;                       // shm_open() name
+    bool owner;
+    void *base;
+    size_t size;
+    SoapyFobosShmHeader *header;
+    SoapyFobosSlot *slots;
+    uint8_t *data;
+
+    void * slot_data(size_t idx) const
+    {
+        return data + idx * header->slot_capacity * fobos_ring_sample_bytes(header->ring_format);
+    }
+};
+
+// name is the user given one, FOBOS_SHM_PREFIX is prepended. create throws
+// while the process that exported the name still runs, a segment left by a
+// process that is gone, or of another version, is replaced.
+SoapyFobosShm * soapy_fobos_shm_create(const std::string &name, size_t slots_count, size_t slot_len, int ring_format, const char *serial);
+SoapyFobosShm * soapy_fobos_shm_open(const std::string &name);     // nullptr if there is no such segment
+void soapy_fobos_shm_close(SoapyFobosShm *shm);                     // the owner also removes the name
+
+double soapy_fobos_shm_get(const std::atomic<uint64_t> &value);
+void soapy_fobos_shm_set(std::atomic<uint64_t> &value, double x);
+//==============================================================================
+// "driver=fobos,shm=NAME" reads the ring exported by the process that owns
+// the device with "shm_export=NAME". Read only: the owner keeps the control
+// of frequency, gain and sample rate.
+class SoapyFobosShmClient: public SoapySDR::Device
+{
+public:
+    SoapyFobosShmClient(const SoapySDR::Kwargs &args);
+
+    ~SoapyFobosShmClient(void);
+
+    /*******************************************************************
+     * Identification API
+     ******************************************************************/
+
+    std::string getDriverKey(void) const;
+
+    std::string getHardwareKey(void) const;
+
+    SoapySDR::Kwargs getHardwareInfo(void) const;
+
+    /*******************************************************************
+     * Channels API
+     ******************************************************************/
+
+    size_t getNumChannels(const int direction) const;
+
+    /*******************************************************************
+     * Stream API
+     ******************************************************************/
+
+    std::vector<std::string> getStreamFormats(const int direction, const size_t channel) const;
+
+    std::string getNativeStreamFormat(const int direction, const size_t channel, double &fullScale) const;
+
+    SoapySDR::Stream *setupStream(const int direction, const std::string &format, const std::vector<size_t> &channels =
+            std::vector<size_t>(), const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    void closeStream(SoapySDR::Stream *stream);
+
+    size_t getStreamMTU(SoapySDR::Stream *stream) const;
+
+    int activateStream(
+            SoapySDR::Stream *stream,
+            const int flags = 0,
+            const long long timeNs = 0,
+            const size_t numElems = 0);
+
+    int deactivateStream(SoapySDR::Stream *stream, const int flags = 0, const long long timeNs = 0);
+
+    int readStream(
+            SoapySDR::Stream *stream,
+            void * const *buffs,
+            const size_t numElems,
+            int &flags,
+            long long &timeNs,
+            const long timeoutUs = 100000);
+
+    /*******************************************************************
+     * Direct buffer access API
+     ******************************************************************/
+
+    size_t getNumDirectAccessBuffers(SoapySDR::Stream *stream);
+
+    int getDirectAccessBufferAddrs(SoapySDR::Stream *stream, const size_t handle, void **buffs);
+
+    int acquireReadBuffer(
+            SoapySDR::Stream *stream,
+            size_t &handle,
+            const void **buffs,
+            int &flags,
+            long long &timeNs,
+            const long timeoutUs = 100000);
+
+    void releaseReadBuffer(SoapySDR::Stream *stream, const size_t handle);
+
+    /*******************************************************************
+     * Frequency API
+     ******************************************************************/
+
+    void setFrequency(
+            const int direction,
+            const size_t channel,
+            const std::string &name,
+            const double frequency,
+            const SoapySDR::Kwargs &args = SoapySDR::Kwargs());
+
+    double getFrequency(const int direction, const size_t channel, const std::string &name) const;
+
+    std::vector<std::string> listFrequencies(const int direction, const size_t channel) const;
+
+    /*******************************************************************
+     * Sample Rate API
+     ******************************************************************/
+
+    void setSampleRate(const int direction, const size_t channel, const double rate);
+
+    double getSampleRate(const int direction, const size_t channel) const;
+
+    std::vector<double> listSampleRates(const int direction, const size_t channel) const;
+
+private:
+    std::string _name;
+    // the segment attached last; a stream keeps the one it reads mapped
+    // until it moves on to this one, see wait_slot()
+    std::shared_ptr<SoapyFobosShm> _shm;
+    mutable std::mutex _shm_mutex;
+    std::shared_ptr<SoapyFobosShm> segment(void) const;
+
+    struct ClientStream
+    {
+        std::shared_ptr<SoapyFobosShm> shm; // the segment of seq_r and generation
+        bool active;
+        uint32_t generation;
+        uint64_t seq_r;
+        size_t pos_r;
+        unsigned int gain_epoch;
+        unsigned int rate_epoch;
+    };
+
+    int wait_slot(ClientStream *cs, const long timeoutUs);
+    bool slot_lost(const ClientStream *cs) const;
+    bool slot_take(const ClientStream *cs, SoapyFobosSlot &slot) const;
+    void resync(ClientStream *cs);
+};
+//==============================================================================
@@ -5,13 +5,59 @@
 //  05.06.2024
 //  10.11.2025 - closeStream()
 //  01.04.2026 - added support for fobos-sdr-agile
+//  18.10.2026 - control requests are applied between transfers
+//  18.10.2026 - software AGC, gain changes are flagged in readStream()
+//  18.10.2026 - signal statistics computed while copying to the ring
+//  18.10.2026 - sample counter time stamps, readStream() timeout
+//  18.10.2026 - multiple streams with own format, decimation and overruns
+//  18.10.2026 - the ring may live in shared memory, see SharedMemory.cpp
+//  18.10.2026 - triggered capture with pre-trigger history
+//  18.10.2026 - finite acquisition, activateStream() with SOAPY_SDR_END_BURST
+//  18.10.2026 - ring slots filled by the resampler at rates the hardware does not have
+//  18.10.2026 - direct sampling HF1/HF2 channels, complex at half rate or raw real
+//  18.10.2026 - compact ring, packed by the writer, expanded by readStream()
+//  18.10.2026 - overflow policy: keep, latest or spill
+//  18.10.2026 - push model callback bypassing the ring
+//  18.10.2026 - "wait_strategy" stream arg, the writer wakes only the readers whose slots are complete
+//  18.10.2026 - NCO of the "BB"/"CORR" frequency components on the way to the ring
+//  18.10.2026 - completed slots sent as VITA-49 datagrams, see Network.cpp
+//  18.10.2026 - mix, resample and pack chunk by chunk on the pipeline, see Pipeline.cpp
+//  18.10.2026 - completed slots kept in the history for the snapshots, see History.cpp
+//  18.10.2026 - "notify" stream arg, readiness descriptor signalled by the writer
+//  18.10.2026 - recorder thread writing the slots to a capture file, see Capture.cpp
+//  18.10.2026 - CS12Z: compressed by the recorder thread, UDP payloads compressed
+//  18.10.2026 - sample rate changes while streaming: tagged slots, re-sized transfers and slots
+//  19.10.2026 - correlator thread reading the slots behind the writer, see Correlator.cpp
+//  19.10.2026 - readStream() flags are output only
+//  19.10.2026 - the control requests are applied by the control thread, not in the transfer callback
+//  19.10.2026 - the writer looks at an atomic count of the spill streams, not at the vector
+//  19.10.2026 - a restart keeps the ring counters of the streams still reading it
 //==============================================================================
 
 #include "SoapyFobosSDR.hpp"
+#include "SoapyFobosShm.hpp"
+#include "SoapyFobosNet.hpp"
+#include "SoapyFobosHistory.hpp"
+#include "SoapyFobosCapture.hpp"
+#include "SoapyFobosCorrelator.hpp"
 #include <SoapySDR/Logger.hpp>
 #include <SoapySDR/Formats.hpp>
 #include <SoapySDR/Time.hpp>
 #include <cstring> 
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 std::vector<std::string> SoapyFobosSDR::getStreamFormats(const int direction, const size_t channel) const 
 {
@@ -24,6 +70,15 @@ std::vector<std::string> SoapyFobosSDR::getStreamFormats(const int direction, co
         throw std::runtime_error("RX only, use SOAPY_SDR_RX");
     }
     formats.push_back(SOAPY_SDR_CF32);
+    formats.push_back(SOAPY_SDR_CS16);
+    formats.push_back(SOAPY_SDR_CS8);
+    if (_direct_sampling)
+    {
+        // raw HF1/HF2 samples
+        formats.push_back(SOAPY_SDR_F32);
+        formats.push_back(SOAPY_SDR_S16);
+        formats.push_back(SOAPY_SDR_S8);
+    }
     return formats;
 }
 
@@ -46,25 +101,186 @@ SoapySDR::ArgInfoList SoapyFobosSDR::getStreamArgsInfo(const int direction, cons
     printf(">>> %s::%s(%d, %d)\n", __CLASS__, __FUNCTION__, direction, (int)channel);
 #endif  
     SoapySDR::ArgInfoList result;
-    if ((direction == SOAPY_SDR_RX) && (channel == 0))
+    if ((direction == SOAPY_SDR_RX) && (channel < getNumChannels(direction)))
     {
         {
             SoapySDR::ArgInfo info;
             info.key = "buf_count";
             info.value = std::to_string(DEFAULT_BUFS_COUNT);
             info.name = "Buffers count in queue";
-            info.description = "Buffers count in queue";
+            info.description = "Buffers count in queue, taken from the first stream set up";
+            info.units = "";
+            info.type = SoapySDR::ArgInfo::INT;
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "decimation";
+            info.value = "1";
+            info.name = "Decimation";
+            info.description = "Integer decimation of this stream, the output rate is the sample rate / decimation";
+            info.units = "";
+            info.type = SoapySDR::ArgInfo::INT;
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "trigger_level";
+            info.value = "0";
+            info.name = "Trigger level";
+            info.description = "Deliver only the segments with the power this much over the noise floor, 0 - continuous stream";
+            info.units = "dB";
+            info.type = SoapySDR::ArgInfo::FLOAT;
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "pretrigger";
+            info.value = "0";
+            info.name = "Pre-trigger";
+            info.description = "Samples delivered before the trigger, up to the ring length";
+            info.units = "samples";
+            info.type = SoapySDR::ArgInfo::INT;
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "hangover";
+            info.value = std::to_string(TRIGGER_BLOCK_LEN * 16);
+            info.name = "Hangover";
+            info.description = "Samples delivered after the power has dropped below the level, the segment ends with SOAPY_SDR_END_BURST";
+            info.units = "samples";
+            info.type = SoapySDR::ArgInfo::INT;
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "overflow";
+            info.value = "keep";
+            info.name = "Overflow policy";
+            info.description = "Where a stream lapped by the ring continues: keep - the oldest buffer left, latest - the newest one, spill - its own spill buffer";
+            info.type = SoapySDR::ArgInfo::STRING;
+            info.options = {"keep", "latest", "spill"};
+            result.push_back(info);
+        }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "spill_slots";
+            info.value = std::to_string(DEFAULT_SPILL_SLOTS);
+            info.name = "Spill buffers";
+            info.description = "Buffers the spill policy may hold for this stream";
             info.units = "";
             info.type = SoapySDR::ArgInfo::INT;
             result.push_back(info);
         }
+        {
+            SoapySDR::ArgInfo info;
+            info.key = "notify";
+            info.value = "0";
+            info.name = "Readiness descriptor";
+            info.description = "Samples to read that make the stream descriptor readable, 0 - no descriptor (SoapyFobosNotify.hpp)";
+            info.units = "samples";
+            info.type = SoapySDR::ArgInfo::INT;
+            result.push_back(info);
+        }
     }
     return result;
 }
 
+/*******************************************************************
+ * Readiness descriptors, see SoapyFobosNotify.hpp
+ ******************************************************************/
+static void notify_open(SoapyFobosStream *st)
+{
+#if defined(__linux__)
+    st->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    st->notify_wfd = st->notify_fd;
+#elif !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        for (int fd : fds)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        st->notify_fd = fds[0];
+        st->notify_wfd = fds[1];
+    }
+#else
+    throw std::runtime_error("!notify: not supported on this platform");
+#endif
+    if (st->notify_fd < 0)
+    {
+        throw std::runtime_error(std::string("!notify: no descriptor, ") + strerror(errno));
+    }
+}
+
+static void notify_close(SoapyFobosStream *st)
+{
+#ifndef _WIN32
+    if ((st->notify_wfd >= 0) && (st->notify_wfd != st->notify_fd))
+    {
+        close(st->notify_wfd);
+    }
+    if (st->notify_fd >= 0)
+    {
+        close(st->notify_fd);
+    }
+#endif
+    st->notify_fd = -1;
+    st->notify_wfd = -1;
+}
+
+// never blocks, a descriptor readable already stays so
+static void notify_signal(const SoapyFobosStream *st)
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+    ssize_t r = write(st->notify_wfd, &one, sizeof(one));
+    (void)r;
+#elif !defined(_WIN32)
+    char one = 1;
+    ssize_t r = write(st->notify_wfd, &one, sizeof(one));
+    (void)r;
+#else
+    (void)st;
+#endif
+}
+
+static void notify_clear(const SoapyFobosStream *st)
+{
+#if defined(__linux__)
+    uint64_t value;
+    ssize_t r = read(st->notify_fd, &value, sizeof(value));
+    (void)r;
+#elif !defined(_WIN32)
+    char data[64];
+    while (read(st->notify_fd, data, sizeof(data)) > 0)
+    {
+    }
+#else
+    (void)st;
+#endif
+}
+
 /*******************************************************************
  * Async thread work
  ******************************************************************/
+// one busy-poll step, lets the sibling hyperthread and the bus breathe
+static inline void fobos_cpu_relax(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
 static void _rx_stock_callback(float* buf, uint32_t buf_length, void* ctx)
 {
     SoapyFobosSDR * self = (SoapyFobosSDR *)ctx;
@@ -84,19 +300,59 @@ void SoapyFobosSDR::rx_async_thread_loop(void)
     printf(">>> %s::%s() started\n", __CLASS__, __FUNCTION__);
 #endif      
     int result = -1;
-    if (_dev_stock)
-    {
-        result = fobos_rx_read_async(_dev_stock, &_rx_stock_callback, this, _rx_buffs_count, _rx_buff_len);
-    }
-    else if (_dev_agile)
+    _ctrl_async = true;
+    _ctrl_stop = false;
+    _ctrl_thread = std::thread(&SoapyFobosSDR::control_thread_loop, this);
+    while (true)
     {
-        result = fobos_sdr_read_async(_dev_agile, &_rx_agile_callback, this, _rx_buffs_count, _rx_buff_len);
+        if (_dev_stock)
+        {
+            result = fobos_rx_read_async(_dev_stock, &_rx_stock_callback, this, _rx_buffs_count, _rx_buff_len);
+        }
+        else if (_dev_agile)
+        {
+            result = fobos_sdr_read_async(_dev_agile, &_rx_agile_callback, this, _rx_buffs_count, _rx_buff_len);
+        }
+        if (!_rx_restart || _rx_stopping)
+        {
+            break;
+        }
+        // canceled by a sample rate change that takes another transfer length
+        _rx_buff_len = _rx_buff_next;
+        _rx_restarted = true;
+        _rx_restart = false;
     }
 #ifdef SOAPY_FOBOS_PRINT_DEBUG  
     printf(">>> %s::%s() done: %d\n", __CLASS__, __FUNCTION__, result);
 #endif
     (void)result;
-    _running = false;
+    _rx_restart = false;
+    _ctrl_async = false;
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        _ctrl_stop = true;
+    }
+    _ctrl_cond.notify_one();
+    _ctrl_thread.join();
+    // apply what came in while the control thread was stopping
+    control_service();
+    {
+        std::lock_guard<std::mutex> lock(_rx_mutex);
+        _running = false;
+    }
+    _rx_cond.notify_all();
+}
+
+void SoapyFobosSDR::rx_cancel(void)
+{
+    if (_dev_stock)
+    {
+        fobos_rx_cancel_async(_dev_stock);
+    }
+    else if (_dev_agile)
+    {
+        fobos_sdr_cancel_async(_dev_agile);
+    }
 }
 
 void SoapyFobosSDR::read_samples(float* buf, uint32_t buf_length)
@@ -105,234 +361,2003 @@ void SoapyFobosSDR::read_samples(float* buf, uint32_t buf_length)
     printf(".");
     fflush(stdout);
 #endif      
+    if (_rx_restart)
+    {
+        // queued before the cancel, the transfers start over
+        return;
+    }
+    if (_ctrl_rate_epoch != _rx_rate_epoch)
+    {
+        // applied after the last transfer, this one has samples of both rates
+        rate_boundary();
+        return;
+    }
+    // the gain this buffer has most likely been captured with, the control
+    // thread applies the requests (never here, in the transfer callback)
+    unsigned int gain_epoch = _ctrl_gain_epoch;
+    double gain = _ctrl_gain_db;
     if (this->_rx_buff_len != buf_length)
     {
 #ifdef SOAPY_FOBOS_PRINT_DEBUG 
         printf("Err: wrong buf_length!!!");
         printf("canceling...");
 #endif
-        if (_dev_stock)
+        rx_cancel();
+    }
+    if (_rx_restarted)
+    {
+        // the samples between the cancel and this transfer are gone,
+        // their time by the host clock
+        _rx_restarted = false;
+        long long now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        long long gap_ns = now_ns - _rx_restart_ns - SoapySDR::ticksToTimeNs(_rx_buff_len, _rx_native);
+        _rx_rate_time_ns += std::max(gap_ns, 0LL);
+        _rx_counter_ns = _rx_rate_time_ns - SoapySDR::ticksToTimeNs(_rx_rate_counter, _rx_rate);
+    }
+    _buff_counter++;
+    uint64_t in_pos = _rx_in_pos;
+    _rx_in_pos += _rx_buff_len;
+    _rx_rate_in += _rx_buff_len;
+    if (_resample_changed)
+    {
+        resampler_update();
+    }
+    if (_nco_changed)
+    {
+        nco_update();
+    }
+    bool native = (_resampler == nullptr) && (_rx_fill == 0) && (_rx_slot_len == _rx_buff_len);
+    bool push = _push_set;
+    bool compact = (_ring_format != FOBOS_RING_CF32);
+    // the NCO shifts a native transfer while copying or packing it to the ring,
+    // any other path takes it shifted in _rx_mix
+    SoapyFobosStats mix_stats = SoapyFobosStats();
+    bool mixed = false;
+    if (_nco.active() && (push || !native))
+    {
+        stage_copy(FOBOS_STAGE_MIX, buf, _rx_mix, nullptr, _rx_buff_len, true, &mix_stats);
+        buf = _rx_mix;
+        mixed = true;
+    }
+    if (push)
+    {
+        // the push model consumer takes the buffer unless it is behind,
+        // the resampled ones always go to the ring
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int behind = 1;
         {
-            fobos_rx_cancel_async(_dev_stock);
+            std::lock_guard<std::mutex> lock(_push_mutex);
+            if (_push.callback)
+            {
+                behind = _push.callback(buf, _rx_buff_len, in_pos, _push.user);
+            }
         }
-        else if (_dev_agile)
+        _pipeline->account(FOBOS_STAGE_PUSH, start);
+        if ((behind == 0) && native)
         {
-            fobos_sdr_cancel_async(_dev_agile);
+            _rx_pushed += _rx_buff_len;
+            if (_agc_enabled)
+            {
+                SoapyFobosStats stats = mix_stats;
+                if (!mixed)
+                {
+                    stage_copy(FOBOS_STAGE_PACK, buf, nullptr, nullptr, _rx_buff_len, false, &stats);
+                }
+                agc_update(stats.power, stats.peak);
+            }
+            return;
         }
     }
-    std::lock_guard<std::mutex> lock(_rx_mutex);
-    if (_rx_filled < _rx_buffs_count)
+    if (native)
     {
-        memcpy(_rx_bufs[_rx_idx_w], buf, _rx_buff_len * 2 * sizeof(float));
-        _rx_idx_w = (_rx_idx_w + 1) % _rx_buffs_count;
-        _rx_filled++;
+        // native rate: one transfer is one slot
+        size_t idx = slot_begin();
+        SoapyFobosStats stats = mix_stats;
+        const float* samples = buf;
+        void* packed = compact ? _rx_bufs[idx] : nullptr;
+        if (mixed)
+        {
+            float* dst = compact ? nullptr : (float*)_rx_bufs[idx];
+            stage_copy(FOBOS_STAGE_PACK, buf, dst, packed, _rx_buff_len, false, nullptr);
+            samples = dst ? dst : buf;
+        }
+        else
+        {
+            // a compact ring takes the shifted samples from _rx_mix
+            float* dst = compact ? (_nco.active() ? _rx_mix : nullptr) : (float*)_rx_bufs[idx];
+            stage_copy(FOBOS_STAGE_PACK, buf, dst, packed, _rx_buff_len, _nco.active(), &stats);
+            samples = dst ? dst : buf;
+        }
+        slot_publish(idx, samples, _rx_buff_len, stats, gain_epoch, gain);
+        return;
     }
-    else
+    // resampled: the slots are filled with the output of one or more transfers
+    size_t count = _rx_buff_len;
+    if (_resampler)
     {
-        _overruns_count++;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-        printf("#");
-        fflush(stdout);
-#endif          
+        const SoapyFobosResampler* resampler = _resampler;
+        float* out = _rx_resampled;
+        auto task = [resampler, out](size_t chunk, size_t first, size_t len)
+        {
+            (void)chunk;
+            resampler->process_range(first, len, out + first * 2);
+        };
+        count = _resampler->load(buf, _rx_buff_len);
+        _pipeline->run(FOBOS_STAGE_RESAMPLE, count, RESAMPLE_CHUNK_MIN, task);
+        _resampler->consume();
+        buf = _rx_resampled;
+    }
+    size_t done = 0;
+    while (done < count)
+    {
+        if (_rx_fill == 0)
+        {
+            _rx_fill_idx = slot_begin();
+            _rx_fill_gain_epoch = gain_epoch;
+            _rx_fill_gain = gain;
+        }
+        size_t len = std::min(_rx_slot_len - _rx_fill, count - done);
+        float* fill = compact ? _rx_stage : (float*)_rx_bufs[_rx_fill_idx];
+        memcpy(fill + _rx_fill * 2, buf + done * 2, len * 2 * sizeof(float));
+        _rx_fill += len;
+        done += len;
+        if (_rx_fill >= _rx_slot_len)
+        {
+            SoapyFobosStats stats;
+            stage_copy(FOBOS_STAGE_PACK, fill, nullptr, compact ? _rx_bufs[_rx_fill_idx] : nullptr, _rx_slot_len, false, &stats);
+            slot_publish(_rx_fill_idx, fill, _rx_slot_len, stats, _rx_fill_gain_epoch, _rx_fill_gain);
+            _rx_fill = 0;
+        }
     }
-    _rx_cond.notify_one();
 }
 
-/*******************************************************************
- * Stream API
- ******************************************************************/
-
-//Typically setup/close should handle lengthy allocation and cleanup procedures
-SoapySDR::Stream *SoapyFobosSDR::setupStream(
-        const int direction,
-        const std::string &format,
-        const std::vector<size_t> &channels,
-        const SoapySDR::Kwargs &args)
+// Called by the streaming thread with the first transfer after a sample rate
+// change, which straddles it and is left out. The slot the resampler has been
+// filling goes out shorter, the slots of the new rate get their length from
+// the transfers of it and their time stamps continue from the last sample of
+// the old rate plus the transfers left out.
+void SoapyFobosSDR::rate_boundary(void)
 {
-    (void)args;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-    printf(">>> %s::%s(%d, %s)\n", __CLASS__, __FUNCTION__, direction, format.c_str());
-#endif      
-    if (direction != SOAPY_SDR_RX)
+    if (_rx_fill > 0)
     {
-        throw std::runtime_error("!direction: only SOAPY_SDR_RX");
+        bool compact = (_ring_format != FOBOS_RING_CF32);
+        float* fill = compact ? _rx_stage : (float*)_rx_bufs[_rx_fill_idx];
+        SoapyFobosStats stats;
+        stage_copy(FOBOS_STAGE_PACK, fill, nullptr, compact ? _rx_bufs[_rx_fill_idx] : nullptr, _rx_fill, false, &stats);
+        slot_publish(_rx_fill_idx, fill, _rx_fill, stats, _rx_fill_gain_epoch, _rx_fill_gain);
+        _rx_fill = 0;
     }
-    if (channels.size() > 1 or (channels.size() > 0 and channels.at(0) != 0))
+    long long end_ns = _rx_rate_time_ns + SoapySDR::ticksToTimeNs(_rx_rate_in, _rx_native);
+    size_t interp;
+    size_t decim;
     {
-        throw std::runtime_error("!channels: only one");
+        // applied by this thread only while streaming
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        _rx_rate_epoch = _ctrl_rate_epoch.load();
+        _rx_rate = _sample_rate;
+        interp = _resample_interp;
+        decim = _resample_decim;
     }
-    if (format != SOAPY_SDR_CF32)
+    resampler_update();
+    nco_update();
+    _rx_native = _rx_rate * decim / interp;
+    size_t buff_len = transfer_len(_rx_native);
+    _rx_slot_len = slot_len_for(buff_len, interp, decim);
+    _rx_rate_counter = (long long)(_rx_ring_pos - _rx_pos_start + _rx_pushed);
+    // this transfer, mostly at the new rate
+    _rx_rate_time_ns = end_ns + SoapySDR::ticksToTimeNs(_rx_buff_len, _rx_native);
+    _rx_counter_ns = _rx_rate_time_ns - SoapySDR::ticksToTimeNs(_rx_rate_counter, _rx_rate);
+    _rx_rate_in = 0;
+    _rx_noise_floor = 0.0f;
+    if (_shm)
     {
-        throw std::runtime_error("!format: only SOAPY_SDR_CF32");
+        _shm->header->slot_len = (uint32_t)_rx_slot_len;
+        soapy_fobos_shm_set(_shm->header->sample_rate, _rx_rate);
     }
-    _rx_bufs = new float* [_rx_buffs_count];
-    for (unsigned int i = 0; i < _rx_buffs_count; i++)
+    if (buff_len != _rx_buff_len)
     {
-        _rx_bufs[i] = new float [_rx_buff_len * 2];
+        // the transfers start over with the new length, see rx_async_thread_loop()
+        _rx_buff_next = buff_len;
+        _rx_restart_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        _rx_restart = true;
+        rx_cancel();
     }
-    return (SoapySDR::Stream *) this;
-}
-
-//Typically setup/close should handle lengthy allocation and cleanup procedures
-void SoapyFobosSDR::closeStream(SoapySDR::Stream *stream)
-{
-    (void)stream;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-    printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
-#endif 
-    if (_rx_async_thread.joinable())
+    if (_history_seconds > 0.0)
     {
-        if (_dev_stock)
+        // a history holds one rate, it starts over, a snapshot still
+        // writing the old one keeps its own reference
+        std::shared_ptr<SoapyFobosHistory> history;
+        try
         {
-            fobos_rx_cancel_async(_dev_stock);
+            history.reset(soapy_fobos_history_create(_history_seconds, _rx_rate, _rx_slot_len, _history_format),
+                    soapy_fobos_history_close);
         }
-        else if (_dev_agile)
+        catch (const std::exception &e)
         {
-            fobos_sdr_cancel_async(_dev_agile);
+            SoapySDR_logf(SOAPY_SDR_ERROR, "%s", e.what());
         }
-        _rx_async_thread.join();
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        _history.swap(history);
     }
-    if (_rx_bufs)
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "Sample rate %f from sample %lld, %d per slot, %d per transfer", _rx_rate,
+            _rx_rate_counter, (int)_rx_slot_len, (int)buff_len);
+}
+
+// Samples per transfer: "latency" seconds at the hardware rate in whole
+// LATENCY_BUFF_ALIGN blocks, as long as a ring slot takes them
+size_t SoapyFobosSDR::transfer_len(double native) const
+{
+    if (_latency <= 0.0)
     {
-        for (unsigned int i = 0; i < _rx_buffs_count; i++)
-        {
-            if (_rx_bufs[i])
-            {
-                delete _rx_bufs[i];
-            }
-        }
-        delete _rx_bufs;
+        return _rx_slot_cap;
     }
-    _rx_bufs = nullptr;
+    size_t len = (size_t)(native * _latency) / LATENCY_BUFF_ALIGN * LATENCY_BUFF_ALIGN;
+    return std::min(std::max(len, (size_t)LATENCY_BUFF_ALIGN), _rx_slot_cap);
 }
 
-size_t SoapyFobosSDR::getStreamMTU(SoapySDR::Stream *stream) const
+// The ring slots carry the output rate, about one transfer each
+size_t SoapyFobosSDR::slot_len_for(size_t buff_len, size_t interp, size_t decim) const
 {
-    (void)stream;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-    printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
-#endif     
-    return _rx_buff_len;
+    if (decim <= interp)
+    {
+        return buff_len;
+    }
+    return std::max(buff_len * interp / decim / TRIGGER_BLOCK_LEN, (size_t)1) * TRIGGER_BLOCK_LEN;
 }
 
-// activate/deactivate may be called multiple times and should be lightweight on and off switches
-int SoapyFobosSDR::activateStream(
-        SoapySDR::Stream *stream,
-        const int flags,
-        const long long timeNs,
-        const size_t numElems)
+// Copies (dst) or packs to a compact ring slot (packed) count samples of src,
+// shifted by the NCO when mix, with the statistics of src when stats;
+// chunk by chunk on the pipeline. A mixed compact slot needs dst as well.
+void SoapyFobosSDR::stage_copy(int stage, const float* src, float* dst, void* packed, size_t count, bool mix, SoapyFobosStats* stats)
 {
-    (void)stream;
-    (void)timeNs;
-    (void)numElems;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-    printf(">>> %s::%s(%d, %lld, %d)\n", __CLASS__, __FUNCTION__, flags, timeNs, (int)numElems);
-#endif     
-    if (flags != 0)
+    int format = _ring_format;
+    size_t sample_bytes = fobos_ring_sample_bytes(format);
+    SoapyFobosStats* parts = _chunk_stats.data();
+    const SoapyFobosNco &nco = _nco;
+    auto task = [&](size_t chunk, size_t first, size_t len)
     {
-        return SOAPY_SDR_NOT_SUPPORTED;
+        const float* in = src + first * 2;
+        const float* out = in;
+        if (mix)
+        {
+            nco.mix_at(in, dst + first * 2, len, first, parts[chunk]);
+            out = dst + first * 2;
+        }
+        else if (dst)
+        {
+            if (stats)
+            {
+                fobos_copy_stats(dst + first * 2, in, len, parts[chunk]);
+            }
+            else
+            {
+                memcpy(dst + first * 2, in, len * 2 * sizeof(float));
+            }
+            out = dst + first * 2;
+        }
+        else if (stats)
+        {
+            fobos_stats(in, len, parts[chunk]);
+        }
+        if (packed)
+        {
+            fobos_ring_pack(format, out, (uint8_t*)packed + first * sample_bytes, len);
+        }
+    };
+    _pipeline->run(stage, count, STAGE_CHUNK_MIN, task);
+    if (mix)
+    {
+        _nco.advance(count);
     }
-    _rx_idx_w = 0;
-    _rx_pos_r = 0;
-    _rx_idx_r = 0;
-    _rx_pos_w = 0;
-    _rx_filled = 0;
-    _running = true;
-    _buff_counter = 0;
-    _overruns_count = 0;
-    if (not _rx_async_thread.joinable())
+    if (stats)
     {
-        _rx_async_thread = std::thread(&SoapyFobosSDR::rx_async_thread_loop, this);
+        size_t len = _pipeline->chunk_len(count, STAGE_CHUNK_MIN);
+        size_t chunks = _pipeline->chunks(count, STAGE_CHUNK_MIN);
+        *stats = parts[0];
+        for (size_t c = 1; c < chunks; c++)
+        {
+            fobos_stats_add(*stats, c * len, parts[c], std::min(len, count - c * len));
+        }
     }
-    return 0;
 }
 
-// activate / deactivate may be called multiple times and should be lightweight on and off switches
-int SoapyFobosSDR::deactivateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs)
+// Takes the next slot for writing, returns its index.
+// The readers of the slot being overwritten see the new _rx_seq_w
+// before any of the new samples, see slot_lost()
+size_t SoapyFobosSDR::slot_begin(void)
 {
-    (void)stream;
-    (void)timeNs;
-#ifdef SOAPY_FOBOS_PRINT_DEBUG  
-    printf(">>> %s::%s(%d, %lld)\n", __CLASS__, __FUNCTION__, flags, timeNs);
-#endif     
-    if (flags != 0)
+    uint64_t seq = _rx_seq_w.load(std::memory_order_relaxed);
+    if (_spill_count.load(std::memory_order_relaxed) > 0)
     {
-        return SOAPY_SDR_NOT_SUPPORTED;
+        spill_save(seq);
     }
-    if (_rx_async_thread.joinable())
+    _rx_seq_w.store(seq + 1, std::memory_order_relaxed);
+    if (_shm)
     {
-        if (_dev_stock)
-        {
-            fobos_rx_cancel_async(_dev_stock);
-        }
-        else if (_dev_agile)
-        {
-            fobos_sdr_cancel_async(_dev_agile);
-        }
-        _rx_async_thread.join();
+        _shm->header->seq_w.store(seq + 1, std::memory_order_relaxed);
     }
-    return 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq % _rx_buffs_count;
 }
 
-int SoapyFobosSDR::readStream(
-        SoapySDR::Stream *stream,
-        void * const *buffs,
-        const size_t numElems,
-        int &flags,
-        long long &timeNs,
-        const long timeoutUs)
+// Completes the slot taken by slot_begin() and wakes the readers up,
+// samples are the len CF32 ones stored in the slot
+void SoapyFobosSDR::slot_publish(size_t idx, const float* samples, size_t len, SoapyFobosStats &stats, unsigned int gain_epoch, double gain)
 {
-    (void)stream;
-    (void)timeNs;
-    (void)timeoutUs;
-
-    if (flags != 0)
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t seq = _rx_seq_w.load(std::memory_order_relaxed) - 1;
+    // the buffers taken by the push model consumer never reached the ring
+    // but the sample counter has gone past them
+    uint64_t ring_pos = _rx_ring_pos;
+    _rx_ring_pos += len;
+    long long counter = (long long)(ring_pos - _rx_pos_start + _rx_pushed);
+    stats.counter = seq;
+    uint64_t stop_at = _rx_stop_at;
+    if ((stop_at != 0) && (ring_pos + len >= stop_at))
     {
-        return SOAPY_SDR_NOT_SUPPORTED;
+        // the finite streams have got everything, no more transfers
+        rx_cancel();
+        _rx_stop_at = 0;
     }
-    if (!_running)
+    SoapyFobosSlot & slot = _rx_slots[idx];
+    slot.counter = counter;
+    slot.pos = ring_pos;
+    slot.len = (uint32_t)len;
+    slot.gain_epoch = gain_epoch;
+    slot.gain = gain;
+    slot.rate_epoch = _rx_rate_epoch;
+    slot.rate = _rx_rate;
+    slot.rate_counter = _rx_rate_counter;
+    slot.rate_time_ns = _rx_rate_time_ns;
+    // the last sample of this slot has just arrived, USB latency only makes it later
+    long long now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    long long epoch_ns = now_ns - slot.time_ns(len);
+    if ((_rx_epoch_ns == 0) || (epoch_ns < _rx_epoch_ns))
     {
-#ifdef SOAPY_FOBOS_PRINT_DEBUG        
-        printf("^%d ", (int)numElems);
-#endif
-        return 0;
+        _rx_epoch_ns = epoch_ns;
     }
+    if (_rx_triggers > 0)
     {
-        std::unique_lock<std::mutex> lock(_rx_mutex);
-        if (_rx_filled == 0)
+        // power of the blocks for the triggered streams, the noise floor
+        // follows the quiet blocks slowly and any drop quickly
+        size_t blocks = len / TRIGGER_BLOCK_LEN;
+        float* power = _rx_power + idx * (_rx_slot_cap / TRIGGER_BLOCK_LEN);
+        fobos_block_power(samples, len, TRIGGER_BLOCK_LEN, power);
+        for (size_t b = 0; b < blocks; b++)
         {
-#ifdef SOAPY_FOBOS_PRINT_DEBUG        
-            printf("w");
-#endif
-            _rx_cond.wait(lock);
+            if ((_rx_noise_floor == 0.0f) || (power[b] < _rx_noise_floor))
+            {
+                _rx_noise_floor += (power[b] - _rx_noise_floor) * ((_rx_noise_floor == 0.0f) ? 1.0f : TRIGGER_FLOOR_DOWN);
+            }
+            else if (power[b] < _rx_noise_floor * TRIGGER_FLOOR_GATE)
+            {
+                _rx_noise_floor += (power[b] - _rx_noise_floor) * TRIGGER_FLOOR_UP;
+            }
         }
     }
-    size_t samples_count = 0;
-    if (_rx_filled > 0)
+    slot.noise_floor = _rx_noise_floor;
+    if (_shm)
+    {
+        soapy_fobos_shm_set(_shm->header->frequency, _center_frequency);
+        _shm->header->seq_done.store(seq + 1, std::memory_order_release);
+    }
+    bool wake;
     {
-        float* src_buff = _rx_bufs[_rx_idx_r] + _rx_pos_r * 2;
-        samples_count = (_rx_buff_len - _rx_pos_r);
-        if (samples_count > numElems)
+        std::lock_guard<std::mutex> lock(_rx_mutex);
+        _rx_seq_done = seq + 1;
+        _rx_pos_done = ring_pos + len;
+        // the sleeping readers have said how many slots they wait for
+        wake = (seq + 1 >= _rx_wake_at);
+        if (wake)
         {
-            samples_count = numElems;
+            _rx_wake_at = UINT64_MAX;
         }
-        void* dst_buf = buffs[0]; //this is the user's buffer for channel 0
-        memcpy(dst_buf, src_buff, samples_count * 2 * sizeof(float));
-        _rx_pos_r += samples_count;
-        if (_rx_pos_r >= _rx_buff_len)
+    }
+    if (wake)
+    {
+        _rx_cond.notify_all();
+    }
+    if (_rx_notifies > 0)
+    {
+        std::lock_guard<std::mutex> lock(_notify_mutex);
+        for (auto st : _notify_streams)
         {
-            std::lock_guard<std::mutex> lock(_rx_mutex);
-            _rx_pos_r = 0;
-            _rx_idx_r = (_rx_idx_r + 1) % _rx_buffs_count;
-            _rx_filled--;
+            uint64_t at = st->notify_at.load();
+            if ((seq + 1 >= at) && st->notify_at.compare_exchange_strong(at, UINT64_MAX))
+            {
+                notify_signal(st);
+            }
         }
     }
-    else
+    std::shared_ptr<SoapyFobosHistory> recording = std::atomic_load(&_rec_buffer);
+    if (_history || recording)
     {
+        SoapyFobosHistorySlot entry;
+        entry.counter = counter;
+        entry.frequency = _center_frequency + _bb_frequency;
+        entry.gain = gain;
+        entry.power = stats.power;
+        entry.peak = stats.peak;
+        entry.clips = stats.clips;
+        // the short slot ending a rate is left out, the history starts over
+        if (_history && (_history->slot_len == len))
+        {
+            soapy_fobos_history_put(_history.get(), samples, _rx_bufs[idx], _ring_format, entry);
+        }
+        if (recording && (recording->slot_len == len))
+        {
+            soapy_fobos_history_put(recording.get(), samples, _rx_bufs[idx], _ring_format, entry);
+        }
+    }
+    if (_net)
+    {
+        // straight from here, no reader in between
+        soapy_fobos_net_send(_net, samples, len, (uint64_t)counter);
+        _net_packets = _net->packets;
+        _net_dropped = _net->dropped;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_stats_mutex);
+        _stats_history[_stats_count % STATS_HISTORY_LEN] = stats;
+        _stats_count++;
+    }
+    if (_agc_enabled)
+    {
+        agc_update(stats.power, stats.peak);
+    }
+    _pipeline->account(FOBOS_STAGE_PUBLISH, start);
+}
+
+// Slot seq is about to overwrite slot seq - _rx_buffs_count, it goes to the
+// spill buffers of the streams that have not read it yet. A full spill
+// buffer does not take it, the stream finds the gap.
+void SoapyFobosSDR::spill_save(uint64_t seq)
+{
+    if (seq < _rx_buffs_count)
+    {
+        return;
+    }
+    uint64_t old = seq - _rx_buffs_count;
+    size_t idx = old % _rx_buffs_count;
+    size_t bytes = _rx_slots[idx].len * fobos_ring_sample_bytes(_ring_format);
+    std::lock_guard<std::mutex> lock(_spill_mutex);
+    for (auto st : _spill_streams)
+    {
+        if (!st->active || (st->spill_pos.load(std::memory_order_relaxed) > old))
+        {
+            continue;
+        }
+        std::lock_guard<std::mutex> spill_lock(st->spill_mutex);
+        if (st->spill.size() >= st->spill_max)
+        {
+            continue;
+        }
+        SoapyFobosSpillSlot entry;
+        entry.seq = old;
+        entry.slot = _rx_slots[idx];
+        if (!st->spill_free.empty())
+        {
+            entry.data.swap(st->spill_free.back());
+            st->spill_free.pop_back();
+        }
+        entry.data.resize(bytes);
+        memcpy(entry.data.data(), _rx_bufs[idx], bytes);
+        st->spill.push_back(std::move(entry));
+    }
+}
+
+// Snapshot thread, see writeSetting("snapshot")
+void SoapyFobosSDR::snapshot_write(std::shared_ptr<SoapyFobosHistory> history, std::string path, uint64_t first, uint64_t last, long long epoch_ns)
+{
+    std::string status;
+    std::string hw = std::string("Fobos SDR ") + serial;
+    if (soapy_fobos_history_dump(history.get(), path, first, last, epoch_ns, hw, status))
+    {
+        SoapySDR_logf(SOAPY_SDR_INFO, "Snapshot %s", status.c_str());
+    }
+    else
+    {
+        SoapySDR_logf(SOAPY_SDR_ERROR, "Snapshot %s", status.c_str());
+    }
+    std::lock_guard<std::mutex> lock(_snap_mutex);
+    _snap_status = status;
+    _snap_running = false;
+}
+
+// UTC (ns since 1970) of sample counter 0 from the host steady clock estimate, 0 - unknown.
+// After a rate change the one counter 0 would have at the current rate, so
+// the counters of the slots since then tell their UTC.
+long long SoapyFobosSDR::utc_epoch_ns(void) const
+{
+    long long epoch_ns = _rx_epoch_ns;
+    if (epoch_ns != 0)
+    {
+        epoch_ns += _rx_counter_ns + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() -
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    return epoch_ns;
+}
+
+// Recorder thread, see writeSetting("record"): drains the buffer to the file
+// until stopped and the streaming thread has let go of the buffer
+void SoapyFobosSDR::record_write(std::shared_ptr<SoapyFobosHistory> buffer, SoapyFobosCaptureWriter *writer, long long epoch_ns)
+{
+    std::string path = writer->path;
+    std::vector<uint8_t> data(buffer->slot_bytes);
+    // compressed: the buffer holds CS12, encoded here off the streaming thread
+    bool compressed = (writer->header.format == FOBOS_CAPTURE_CS12Z);
+    std::vector<float> expanded;
+    std::vector<uint8_t> encoded;
+    if (compressed)
+    {
+        expanded.resize(buffer->slot_len * 2);
+        encoded.resize(fobos_z12_bound(buffer->slot_len) + FOBOS_Z12_BLOCK_MAX);
+    }
+    uint64_t seq = 0;
+    uint64_t lost = 0;
+    bool ok = true;
+    while (ok)
+    {
+        bool stop = _rec_stop;
+        if (seq >= buffer->seq_done.load(std::memory_order_acquire))
+        {
+            if (stop && (buffer.use_count() == 1) && (seq >= buffer->seq_done.load(std::memory_order_acquire)))
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(FOBOS_RECORD_POLL_MS));
+            continue;
+        }
+        size_t idx = seq % buffer->slots_count;
+        memcpy(data.data(), buffer->data + idx * buffer->slot_bytes, buffer->slot_bytes);
+        SoapyFobosHistorySlot slot = buffer->slots[idx];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer->seq_w.load(std::memory_order_relaxed) > seq + buffer->slots_count)
+        {
+            // the disk has fallen behind by more than record_buffer
+            lost += buffer->slot_len;
+            seq++;
+            continue;
+        }
+        SoapyFobosCaptureChunk chunk;
+        chunk.clips = slot.clips;
+        chunk.counter = slot.counter;
+        chunk.time_ns = (epoch_ns != 0) ? epoch_ns + (long long)llround(slot.counter * 1E9 / buffer->sample_rate) : 0;
+        chunk.frequency = slot.frequency;
+        chunk.gain = slot.gain;
+        chunk.power = slot.power;
+        chunk.peak = slot.peak;
+        if (compressed)
+        {
+            fobos_ring_unpack(FOBOS_RING_CS12, data.data(), 0, expanded.data(), buffer->slot_len);
+            size_t consumed;
+            size_t bytes = fobos_z12_encode(expanded.data(), buffer->slot_len, encoded.data(), encoded.size(), consumed);
+            ok = soapy_fobos_capture_write(writer, chunk, encoded.data(), bytes);
+        }
+        else
+        {
+            ok = soapy_fobos_capture_write(writer, chunk, data.data(), buffer->slot_bytes);
+        }
+        seq++;
+    }
+    std::string error;
+    uint64_t chunks = writer->index.size();
+    std::string status;
+    if (soapy_fobos_capture_finish(writer, error))
+    {
+        char text[64];
+        snprintf(text, sizeof(text), ": %llu chunks, %llu samples lost", (unsigned long long)chunks, (unsigned long long)lost);
+        status = "done " + path + text;
+        SoapySDR_logf(SOAPY_SDR_INFO, "Record %s", status.c_str());
+    }
+    else
+    {
+        status = "error " + error;
+        SoapySDR_logf(SOAPY_SDR_ERROR, "Record %s", status.c_str());
+    }
+    std::lock_guard<std::mutex> lock(_rec_mutex);
+    _rec_status = status;
+}
+
+// Ends the recording, if any, once the slots buffered so far are written
+void SoapyFobosSDR::record_stop(void)
+{
+    std::atomic_store(&_rec_buffer, std::shared_ptr<SoapyFobosHistory>());
+    _rec_stop = true;
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(_rec_mutex);
+        thread.swap(_rec_thread);
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+// Correlator thread, see writeSetting("reference"): reads the slots behind the
+// streaming thread like a stream that never holds the writer up, until stopped
+// and every slot written so far is read
+void SoapyFobosSDR::correlate_run(void)
+{
+    std::unique_ptr<SoapyFobosCorrelator> correlator;
+    bool built = false;
+    unsigned int epoch = 0;
+    size_t window = 0;
+    std::vector<float> samples(_rx_slot_cap * 2);
+    std::vector<SoapyFobosCorrelatorHit> hits;
+    // the last samples, for the windows around the detections
+    std::vector<float> recent;
+    long long recent_counter = 0;
+    size_t recent_keep = 0;
+    struct WindowWait
+    {
+        SoapyFobosDetection detection;
+        long long end;                      // counter after the last sample of the window
+    };
+    std::deque<WindowWait> waits;
+    SoapyFobosSlot segment = SoapyFobosSlot();  // a slot of the samples being correlated
+    long long next_counter = -1;            // -1 - the next slot starts over
+    uint64_t next_pos = 0;
+    uint64_t seq = _rx_seq_done;
+
+    // the hits of the samples of segment to detections
+    auto detect = [&](void)
+    {
+        for (const auto &hit : hits)
+        {
+            SoapyFobosDetection detection;
+            detection.reference = (uint32_t)hit.reference;
+            detection.peak = hit.peak;
+            detection.power = hit.power;
+            detection.frequency_offset = hit.bin * correlator->bin_hz();
+            detection.counter = hit.counter;
+            detection.time_ns = segment.time_ns(hit.counter - segment.counter);
+            detection.window_counter = 0;
+            detection.window_len = 0;
+            if (window == 0)
+            {
+                detection_deliver(detection, nullptr);
+                continue;
+            }
+            // centered on the samples matched
+            WindowWait wait;
+            wait.detection = detection;
+            wait.detection.window_counter = hit.counter + (long long)(hit.len / 2) - (long long)(window / 2);
+            wait.end = wait.detection.window_counter + (long long)window;
+            waits.push_back(wait);
+        }
+        hits.clear();
+    };
+    // the windows complete by now, all of them with the samples there are
+    auto deliver = [&](bool all)
+    {
+        long long recent_end = recent_counter + (long long)(recent.size() / 2);
+        while (!waits.empty() && (all || (waits.front().end <= recent_end)))
+        {
+            SoapyFobosDetection &detection = waits.front().detection;
+            long long first = std::max(detection.window_counter, recent_counter);
+            long long last = std::min(waits.front().end, recent_end);
+            detection.window_counter = first;
+            detection.window_len = (last > first) ? (size_t)(last - first) : 0;
+            detection_deliver(detection, (detection.window_len > 0) ? recent.data() + (first - recent_counter) * 2 : nullptr);
+            waits.pop_front();
+        }
+    };
+
+    for (;;)
+    {
+        bool stop = _corr_stop;
+        bool changed;
+        {
+            std::lock_guard<std::mutex> lock(_corr_mutex);
+            changed = !built || (_corr_epoch != epoch);
+        }
+        if (changed)
+        {
+            if (correlator)
+            {
+                correlator->reset(0, correlator->sample_rate(), hits);
+                detect();
+                deliver(true);
+            }
+            std::vector<std::vector<float>> references;
+            float threshold;
+            double offset;
+            {
+                std::lock_guard<std::mutex> lock(_corr_mutex);
+                references = _corr_refs;
+                threshold = _corr_threshold;
+                offset = _corr_offset;
+                window = _corr_window;
+                epoch = _corr_epoch;
+            }
+            correlator.reset(references.empty() ? nullptr : new SoapyFobosCorrelator(references, threshold, offset));
+            {
+                std::lock_guard<std::mutex> lock(_corr_mutex);
+                _corr_fft_len = correlator ? correlator->fft_len() : 0;
+            }
+            built = true;
+            next_counter = -1;
+        }
+        if (seq >= _rx_seq_done.load(std::memory_order_acquire))
+        {
+            if (stop)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(FOBOS_CORRELATOR_POLL_MS));
+            continue;
+        }
+        size_t idx = seq % _rx_buffs_count;
+        SoapyFobosSlot slot = _rx_slots[idx];
+        if (correlator)
+        {
+            fobos_ring_unpack(_ring_format, _rx_bufs[idx], 0, samples.data(), std::min((size_t)slot.len, _rx_slot_cap));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t seq_w = _rx_seq_w.load(std::memory_order_relaxed);
+        if (seq + _rx_buffs_count <= seq_w)
+        {
+            // lapped, on with the oldest slot, the ring positions tell the samples lost
+            seq = seq_w - std::min(seq_w, (uint64_t)_rx_buffs_count - 2);
+            continue;
+        }
+        seq++;
+        if (!correlator)
+        {
+            continue;
+        }
+        if ((slot.counter != next_counter) || (slot.rate_epoch != segment.rate_epoch))
+        {
+            if ((next_counter >= 0) && (slot.pos > next_pos))
+            {
+                std::lock_guard<std::mutex> lock(_corr_mutex);
+                _corr_lost += slot.pos - next_pos;
+            }
+            // a gap or a new rate, the samples before it are done
+            correlator->reset(slot.counter, slot.rate, hits);
+            detect();
+            deliver(true);
+            recent.clear();
+            recent_counter = slot.counter;
+            recent_keep = window + correlator->delay();
+        }
+        segment = slot;
+        next_counter = slot.counter + slot.len;
+        next_pos = slot.pos + slot.len;
+        if (window > 0)
+        {
+            recent.insert(recent.end(), samples.begin(), samples.begin() + slot.len * 2);
+        }
+        correlator->process(samples.data(), slot.len, hits);
+        detect();
+        deliver(false);
+        size_t kept = recent.size() / 2;
+        if (kept > recent_keep * 2)
+        {
+            // the windows waiting and the ones the next hits may ask for
+            long long drop = (long long)(kept - recent_keep);
+            for (const auto &wait : waits)
+            {
+                drop = std::min(drop, wait.detection.window_counter - recent_counter);
+            }
+            if (drop > 0)
+            {
+                recent.erase(recent.begin(), recent.begin() + drop * 2);
+                recent_counter += drop;
+            }
+        }
+    }
+    if (correlator)
+    {
+        // the end of the samples completes the detections waiting
+        correlator->reset(0, correlator->sample_rate(), hits);
+        detect();
+        deliver(true);
+    }
+}
+
+// Called by the correlator thread, the callback first
+void SoapyFobosSDR::detection_deliver(SoapyFobosDetection &detection, const float *window)
+{
+    {
+        std::lock_guard<std::mutex> lock(_corr_hook_mutex);
+        if (_corr_hook.callback)
+        {
+            _corr_hook.callback(&detection, window, _corr_hook.user);
+        }
+    }
+    SoapySDR_logf(SOAPY_SDR_DEBUG, "Detection of reference %u at %lld, %+.0f Hz, peak %.3f",
+            detection.reference, detection.counter, detection.frequency_offset, detection.peak);
+    std::lock_guard<std::mutex> lock(_corr_mutex);
+    _corr_count++;
+    _corr_detections.push_back(detection);
+    if (_corr_detections.size() > FOBOS_DETECTIONS_MAX)
+    {
+        _corr_detections.pop_front();
+    }
+}
+
+// Starts the correlator thread while streaming with references,
+// must be called with _streams_mutex locked
+void SoapyFobosSDR::correlator_start(void)
+{
+    std::lock_guard<std::mutex> lock(_corr_mutex);
+    if (_corr_thread.joinable() || _corr_refs.empty())
+    {
+        return;
+    }
+    _corr_stop = false;
+    _corr_count = 0;
+    _corr_lost = 0;
+    _corr_thread = std::thread(&SoapyFobosSDR::correlate_run, this);
+}
+
+// Stops the correlator thread once it has read the slots written so far
+void SoapyFobosSDR::correlator_stop(void)
+{
+    _corr_stop = true;
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(_corr_mutex);
+        thread.swap(_corr_thread);
+    }
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+// The oldest spilled slot the stream still needs, nullptr if none.
+// The writer only appends, the slot stays in place until spill_pop().
+const SoapyFobosSpillSlot * SoapyFobosSDR::spill_front(SoapyFobosStream *st)
+{
+    std::lock_guard<std::mutex> lock(st->spill_mutex);
+    while (!st->spill.empty() && (st->spill.front().seq < st->seq_r))
+    {
+        st->spill_free.push_back(std::move(st->spill.front().data));
+        st->spill.pop_front();
+    }
+    return st->spill.empty() ? nullptr : &st->spill.front();
+}
+
+void SoapyFobosSDR::spill_pop(SoapyFobosStream *st)
+{
+    std::lock_guard<std::mutex> lock(st->spill_mutex);
+    if (!st->spill.empty())
+    {
+        st->spill_free.push_back(std::move(st->spill.front().data));
+        st->spill.pop_front();
+    }
+}
+
+// Picks up the rate set by setSampleRate(), called by the streaming thread
+// or before it starts
+void SoapyFobosSDR::resampler_update(void)
+{
+    std::lock_guard<std::mutex> lock(_ctrl_mutex);
+    _resample_changed = false;
+    delete _resampler;
+    _resampler = nullptr;
+    if (_resample_decim > _resample_interp)
+    {
+        _resampler = new SoapyFobosResampler(_resample_interp, _resample_decim);
+    }
+}
+
+// The NCO runs at the native rate ahead of the resampler. A signal at RF + BB
+// is moved to 0 Hz, the LO CORR ppm too high is made up for as well.
+void SoapyFobosSDR::nco_update(void)
+{
+    std::lock_guard<std::mutex> lock(_ctrl_mutex);
+    _nco_changed = false;
+    double native = _sample_rate * _resample_decim / _resample_interp;
+    double shift = -_bb_frequency + _center_frequency * _freq_correction * 1E-6;
+    _nco.set(((_direct_sampling == 0) && (native > 0.0)) ? shift / native : 0.0);
+}
+
+/*******************************************************************
+ * Stream API
+ ******************************************************************/
+
+//Typically setup/close should handle lengthy allocation and cleanup procedures
+SoapySDR::Stream *SoapyFobosSDR::setupStream(
+        const int direction,
+        const std::string &format,
+        const std::vector<size_t> &channels,
+        const SoapySDR::Kwargs &args)
+{
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s(%d, %s)\n", __CLASS__, __FUNCTION__, direction, format.c_str());
+#endif      
+    if (direction != SOAPY_SDR_RX)
+    {
+        throw std::runtime_error("!direction: only SOAPY_SDR_RX");
+    }
+    std::vector<size_t> stream_channels = channels;
+    if (stream_channels.empty())
+    {
+        stream_channels.push_back(0);
+    }
+    bool real_format = (format == SOAPY_SDR_F32) || (format == SOAPY_SDR_S16) || (format == SOAPY_SDR_S8);
+    if (_direct_sampling)
+    {
+        // HF1 and HF2, one or both in any order
+        for (size_t channel : stream_channels)
+        {
+            if ((channel > 1) || (std::count(stream_channels.begin(), stream_channels.end(), channel) > 1))
+            {
+                throw std::runtime_error("!channels: 0 (HF1) and/or 1 (HF2) in the direct sampling mode");
+            }
+        }
+    }
+    else
+    {
+        if ((stream_channels.size() > 1) || (stream_channels.at(0) != 0))
+        {
+            throw std::runtime_error("!channels: only one");
+        }
+        if (real_format)
+        {
+            throw std::runtime_error("!format: real formats are for the direct sampling mode only");
+        }
+    }
+    if ((format != SOAPY_SDR_CF32) && (format != SOAPY_SDR_CS16) && (format != SOAPY_SDR_CS8) && !real_format)
+    {
+        throw std::runtime_error("!format: only SOAPY_SDR_CF32, SOAPY_SDR_CS16, SOAPY_SDR_CS8, SOAPY_SDR_F32, SOAPY_SDR_S16, SOAPY_SDR_S8");
+    }
+    size_t decimation = 1;
+    if (args.count("decimation") != 0)
+    {
+        decimation = std::stoul(args.at("decimation"));
+        if ((decimation < 1) || (decimation > _rx_slot_cap))
+        {
+            throw std::runtime_error("!decimation: " + args.at("decimation"));
+        }
+        if ((decimation > 1) && _direct_sampling)
+        {
+            throw std::runtime_error("!decimation: not in the direct sampling mode, use setSampleRate()");
+        }
+    }
+    float trigger_level = 0.0f;
+    if (args.count("trigger_level") != 0)
+    {
+        trigger_level = std::stof(args.at("trigger_level"));
+    }
+    int overflow = FOBOS_OVERFLOW_KEEP;
+    if (args.count("overflow") != 0)
+    {
+        const std::string &policy = args.at("overflow");
+        if (policy == "latest")
+        {
+            overflow = FOBOS_OVERFLOW_LATEST;
+        }
+        else if (policy == "spill")
+        {
+            overflow = FOBOS_OVERFLOW_SPILL;
+        }
+        else if (policy != "keep")
+        {
+            throw std::runtime_error("!overflow: " + policy + ", only keep, latest, spill");
+        }
+    }
+    int wait = FOBOS_WAIT_BLOCK;
+    size_t coalesce = 1;
+    if (args.count("wait_strategy") != 0)
+    {
+        const std::string &strategy = args.at("wait_strategy");
+        if (strategy == "spin")
+        {
+            wait = FOBOS_WAIT_SPIN;
+        }
+        else if (strategy == "hybrid")
+        {
+            wait = FOBOS_WAIT_HYBRID;
+        }
+        else if (strategy.compare(0, 9, "coalesce=") == 0)
+        {
+            wait = FOBOS_WAIT_COALESCE;
+            coalesce = std::stoul(strategy.substr(9));
+            if (coalesce == 0)
+            {
+                throw std::runtime_error("!wait_strategy: " + strategy + ", at least 1 slot");
+            }
+        }
+        else if (strategy != "block")
+        {
+            throw std::runtime_error("!wait_strategy: " + strategy + ", only block, spin, hybrid, coalesce=K");
+        }
+    }
+    size_t notify_len = 0;
+    if (args.count("notify") != 0)
+    {
+        long value = std::stol(args.at("notify"));
+        if (value < 0)
+        {
+            throw std::runtime_error("!notify: " + args.at("notify") + ", samples >= 0");
+        }
+        notify_len = (size_t)value;
+    }
+    if ((overflow == FOBOS_OVERFLOW_SPILL) && (trigger_level > 0.0f))
+    {
+        // the block power of the spilled slots is not kept
+        throw std::runtime_error("!overflow: spill is not available with trigger_level");
+    }
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    if (_streams.empty())
+    {
+        // the first stream sets up the ring shared by all the streams
+        if (!_net_args.empty() && (_net == nullptr))
+        {
+            _net = soapy_fobos_net_create(_net_args);
+        }
+        if (args.count("buf_count") != 0)
+        {
+            _rx_buffs_count = std::max((size_t)std::stoul(args.at("buf_count")), (size_t)MIN_BUFS_COUNT);
+        }
+        _rx_bufs = new uint8_t* [_rx_buffs_count];
+        // any transfer length of transfer_len() fits
+        size_t slot_bytes = _rx_slot_cap * fobos_ring_sample_bytes(_ring_format);
+        if (_ring_format != FOBOS_RING_CF32)
+        {
+            _rx_stage = new float [_rx_slot_cap * 2];
+        }
+        _rx_mix = new float [_rx_slot_cap * 2];
+        // interp <= decim, one more for the output phase
+        _rx_resampled = new float [(_rx_slot_cap + 1) * 2];
+        if (_pipeline == nullptr)
+        {
+            _pipeline = new SoapyFobosPipeline(_dsp_threads);
+            _chunk_stats.resize(_pipeline->max_chunks());
+        }
+        _rx_power = new float [_rx_buffs_count * (_rx_slot_cap / TRIGGER_BLOCK_LEN)];
+        _rx_noise_floor = 0.0f;
+        if (!_shm_name.empty())
+        {
+            // other processes read the same slots with "driver=fobos,shm=NAME"
+            try
+            {
+                _shm = soapy_fobos_shm_create(_shm_name, _rx_buffs_count, _rx_slot_cap, _ring_format, serial);
+            }
+            catch (...)
+            {
+                // e.g. exported by another process, nothing is set up
+                delete [] _rx_bufs;
+                _rx_bufs = nullptr;
+                ring_free();
+                throw;
+            }
+            for (unsigned int i = 0; i < _rx_buffs_count; i++)
+            {
+                _rx_bufs[i] = (uint8_t*)_shm->slot_data(i);
+            }
+            _rx_slots = _shm->slots;
+            soapy_fobos_shm_set(_shm->header->sample_rate, _sample_rate);
+            soapy_fobos_shm_set(_shm->header->frequency, _center_frequency);
+        }
+        else
+        {
+            for (unsigned int i = 0; i < _rx_buffs_count; i++)
+            {
+                _rx_bufs[i] = new uint8_t [slot_bytes];
+            }
+            _rx_slots = new SoapyFobosSlot [_rx_buffs_count];
+        }
+    }
+    SoapyFobosStream * st = new SoapyFobosStream(format, decimation);
+    if (_direct_sampling)
+    {
+        st->hf = real_format ? FOBOS_HF_REAL : FOBOS_HF_COMPLEX;
+        st->channels = stream_channels;
+        st->halfbands.resize(stream_channels.size());
+    }
+    if (trigger_level > 0.0f)
+    {
+        st->trigger_ratio = powf(10.0f, trigger_level / 10.0f);
+        st->hangover = TRIGGER_BLOCK_LEN * 16;
+        if (args.count("pretrigger") != 0)
+        {
+            // older samples may be overwritten already
+            st->pretrigger = std::min((size_t)std::stoul(args.at("pretrigger")), (_rx_buffs_count - 2) * _rx_slot_cap);
+        }
+        if (args.count("hangover") != 0)
+        {
+            st->hangover = std::stoul(args.at("hangover"));
+        }
+        _rx_triggers++;
+    }
+    st->overflow = overflow;
+    st->wait = wait;
+    st->coalesce = coalesce;
+    if (overflow == FOBOS_OVERFLOW_SPILL)
+    {
+        st->spill_max = DEFAULT_SPILL_SLOTS;
+        if (args.count("spill_slots") != 0)
+        {
+            st->spill_max = std::stoul(args.at("spill_slots"));
+        }
+        std::lock_guard<std::mutex> spill_lock(_spill_mutex);
+        _spill_streams.push_back(st);
+        _spill_count = _spill_streams.size();
+    }
+    if (notify_len > 0)
+    {
+        try
+        {
+            notify_open(st);
+        }
+        catch (...)
+        {
+            if (overflow == FOBOS_OVERFLOW_SPILL)
+            {
+                std::lock_guard<std::mutex> spill_lock(_spill_mutex);
+                _spill_streams.pop_back();
+                _spill_count = _spill_streams.size();
+            }
+            if (st->trigger_ratio > 0.0f)
+            {
+                _rx_triggers--;
+            }
+            delete st;
+            throw;
+        }
+        st->notify_len = notify_len;
+        std::lock_guard<std::mutex> notify_lock(_notify_mutex);
+        _notify_streams.push_back(st);
+        _rx_notifies++;
+    }
+    _streams.push_back(st);
+    return (SoapySDR::Stream *) st;
+}
+
+//Typically setup/close should handle lengthy allocation and cleanup procedures
+void SoapyFobosSDR::closeStream(SoapySDR::Stream *stream)
+{
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
+#endif 
+    SoapyFobosStream * st = (SoapyFobosStream *) stream;
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    auto it = std::find(_streams.begin(), _streams.end(), st);
+    if (it == _streams.end())
+    {
+        return;
+    }
+    if (st->active)
+    {
+        st->active = false;
+        _streams_active--;
+    }
+    _streams.erase(it);
+    if (st->trigger_ratio > 0.0f)
+    {
+        _rx_triggers--;
+    }
+    if (st->overflow == FOBOS_OVERFLOW_SPILL)
+    {
+        std::lock_guard<std::mutex> spill_lock(_spill_mutex);
+        _spill_streams.erase(std::find(_spill_streams.begin(), _spill_streams.end(), st));
+        _spill_count = _spill_streams.size();
+    }
+    if (st->notify_len > 0)
+    {
+        std::lock_guard<std::mutex> notify_lock(_notify_mutex);
+        _notify_streams.erase(std::find(_notify_streams.begin(), _notify_streams.end(), st));
+        _rx_notifies--;
+        notify_close(st);
+    }
+    delete st;
+    if (_streams_active == 0)
+    {
+        rx_stop();
+    }
+    if (_streams.empty())
+    {
+        ring_free();
+    }
+}
+
+void SoapyFobosSDR::ring_free(void)
+{
+    delete [] _rx_power;
+    _rx_power = nullptr;
+    delete [] _rx_stage;
+    _rx_stage = nullptr;
+    delete [] _rx_mix;
+    _rx_mix = nullptr;
+    delete [] _rx_resampled;
+    _rx_resampled = nullptr;
+    soapy_fobos_net_close(_net);
+    _net = nullptr;
+    if (_shm)
+    {
+        delete [] _rx_bufs;
+        _rx_bufs = nullptr;
+        _rx_slots = nullptr;
+        soapy_fobos_shm_close(_shm);
+        _shm = nullptr;
+        return;
+    }
+    if (_rx_bufs)
+    {
+        for (unsigned int i = 0; i < _rx_buffs_count; i++)
+        {
+            if (_rx_bufs[i])
+            {
+                delete [] _rx_bufs[i];
+            }
+        }
+        delete [] _rx_bufs;
+    }
+    _rx_bufs = nullptr;
+    delete [] _rx_slots;
+    _rx_slots = nullptr;
+}
+
+size_t SoapyFobosSDR::getStreamMTU(SoapySDR::Stream *stream) const
+{
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s()\n", __CLASS__, __FUNCTION__);
+#endif     
+    const SoapyFobosStream * st = (const SoapyFobosStream *) stream;
+    size_t factor = st->factor();
+    return (_rx_slot_len + factor - 1) / factor;
+}
+
+// Starts the async thread, must be called with _streams_mutex locked
+void SoapyFobosSDR::rx_start(void)
+{
+    if (_rx_async_thread.joinable())
+    {
+        // has stopped on its own
+        _rx_async_thread.join();
+    }
+    if (_streams_active == 0)
+    {
+        _rx_seq_w = 0;
+        {
+            std::lock_guard<std::mutex> lock(_rx_mutex);
+            _rx_seq_done = 0;
+            _rx_pos_done = 0;
+        }
+        _rx_ring_pos = 0;
+    }
+    // else the streams still reading the last run (a finite one that has
+    // ended) keep their cursors, the ring goes on after its last slot
+    _rx_seq_start = _rx_seq_done;
+    _rx_pos_start = _rx_ring_pos;
+    _buff_counter = 0;
+    _rx_in_pos = 0;
+    resampler_update();
+    size_t interp;
+    size_t decim;
+    {
+        std::lock_guard<std::mutex> lock(_ctrl_mutex);
+        _rx_rate_epoch = _ctrl_rate_epoch.load();
+        _rx_rate = _sample_rate;
+        interp = _resample_interp;
+        decim = _resample_decim;
+    }
+    _rx_native = _rx_rate * decim / interp;
+    _rx_rate_counter = 0;
+    _rx_rate_time_ns = 0;
+    _rx_rate_in = 0;
+    _rx_counter_ns = 0;
+    _rx_restart = false;
+    _rx_restarted = false;
+    _rx_buff_len = transfer_len(_rx_native);
+    _rx_slot_len = slot_len_for(_rx_buff_len, interp, decim);
+    _rx_fill = 0;
+    if (_history_seconds > 0.0)
+    {
+        // the history of the last run stays for the snapshots until now,
+        // a snapshot still writing it keeps its own reference
+        std::lock_guard<std::mutex> lock(_snap_mutex);
+        if (_history && (_history->slot_len == _rx_slot_len) && (_history->sample_rate == _rx_rate) &&
+            (_history.use_count() == 1))
+        {
+            _history->seq_w = 0;
+            _history->seq_done = 0;
+        }
+        else
+        {
+            _history.reset();
+            _history = std::shared_ptr<SoapyFobosHistory>(soapy_fobos_history_create(_history_seconds,
+                    _rx_rate, _rx_slot_len, _history_format), soapy_fobos_history_close);
+        }
+    }
+    _running = true;
+    _overruns_count = 0;
+    _lost_samples = 0;
+    _rx_pushed = 0;
+    _rx_wakeups = 0;
+    _pipeline->reset_timing();
+    _rx_start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    _rx_epoch_ns = 0;
+    _rx_stop_at = 0;
+    {
+        std::lock_guard<std::mutex> lock(_stats_mutex);
+        _stats_count = 0;
+    }
+    if (_shm)
+    {
+        // the clients see the new generation and start over
+        _shm->header->state = FOBOS_SHM_STOPPED;
+        _shm->header->seq_w = _rx_seq_w.load();
+        _shm->header->seq_done = _rx_seq_done.load();
+        _shm->header->slot_len = (uint32_t)_rx_slot_len;
+        _shm->header->generation++;
+        soapy_fobos_shm_set(_shm->header->sample_rate, _rx_rate);
+        _shm->header->state = FOBOS_SHM_RUNNING;
+    }
+    // from the first slot on
+    correlator_start();
+    _rx_async_thread = std::thread(&SoapyFobosSDR::rx_async_thread_loop, this);
+}
+
+void SoapyFobosSDR::rx_stop(void)
+{
+    if (_rx_async_thread.joinable())
+    {
+        _rx_stopping = true;
+        rx_cancel();
+        {
+            // the transfers restarted by a rate change after this cancel are canceled again
+            std::unique_lock<std::mutex> lock(_rx_mutex);
+            while (_running)
+            {
+                if ((_rx_cond.wait_for(lock, std::chrono::milliseconds(RX_STOP_POLL_MS)) == std::cv_status::timeout) && _running)
+                {
+                    lock.unlock();
+                    rx_cancel();
+                    lock.lock();
+                }
+            }
+        }
+        _rx_async_thread.join();
+        _rx_stopping = false;
+    }
+    if (_shm)
+    {
+        _shm->header->state = FOBOS_SHM_STOPPED;
+    }
+    _rx_cond.notify_all();
+    // a new run may have another rate, the recording ends here
+    record_stop();
+    correlator_stop();
+    if (_rx_notifies > 0)
+    {
+        // the event loops find the end of the stream
+        std::lock_guard<std::mutex> lock(_notify_mutex);
+        for (auto st : _notify_streams)
+        {
+            st->notify_at = UINT64_MAX;
+            notify_signal(st);
+        }
+    }
+}
+
+// The transfers stop by themselves once every active stream is finite and
+// has got its last sample. Must be called with _streams_mutex locked.
+void SoapyFobosSDR::update_stop_at(void)
+{
+    uint64_t stop_at = 0;
+    for (auto st : _streams)
+    {
+        if (!st->active)
+        {
+            continue;
+        }
+        if (!st->finite)
+        {
+            stop_at = 0;
+            break;
+        }
+        stop_at = std::max(stop_at, st->end_pos);
+    }
+    _rx_stop_at = stop_at;
+}
+
+// activate/deactivate may be called multiple times and should be lightweight on and off switches
+// SOAPY_SDR_END_BURST with numElems: finite acquisition of numElems samples,
+// SOAPY_SDR_HAS_TIME: starting at the sample with timeNs time stamp.
+int SoapyFobosSDR::activateStream(
+        SoapySDR::Stream *stream,
+        const int flags,
+        const long long timeNs,
+        const size_t numElems)
+{
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s(%d, %lld, %d)\n", __CLASS__, __FUNCTION__, flags, timeNs, (int)numElems);
+#endif     
+    if ((flags & ~(SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST)) != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    if ((flags & SOAPY_SDR_END_BURST) && (numElems == 0))
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    SoapyFobosStream * st = (SoapyFobosStream *) stream;
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    if (st->active)
+    {
+        return 0;
+    }
+    if ((_streams_active == 0) || !_running)
+    {
+        rx_start();
+    }
+    // a stream joining a running device starts with the next buffer
+    {
+        std::lock_guard<std::mutex> rx_lock(_rx_mutex);
+        st->seq_r = _rx_seq_done;
+        st->base_r = _rx_pos_done;
+    }
+    st->pos_r = 0;
+    st->start_pos = 0;
+    if (flags & SOAPY_SDR_HAS_TIME)
+    {
+        // from the ring if the time has passed, as long as it is still there,
+        // the slots before it are passed over by readStream()
+        // nor from the last run, its time stamps start over
+        uint64_t seq_w = _rx_seq_w;
+        uint64_t oldest = std::max(seq_w - std::min(seq_w, (uint64_t)_rx_buffs_count - 2), _rx_seq_start);
+        uint64_t seq = st->seq_r;
+        while ((seq > oldest) && (_rx_slots[(seq - 1) % _rx_buffs_count].time_ns(0) > timeNs))
+        {
+            seq--;
+        }
+        if (seq > oldest)
+        {
+            // in slot seq - 1 or after it, the ticks at its rate
+            const SoapyFobosSlot slot = _rx_slots[(seq - 1) % _rx_buffs_count];
+            long long ticks = SoapySDR::timeNsToTicks(timeNs - slot.rate_time_ns, slot.rate) - (slot.counter - slot.rate_counter);
+            st->start_pos = slot.pos + (uint64_t)std::max(ticks, 0LL);
+            if (st->start_pos < slot.pos + slot.len)
+            {
+                st->seq_r = seq - 1;
+                st->base_r = slot.pos;
+                st->pos_r = (size_t)(st->start_pos - slot.pos);
+            }
+        }
+        else if (seq < st->seq_r)
+        {
+            // older than the ring keeps
+            st->seq_r = seq;
+            st->base_r = _rx_slots[seq % _rx_buffs_count].pos;
+        }
+        else
+        {
+            // nothing written yet, the ring positions lag the time stamps by the pushed samples
+            double rate;
+            {
+                std::lock_guard<std::mutex> ctrl_lock(_ctrl_mutex);
+                rate = _sample_rate;
+            }
+            long long ticks = SoapySDR::timeNsToTicks(timeNs, rate) - (long long)_rx_pushed;
+            st->start_pos = _rx_pos_start + (uint64_t)std::max(ticks, 0LL);
+        }
+    }
+    st->gain_epoch = _ctrl_gain_epoch;
+    // a stream starting in the ring takes the rate of its first slot without a flag
+    st->rate_epoch = (st->seq_r < _rx_seq_done) ? _rx_slots[st->seq_r % _rx_buffs_count].rate_epoch : _rx_rate_epoch.load();
+    st->reset_dsp();
+    st->triggered = false;
+    st->scan_seq = st->seq_r;
+    st->scan_base = st->base_r;
+    st->scan_pos = st->base_r;
+    st->scan_min = st->scan_pos;
+    st->finite = (flags & SOAPY_SDR_END_BURST) != 0;
+    st->remaining = numElems;
+    st->end_pos = std::max(st->start_pos, st->base_r) + (uint64_t)numElems * st->factor();
+    st->spill_pos = st->seq_r;
+    {
+        std::lock_guard<std::mutex> spill_lock(st->spill_mutex);
+        while (!st->spill.empty())
+        {
+            st->spill_free.push_back(std::move(st->spill.front().data));
+            st->spill.pop_front();
+        }
+    }
+    st->active = true;
+    _streams_active++;
+    update_stop_at();
+    notify_arm(st);
+    return 0;
+}
+
+// activate / deactivate may be called multiple times and should be lightweight on and off switches
+int SoapyFobosSDR::deactivateStream(SoapySDR::Stream *stream, const int flags, const long long timeNs)
+{
+    (void)timeNs;
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+    printf(">>> %s::%s(%d, %lld)\n", __CLASS__, __FUNCTION__, flags, timeNs);
+#endif     
+    if (flags != 0)
+    {
+        return SOAPY_SDR_NOT_SUPPORTED;
+    }
+    SoapyFobosStream * st = (SoapyFobosStream *) stream;
+    std::lock_guard<std::mutex> lock(_streams_mutex);
+    if (!st->active)
+    {
+        return 0;
+    }
+    st->active = false;
+    _streams_active--;
+    if (_streams_active == 0)
+    {
+        rx_stop();
+    }
+    else
+    {
+        update_stop_at();
+    }
+    return 0;
+}
+
+// The slot being read by st has been (or is being) overwritten
+bool SoapyFobosSDR::slot_lost(const SoapyFobosStream *st) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return st->seq_r + _rx_buffs_count <= _rx_seq_w.load(std::memory_order_relaxed);
+}
+
+// Triggered stream: checks the power blocks not checked yet, moves the
+// cursor over the silence and back by the pre-trigger history when the
+// level is crossed. Returns how many samples from the cursor belong to
+// the segment and have been checked, 0 - nothing to deliver yet.
+size_t SoapyFobosSDR::trigger_gate(SoapyFobosStream *st, uint64_t seq_done)
+{
+    const size_t blocks_max = _rx_slot_cap / TRIGGER_BLOCK_LEN;     // per slot of _rx_power
+    while ((st->scan_seq < seq_done) && !(st->triggered && (st->scan_pos >= st->segment_end)))
+    {
+        size_t idx = st->scan_seq % _rx_buffs_count;
+        size_t len = _rx_slots[idx].len;
+        size_t block = (st->scan_pos - st->scan_base) / TRIGGER_BLOCK_LEN;
+        float power = _rx_power[idx * blocks_max + std::min(block, blocks_max - 1)];
+        float floor = _rx_slots[idx].noise_floor;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (st->scan_seq + _rx_buffs_count <= _rx_seq_w.load(std::memory_order_relaxed))
+        {
+            // overwritten, readStream() reports the overflow
+            break;
+        }
+        if (block >= len / TRIGGER_BLOCK_LEN)
+        {
+            // the next slot, the end of a short one is not checked
+            st->scan_seq++;
+            st->scan_base += len;
+            st->scan_pos = st->scan_base;
+            continue;
+        }
+        if (power > floor * st->trigger_ratio)
+        {
+            if (!st->triggered)
+            {
+                // the slot the pre-trigger history starts in, as far back as the ring has
+                uint64_t start = st->scan_pos - std::min((uint64_t)st->pretrigger, st->scan_pos - st->scan_min);
+                uint64_t seq_w = _rx_seq_w.load();
+                uint64_t oldest = seq_w - std::min(seq_w, (uint64_t)_rx_buffs_count - 2);
+                uint64_t seq = st->scan_seq;
+                uint64_t base = st->scan_base;
+                while ((seq > oldest) && (base > start))
+                {
+                    seq--;
+                    base = _rx_slots[seq % _rx_buffs_count].pos;
+                }
+                st->seq_r = seq;
+                st->base_r = base;
+                st->pos_r = (size_t)(std::max(start, base) - base);
+                st->reset_dsp();
+                st->triggered = true;
+            }
+            st->segment_end = st->scan_pos + TRIGGER_BLOCK_LEN + st->hangover;
+        }
+        st->scan_pos += TRIGGER_BLOCK_LEN;
+    }
+    if (!st->triggered)
+    {
+        // nothing but silence up to here
+        st->seq_r = st->scan_seq;
+        st->base_r = st->scan_base;
+        st->pos_r = (size_t)(st->scan_pos - st->scan_base);
+        return 0;
+    }
+    uint64_t read_pos = st->base_r + st->pos_r;
+    return std::min(st->scan_pos, st->segment_end) - read_pos;
+}
+
+int SoapyFobosSDR::readStream(
+        SoapySDR::Stream *stream,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    SoapyFobosStream * st = (SoapyFobosStream *) stream;
+    int result = read_stream(st, buffs, numElems, flags, timeNs, timeoutUs);
+    if (st->notify_len > 0)
+    {
+        notify_arm(st);
+    }
+    return result;
+}
+
+int SoapyFobosSDR::read_stream(
+        SoapyFobosStream *st,
+        void * const *buffs,
+        const size_t numElems,
+        int &flags,
+        long long &timeNs,
+        const long timeoutUs)
+{
+    SoapySDR::Stream *stream = (SoapySDR::Stream *) st;
+    flags = 0;
+    if (!st->active)
+    {
+#ifdef SOAPY_FOBOS_PRINT_DEBUG        
+        printf("^%d ", (int)numElems);
+#endif
+        return 0;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+    size_t factor = st->factor();
+    size_t produced = 0;
+    while (produced == 0)
+    {
+        uint64_t target = st->seq_r + 1;
+        if ((st->wait == FOBOS_WAIT_COALESCE) && (st->seq_r >= _rx_seq_done.load(std::memory_order_acquire)))
+        {
+            // nothing left to read: sleep until a batch of slots is there,
+            // no more than the request takes, nor than the ring keeps
+            size_t slots = (st->pos_r + numElems * factor + _rx_slot_len - 1) / _rx_slot_len;
+            slots = std::min(std::min(slots, st->coalesce), _rx_buffs_count - 2);
+            target = st->seq_r + std::max(slots, (size_t)1);
+        }
+        uint64_t seq_done = rx_wait(st, target, deadline);
+        if (st->seq_r >= seq_done)
+        {
+            if (!_running)
+            {
+                // stopped, the ring has been read up to the end
+                return 0;
+            }
 #ifdef SOAPY_FOBOS_PRINT_DEBUG        
-        printf("u");
+            printf("u");
 #endif        
+            return SOAPY_SDR_TIMEOUT;
+        }
+        const SoapyFobosSpillSlot* spilled = nullptr;
+        bool lapped = slot_lost(st);
+        if (lapped && (st->overflow == FOBOS_OVERFLOW_SPILL))
+        {
+            // the slot may have been copied aside before it was overwritten
+            spilled = spill_front(st);
+            lapped = (spilled == nullptr) || (spilled->seq != st->seq_r);
+        }
+        if (lapped)
+        {
+            // lapped by the writer: skip to the slot the policy says,
+            // the next call returns samples with the new time
+            uint64_t seq_r = _rx_seq_w.load() - _rx_buffs_count + 2;
+            if (spilled)
+            {
+                // the spill buffer has been full for a while
+                seq_r = spilled->seq;
+            }
+            else if (st->overflow == FOBOS_OVERFLOW_LATEST)
+            {
+                seq_r = seq_done - 1;
+            }
+            seq_r = std::min(std::max(seq_r, st->seq_r + 1), seq_done - 1);
+            uint64_t base = (spilled && (spilled->seq == seq_r)) ? spilled->slot.pos : _rx_slots[seq_r % _rx_buffs_count].pos;
+            uint64_t lost = base - std::min(base, st->base_r + st->pos_r);
+            st->overruns += seq_r - st->seq_r;
+            st->lost += lost;
+            _overruns_count += (uint32_t)(seq_r - st->seq_r);
+            _lost_samples += lost;
+            st->seq_r = seq_r;
+            st->spill_pos = seq_r;
+            st->base_r = base;
+            st->pos_r = 0;
+            st->reset_dsp();
+            if (st->trigger_ratio > 0.0f)
+            {
+                st->triggered = false;
+                st->scan_seq = seq_r;
+                st->scan_base = base;
+                st->scan_pos = base;
+                st->scan_min = base;
+            }
+#ifdef SOAPY_FOBOS_PRINT_DEBUG  
+            printf("#");
+            fflush(stdout);
+#endif          
+            return SOAPY_SDR_OVERFLOW;
+        }
+        if (st->base_r + st->pos_r < st->start_pos)
+        {
+            // activated with SOAPY_SDR_HAS_TIME ahead of the ring, passed over up to the time
+            size_t len = spilled ? spilled->slot.len : _rx_slots[st->seq_r % _rx_buffs_count].len;
+            st->pos_r += (size_t)std::min((uint64_t)(len - std::min((size_t)len, st->pos_r)), st->start_pos - (st->base_r + st->pos_r));
+            if (st->pos_r >= len)
+            {
+                st->pos_r = 0;
+                st->base_r += len;
+                st->seq_r++;
+                st->spill_pos.store(st->seq_r, std::memory_order_relaxed);
+                if (spilled)
+                {
+                    spill_pop(st);
+                }
+            }
+            continue;
+        }
+        size_t gate = SIZE_MAX;
+        if (st->trigger_ratio > 0.0f)
+        {
+            gate = trigger_gate(st, seq_done);
+            if (gate == 0)
+            {
+                // silence skipped, or the rest of the segment is not checked yet
+                continue;
+            }
+        }
+        size_t requested = numElems;
+        if (st->finite)
+        {
+            requested = (size_t)std::min((uint64_t)numElems, st->remaining);
+        }
+        size_t idx = st->seq_r % _rx_buffs_count;
+        const SoapyFobosSlot slot = spilled ? spilled->slot : _rx_slots[idx];
+        size_t available = std::min((size_t)slot.len - std::min((size_t)slot.len, st->pos_r), gate);
+        if (slot.rate_epoch != st->rate_epoch)
+        {
+            // the filters do not carry samples of the old rate over
+            st->reset_dsp();
+        }
+        const uint8_t* ring_data = spilled ? spilled->data.data() : _rx_bufs[idx];
+        const float* src_buff = (const float*)ring_data + st->pos_r * 2;
+        bool direct = false;        // the samples are in buffs[0] already
+        if (_ring_format != FOBOS_RING_CF32)
+        {
+            // expanded while copying, as many as this call may consume
+            available = std::min(available, requested * st->factor());
+            if ((st->hf == FOBOS_HF_OFF) && (factor == 1) && (st->format == SOAPY_SDR_CF32))
+            {
+                fobos_ring_unpack(_ring_format, ring_data, st->pos_r, (float*)buffs[0], available);
+                direct = true;
+            }
+            else if ((st->hf == FOBOS_HF_OFF) && (factor == 1) && (st->format == SOAPY_SDR_CS16) && (_ring_format == FOBOS_RING_CS16))
+            {
+                memcpy(buffs[0], (const int16_t*)ring_data + st->pos_r * 2, available * 2 * sizeof(int16_t));
+                direct = true;
+            }
+            else
+            {
+                st->unpacked.resize(available * 2);
+                fobos_ring_unpack(_ring_format, ring_data, st->pos_r, st->unpacked.data(), available);
+                src_buff = st->unpacked.data();
+            }
+        }
+        size_t consumed;
+        const float* out_buff = src_buff;
+        if (st->hf == FOBOS_HF_REAL)
+        {
+            // raw HF1/HF2 samples are I/Q of the ring
+            produced = std::min(available, requested);
+            consumed = produced;
+            timeNs = slot.time_ns(st->pos_r);
+            for (size_t c = 0; c < st->channels.size(); c++)
+            {
+                const float* src = src_buff + st->channels[c];
+                if (st->format == SOAPY_SDR_F32)
+                {
+                    fobos_f32_copy(src, 2, (float*)buffs[c], produced);
+                }
+                else if (st->format == SOAPY_SDR_S16)
+                {
+                    fobos_f32_to_s16(src, 2, (int16_t*)buffs[c], produced);
+                }
+                else
+                {
+                    fobos_f32_to_s8(src, 2, (int8_t*)buffs[c], produced);
+                }
+            }
+        }
+        else if (st->hf == FOBOS_HF_COMPLEX)
+        {
+            // every channel consumes the same input, so produces as many
+            timeNs = slot.time_ns(st->pos_r + st->halfbands[0].input_for(1) - 1);
+            consumed = std::min(available, st->halfbands[0].input_for(requested));
+            if (st->format != SOAPY_SDR_CF32)
+            {
+                st->work.resize((consumed / 2 + 1) * 2);
+            }
+            for (size_t c = 0; c < st->channels.size(); c++)
+            {
+                float* dst = (st->format == SOAPY_SDR_CF32) ? (float*)buffs[c] : st->work.data();
+                produced = st->halfbands[c].process(src_buff + st->channels[c], 2, consumed, dst);
+                if (st->format == SOAPY_SDR_CS16)
+                {
+                    fobos_cf32_to_cs16(dst, (int16_t*)buffs[c], produced);
+                }
+                else if (st->format == SOAPY_SDR_CS8)
+                {
+                    fobos_cf32_to_cs8(dst, (int8_t*)buffs[c], produced);
+                }
+            }
+        }
+        else if (factor == 1)
+        {
+            produced = std::min(available, requested);
+            consumed = produced;
+            timeNs = slot.time_ns(st->pos_r);
+            if ((st->format == SOAPY_SDR_CF32) && !direct)
+            {
+                memcpy(buffs[0], src_buff, produced * 2 * sizeof(float));
+            }
+        }
+        else
+        {
+            // the first output is computed at the input sample input_for(1) - 1
+            timeNs = slot.time_ns(st->pos_r + st->decimator.input_for(1) - 1);
+            consumed = std::min(available, st->decimator.input_for(requested));
+            float* dst = (float*)buffs[0];
+            if (st->format != SOAPY_SDR_CF32)
+            {
+                st->work.resize((consumed / factor + 1) * 2);
+                dst = st->work.data();
+            }
+            produced = st->decimator.process(src_buff, consumed, dst);
+            out_buff = dst;
+        }
+        if ((st->hf == FOBOS_HF_OFF) && !direct)
+        {
+            if (st->format == SOAPY_SDR_CS16)
+            {
+                fobos_cf32_to_cs16(out_buff, (int16_t*)buffs[0], produced);
+            }
+            else if (st->format == SOAPY_SDR_CS8)
+            {
+                fobos_cf32_to_cs8(out_buff, (int8_t*)buffs[0], produced);
+            }
+        }
+        if ((spilled == nullptr) && slot_lost(st))
+        {
+            // overwritten while copying, the next pass reports the overflow
+            produced = 0;
+            continue;
+        }
+        if (slot.gain_epoch != st->gain_epoch)
+        {
+            flags |= FOBOS_FLAG_GAIN_CHANGED;
+            st->gain_epoch = slot.gain_epoch;
+        }
+        if (slot.rate_epoch != st->rate_epoch)
+        {
+            flags |= FOBOS_FLAG_RATE_CHANGED;
+            st->rate_epoch = slot.rate_epoch;
+        }
+        _rx_gain_read.store(slot.gain, std::memory_order_relaxed);
+        st->pos_r += consumed;
+        if (st->pos_r >= slot.len)
+        {
+            st->pos_r = 0;
+            st->base_r += slot.len;
+            st->seq_r++;
+            st->spill_pos.store(st->seq_r, std::memory_order_relaxed);
+            if (spilled)
+            {
+                spill_pop(st);
+            }
+        }
+        if (st->triggered && (st->base_r + st->pos_r >= st->segment_end))
+        {
+            // the hangover has passed without a new trigger
+            flags |= SOAPY_SDR_END_BURST;
+            st->triggered = false;
+            st->scan_min = st->segment_end;
+            break;
+        }
+        if (st->finite)
+        {
+            st->remaining -= produced;
+            if (st->remaining == 0)
+            {
+                flags |= SOAPY_SDR_END_BURST;
+                deactivateStream(stream);
+                break;
+            }
+        }
     }
-    return samples_count;
+    flags |= SOAPY_SDR_HAS_TIME;
+    return produced;
 }
 
+// Waits until the writer has completed slot target - 1, the transfers have
+// stopped or the deadline has passed, returns _rx_seq_done
+uint64_t SoapyFobosSDR::rx_wait(SoapyFobosStream *st, uint64_t target, std::chrono::steady_clock::time_point deadline)
+{
+    uint64_t seq_done = _rx_seq_done.load(std::memory_order_acquire);
+    if (seq_done >= target)
+    {
+        return seq_done;
+    }
+    if ((st->wait == FOBOS_WAIT_SPIN) || (st->wait == FOBOS_WAIT_HYBRID))
+    {
+        auto spin_end = deadline;
+        if (st->wait == FOBOS_WAIT_HYBRID)
+        {
+            spin_end = std::min(deadline, std::chrono::steady_clock::now() + std::chrono::microseconds(WAIT_SPIN_US));
+        }
+        do
+        {
+            fobos_cpu_relax();
+            seq_done = _rx_seq_done.load(std::memory_order_acquire);
+            if ((seq_done >= target) || !_running)
+            {
+                return seq_done;
+            }
+        }
+        while (std::chrono::steady_clock::now() < spin_end);
+        if (st->wait == FOBOS_WAIT_SPIN)
+        {
+            return seq_done;
+        }
+    }
+#ifdef SOAPY_FOBOS_PRINT_DEBUG        
+    printf("w");
+#endif
+    std::unique_lock<std::mutex> lock(_rx_mutex);
+    while (((seq_done = _rx_seq_done) < target) && _running)
+    {
+        _rx_wake_at = std::min(_rx_wake_at, target);
+        std::cv_status status = _rx_cond.wait_until(lock, deadline);
+        _rx_wakeups++;
+        if (status == std::cv_status::timeout)
+        {
+            seq_done = _rx_seq_done;
+            break;
+        }
+    }
+    return seq_done;
+}
+
+// Clears the descriptor of the stream and signals it again once notify_len
+// more samples of the stream are in the ring, at once if they are there
+void SoapyFobosSDR::notify_arm(SoapyFobosStream *st)
+{
+    if ((st->notify_len == 0) || !st->active)
+    {
+        return;
+    }
+    notify_clear(st);
+    uint64_t need = (uint64_t)st->notify_len * st->factor();
+    uint64_t slots = (st->pos_r + need + _rx_slot_len - 1) / _rx_slot_len;
+    uint64_t target = st->seq_r + std::min(std::max(slots, (uint64_t)1), (uint64_t)_rx_buffs_count - 2);
+    st->notify_at.store(target);
+    if (_rx_seq_done.load() >= target)
+    {
+        uint64_t at = target;
+        if (st->notify_at.compare_exchange_strong(at, UINT64_MAX))
+        {
+            notify_signal(st);
+        }
+    }
+}
+
+long long SoapyFobosSDR::stream_epoch_ns(void) const
+{
+    return _rx_epoch_ns;
+}
@@ -0,0 +1,58 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Throughput of the CS12Z codec (SoapyFobosCodec.hpp) on one core
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  19.10.2026 - initial
+//==============================================================================
+
+#include "SoapyFobosCodec.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// samples per run, 2 MB of CF32 stays in the cache as a ring slot does not
+#define BENCH_COUNT     (1 << 18)
+// the fastest of the runs, the others were disturbed
+#define BENCH_RUNS      50
+
+int main(void)
+{
+    std::vector<float> samples(BENCH_COUNT * 2);
+    std::vector<uint8_t> stream(fobos_z12_bound(BENCH_COUNT) + FOBOS_Z12_BLOCK_MAX);
+    std::vector<float> decoded(BENCH_COUNT * 2);
+    printf("noise rms   bits/component   encode MS/s   decode MS/s\n");
+    // a quiet band, a busy one and one near full scale
+    for (float rms : {0.005f, 0.02f, 0.1f})
+    {
+        std::mt19937 rng(12);
+        std::normal_distribution<float> noise(0.0f, rms);
+        for (auto &v : samples)
+        {
+            v = noise(rng);
+        }
+        double encode_s = 1e9;
+        double decode_s = 1e9;
+        size_t bytes = 0;
+        for (int run = 0; run < BENCH_RUNS; run++)
+        {
+            size_t consumed = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            bytes = fobos_z12_encode(samples.data(), BENCH_COUNT, stream.data(), fobos_z12_bound(BENCH_COUNT), consumed);
+            auto t1 = std::chrono::steady_clock::now();
+            if ((consumed != BENCH_COUNT) || (fobos_z12_decode(stream.data(), bytes, decoded.data(), BENCH_COUNT) != BENCH_COUNT))
+            {
+                printf("round trip failed\n");
+                return 1;
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            encode_s = std::min(encode_s, std::chrono::duration<double>(t1 - t0).count());
+            decode_s = std::min(decode_s, std::chrono::duration<double>(t2 - t1).count());
+        }
+        printf("%9.3f   %14.2f   %11.1f   %11.1f\n", rms, bytes * 8.0 / (BENCH_COUNT * 2),
+                BENCH_COUNT / encode_s * 1e-6, BENCH_COUNT / decode_s * 1e-6);
+    }
+    return 0;
+}
+//==============================================================================
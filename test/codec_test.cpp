@@ -0,0 +1,125 @@
+//==============================================================================
+//  SDR plugin wrapper for Fobos SDR API
+//  Round trip check of the CS12Z codec (SoapyFobosCodec.hpp)
+//  V.T.
+//  LGPL-2.1 or above LICENSE
+//  19.10.2026 - initial
+//==============================================================================
+
+#include "SoapyFobosCodec.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+static std::vector<uint8_t> encode(const std::vector<float> &samples, size_t capacity, size_t &consumed)
+{
+    std::vector<uint8_t> stream(capacity + FOBOS_Z12_BLOCK_MAX);
+    size_t bytes = fobos_z12_encode(samples.data(), samples.size() / 2, stream.data(), capacity, consumed);
+    stream.resize(bytes);
+    return stream;
+}
+
+// decodes back exactly the 12 bit samples
+static bool round_trip(const std::vector<float> &samples)
+{
+    size_t count = samples.size() / 2;
+    size_t consumed = 0;
+    std::vector<uint8_t> stream = encode(samples, fobos_z12_bound(count), consumed);
+    if ((consumed != count) || (fobos_z12_count(stream.data(), stream.size()) != count))
+    {
+        return false;
+    }
+    std::vector<float> decoded(count * 2);
+    if (fobos_z12_decode(stream.data(), stream.size(), decoded.data(), count) != count)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count * 2; i++)
+    {
+        if (decoded[i] != fobos_z12_quantise(samples[i]) * (1.0f / 2047.0f))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    // not a multiple of the block, the last one is short
+    const size_t count = 100 * FOBOS_Z12_BLOCK + 17;
+    srand(12);
+    std::vector<float> noise(count * 2);
+    for (auto &v : noise)
+    {
+        v = (rand() / (float)RAND_MAX - 0.5f) * 0.2f;
+    }
+    check(round_trip(noise), "random samples");
+
+    std::vector<float> full(count * 2);
+    for (auto &v : full)
+    {
+        v = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+    }
+    check(round_trip(full), "random samples at full scale");
+
+    std::vector<float> tone(count * 2);
+    for (size_t i = 0; i < count; i++)
+    {
+        tone[i * 2] = 0.7f * cosf(0.01f * i);
+        tone[i * 2 + 1] = 0.7f * sinf(0.01f * i);
+    }
+    check(round_trip(tone), "narrow band samples");
+
+    // beyond full scale, jumping from one limit to the other
+    std::vector<float> saturated(count * 2);
+    for (size_t i = 0; i < count * 2; i++)
+    {
+        saturated[i] = ((i / 3) & 1) ? 4.0f : -1.5f;
+    }
+    check(round_trip(saturated), "saturated samples");
+
+    size_t consumed = 0;
+    std::vector<uint8_t> stream = encode(noise, fobos_z12_bound(count), consumed);
+    std::vector<float> decoded(count * 2);
+    std::vector<uint8_t> damaged = stream;
+    damaged.resize(damaged.size() / 2);
+    check(fobos_z12_decode(damaged.data(), damaged.size(), decoded.data(), count) == 0, "truncated stream returns 0");
+    damaged = stream;
+    for (size_t i = damaged.size() / 2; i < damaged.size() / 2 + 8; i++)
+    {
+        damaged[i] = 0;
+    }
+    check(fobos_z12_decode(damaged.data(), damaged.size(), decoded.data(), count) == 0, "zeroed bits return 0");
+    check(fobos_z12_decode(stream.data(), stream.size(), decoded.data(), count - 1) == 0, "stream longer than dst returns 0");
+    check(fobos_z12_decode(stream.data(), 3, decoded.data(), count) == 0, "no header returns 0");
+
+    // whole blocks up to the capacity, they decode on their own
+    size_t capacity = stream.size() / 3;
+    std::vector<uint8_t> part = encode(noise, capacity, consumed);
+    check((consumed > 0) && (consumed < count) && (consumed % FOBOS_Z12_BLOCK == 0) && (part.size() <= capacity),
+            "encode stops at capacity");
+    bool same = (fobos_z12_decode(part.data(), part.size(), decoded.data(), count) == consumed);
+    for (size_t i = 0; same && (i < consumed * 2); i++)
+    {
+        same = (decoded[i] == fobos_z12_quantise(noise[i]) * (1.0f / 2047.0f));
+    }
+    check(same, "stream cut at capacity decodes");
+    encode(noise, FOBOS_Z12_HEADER + FOBOS_Z12_BLOCK_MAX, consumed);
+    check(consumed >= FOBOS_Z12_BLOCK, "one block at the smallest capacity");
+
+    return (failures == 0) ? 0 : 1;
+}
+//==============================================================================